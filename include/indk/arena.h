@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        indk/arena.h
+// Purpose:     Region allocator class header
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef INTERFERENCE_ARENA_H
+#define INTERFERENCE_ARENA_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+
+#define indk_ARENA_BLOCK_MIN 1024
+#define indk_ARENA_BLOCK_MAX 1048576
+
+namespace indk {
+    /// Region allocator. Objects are placed one after another in blocks that grow from indk_ARENA_BLOCK_MIN
+    /// to indk_ARENA_BLOCK_MAX bytes, so many small objects are allocated without heap calls and their memory
+    /// is released at once. Destructors are called by doDestroy, memory of the destroyed objects is reused only
+    /// after the arena is released.
+    class Arena {
+    private:
+        std::vector<std::pair<char*, uint64_t>> Blocks;
+        char *Current;
+        uint64_t Free, BlockSize, Size;
+    public:
+        Arena();
+        Arena(const indk::Arena&) = delete;
+        indk::Arena& operator=(const indk::Arena&) = delete;
+        void* doAllocate(uint64_t, uint64_t Alignment = alignof(std::max_align_t));
+        void doRelease();
+        uint64_t getSize() const;
+        uint64_t getCapacity() const;
+
+        /**
+         * Create object in the arena.
+         * @param args Constructor arguments.
+         * @return Pointer to the new object.
+         */
+        template <typename T, typename... Args> T* doCreate(Args&&... args) {
+            return new (doAllocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Destroy object created in the arena. The memory is not released.
+         * @param Object Pointer to the object.
+         */
+        template <typename T> static void doDestroy(T *Object) {
+            if (Object) Object -> ~T();
+        }
+        ~Arena();
+    };
+}
+
+#endif //INTERFERENCE_ARENA_H
@@ -13,8 +13,6 @@
 
 namespace indk {
     class ComputeBackendDefault : public Computer {
-    private:
-        indk::Position *dRPos, *nRPos, *zPos;
     public:
         ComputeBackendDefault();
         void doRegisterHost(const std::vector<void*>&) override;
@@ -12,37 +12,58 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <map>
+#include <unordered_map>
+#include <deque>
 #include <atomic>
+#include <exception>
 #include <indk/computer.h>
 
 #define indk_MULTITHREAD_DEFAULT_NUM 2
 
 namespace indk {
+    /// \private
+    typedef struct task {
+        void *object;
+        unsigned int worker;
+        std::atomic<int64_t> ready;
+    } Task;
+
     /// \private
     typedef struct worker {
-        std::vector<void*> objects;
+        std::deque<indk::Task*> tasks;
         std::thread thread;
-        void *event;
-        std::atomic<bool> done;
-        std::mutex m;
-        std::condition_variable cv;
-
     } Worker;
 
+    /// Dataflow compute backend. An object is queued as soon as all its inputs for a tick
+    /// are complete (doProcess is called by the object), ticks of the same object are computed
+    /// one after another. Each worker has its own task deque, idle workers steal tasks from
+    /// other workers and block while there is nothing to compute. The deques share one lock,
+    /// so queueing and taking a task costs one lock each.
     class ComputeBackendMultithread : public Computer {
     private:
         std::vector<indk::Worker*> Workers;
-        std::map<void*, unsigned int> ObjectTable;
+        std::unordered_map<void*, indk::Task*> ObjectTable;
+        std::function<void(void*)> Handler;
         unsigned int WorkerCount;
+        int64_t Queued, Idle;
+        std::atomic<int64_t> Outstanding;
+        std::mutex IdleMutex, DoneMutex;
+        std::condition_variable IdleCV, DoneCV;
+        std::exception_ptr Error;
+        bool Stopped;
 
-        [[noreturn]] static void tWorker(void*);
+        void doSchedule(indk::Task*);
+        indk::Task* doPop(unsigned int);
+        void doRun(indk::Task*);
+        static void tWorker(indk::ComputeBackendMultithread*, unsigned int);
     public:
         explicit ComputeBackendMultithread(int);
         void doRegisterHost(const std::vector<void*>&) override;
         void doUnregisterHost() override;
         void doWaitTarget() override;
         void doProcess(void*) override;
+        void setTaskHandler(const std::function<void(void*)>&) override;
+        ~ComputeBackendMultithread() override;
     };
 }
 
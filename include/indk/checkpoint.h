@@ -0,0 +1,87 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        indk/checkpoint.h
+// Purpose:     Checkpoint log class header
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef INTERFERENCE_CHECKPOINT_H
+#define INTERFERENCE_CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#define indk_CHECKPOINT_MAGIC "INDKCKP"
+#define indk_CHECKPOINT_VERSION 1
+#define indk_CHECKPOINT_COMPACTION 1
+
+namespace indk {
+    /// Append-only checkpoint log. The log begins with a snapshot record (the binary model image, see indk::Model)
+    /// followed by the records of the changes made after it: images of new or changed neurons, changed reference
+    /// scopes and names of deleted neurons. Records and their data are aligned to indk_MODEL_ALIGNMENT bytes,
+    /// so model images are opened in place. A record that was not completely written (for example, the process was
+    /// stopped during the checkpoint) ends the log. See indk::NeuralNet::doCheckpoint.
+    class Checkpoint {
+    public:
+        typedef struct {
+            char Magic[8];
+            uint32_t Version;
+            uint32_t ByteOrder;
+        } Header;
+
+        typedef struct {
+            uint32_t Type;
+            uint32_t Flags;
+            uint64_t Size;
+        } RecordHeader;
+
+        typedef enum {
+            /// Model image of the whole neural net.
+            SnapshotRecord = 1,
+            /// Model image of new or changed neurons, with the TopologyFlag the image also keeps
+            /// the neural net entries, outputs and ensembles.
+            NeuronsRecord,
+            /// Changed reference scopes, one ScopesHeader per neuron followed by the neuron name
+            /// and ScopesCount items of ScopeHeader with the scope position.
+            ScopesRecord,
+            /// Names of deleted neurons, every name is prefixed by its uint32_t size.
+            DeleteRecord,
+        } RecordTypes;
+
+        typedef enum {
+            TopologyFlag = 1,
+        } RecordFlags;
+
+        typedef struct {
+            uint32_t NameSize, ScopesCount, DimensionsCount, Reserved;
+        } ScopesHeader;
+
+        typedef struct {
+            uint32_t Receptor, Scope;
+        } ScopeHeader;
+
+        typedef struct {
+            uint32_t Type, Flags;
+            const char *Data;
+            uint64_t Size;
+        } Record;
+    private:
+        std::vector<uint64_t> Buffer;
+        std::vector<indk::Checkpoint::Record> Records;
+        uint64_t Size;
+    public:
+        Checkpoint();
+        explicit Checkpoint(const std::string&);
+        void doOpen(const std::string&);
+        static void doCreate(const std::string&);
+        static uint64_t doAppend(const std::string&, uint64_t, uint32_t, uint32_t, const void*, uint64_t);
+        static uint64_t getRecordSize(uint64_t);
+        const std::vector<indk::Checkpoint::Record>& getRecords() const;
+        uint64_t getSize() const;
+    };
+}
+
+#endif //INTERFERENCE_CHECKPOINT_H
@@ -10,6 +10,7 @@
 #define INTERFERENCE_COMPUTER_H
 
 #include <queue>
+#include <functional>
 #include <indk/position.h>
 
 namespace indk {
@@ -20,6 +21,7 @@ namespace indk {
         virtual void doUnregisterHost() = 0;
         virtual void doWaitTarget() = 0;
         virtual void doProcess(void*) = 0;
+        virtual void setTaskHandler(const std::function<void(void*)>&);
         static std::vector<float> doCompareCPFunction(std::vector<indk::Position*>, std::vector<indk::Position*>);
         static float doCompareCPFunctionD(std::vector<indk::Position*>, std::vector<indk::Position*>);
         static float doCompareFunction(indk::Position*, indk::Position*);
@@ -31,6 +33,7 @@ namespace indk {
         static float getLambdaValue(unsigned int);
         static float getFiVectorLength(float);
         static float getSynapticSensitivityValue(unsigned int, unsigned int);
+        virtual ~Computer() = default;
     };
 }
 
@@ -44,7 +44,17 @@ namespace indk {
             /// Not equal coordinates ranges.
             EX_POSITION_RANGES,
             /// Not equal space dimensions of positions.
-            EX_POSITION_DIMENSIONS
+            EX_POSITION_DIMENSIONS,
+            /// The asynchronous signal transfer was cancelled.
+            EX_NEURALNET_CANCELLED,
+            /// Error reading or writing the model file.
+            EX_MODEL_IO,
+            /// Invalid binary model image or unsupported image version.
+            EX_MODEL_FORMAT,
+            /// Error reading or writing the checkpoint log.
+            EX_CHECKPOINT_IO,
+            /// Invalid checkpoint log or unsupported log version.
+            EX_CHECKPOINT_FORMAT
         } Exceptions;
 
         Error();
@@ -54,6 +64,7 @@ namespace indk {
     private:
         ExceptionType ET;
         std::vector<float> ED;
+        mutable std::string Msg;
     };
 }
 
@@ -0,0 +1,55 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        indk/executor.h
+// Purpose:     Bounded async task executor class header
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef INTERFERENCE_EXECUTOR_H
+#define INTERFERENCE_EXECUTOR_H
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unordered_set>
+#include <unordered_map>
+
+namespace indk {
+    /// Fixed pool of threads with a bounded task queue. Tasks of the same owner are executed
+    /// one at a time in submission order, tasks of different owners run in parallel.
+    /// Submission blocks while the queue is full.
+    class Executor {
+    private:
+        typedef struct {
+            const void *Owner;
+            std::function<void()> Job;
+        } Task;
+
+        std::vector<std::thread> Workers;
+        std::deque<Task> Queue;
+        std::unordered_set<const void*> Active;
+        std::unordered_map<const void*, uint64_t> Pending;
+        std::mutex Lock;
+        std::condition_variable QueueCV, SpaceCV, DoneCV;
+        unsigned int QueueDepth;
+        bool Stop;
+
+        void doWork();
+    public:
+        Executor(unsigned int Threads, unsigned int QueueDepth);
+        Executor(const indk::Executor&) = delete;
+        void doSubmit(const void *Owner, const std::function<void()>& Job);
+        void doWait(const void *Owner);
+        bool isPending(const void *Owner);
+        unsigned int getThreadsCount() const;
+        unsigned int getQueueDepth() const;
+        ~Executor();
+    };
+}
+
+#endif //INTERFERENCE_EXECUTOR_H
@@ -0,0 +1,40 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        indk/kernel.h
+// Purpose:     CPU compute kernels header
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef INTERFERENCE_KERNEL_H
+#define INTERFERENCE_KERNEL_H
+
+#include <indk/neuron.h>
+
+namespace indk {
+    /// CPU compute kernels shared by the native compute backends.
+    /// The receptor-synapse interaction loop has scalar, SSE4.2 and AVX2
+    /// implementations, the best one supported by the CPU is selected at runtime.
+    /// Kernels are specialised for 2 and 3 dimensions and for every processing mode,
+    /// the neuron picks its kernel once with getProcessFunction(). With culling enabled
+    /// receptors only visit synapses from their neighbour lists. The receptor loop of large neurons
+    /// can be split between threads (see setReceptorParallelism), receptor contributions to the
+    /// output are summed in receptor order, so the result does not depend on the thread count.
+    class Kernel {
+    public:
+        typedef float (*InteractionFunction)(const indk::Neuron::Store*, const float*, float*);
+        typedef indk::Neuron::ProcessFunction ProcessFunction;
+
+        static ProcessFunction getProcessFunction(unsigned int, int, bool Culling = false);
+        static float doInteract(const indk::Neuron::Store*, const float*, float*);
+        static void setInstructionSet(int);
+        static void setReceptorParallelism(unsigned int, uint64_t);
+        static int getInstructionSet();
+        static int getSupportedInstructionSet();
+        static unsigned int getReceptorThreads();
+        static uint64_t getReceptorWorkThreshold();
+    };
+}
+
+#endif //INTERFERENCE_KERNEL_H
@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        indk/model.h
+// Purpose:     Binary model image class header
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef INTERFERENCE_MODEL_H
+#define INTERFERENCE_MODEL_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#define indk_MODEL_MAGIC "INDKMDL"
+#define indk_MODEL_VERSION 2
+#define indk_MODEL_BYTE_ORDER 0x01020304
+#define indk_MODEL_ALIGNMENT 64
+#define indk_MODEL_STRIDE_STEP 16
+
+namespace indk {
+    /// Binary model image. The image keeps the neural net topology, synapse geometry, receptor default positions
+    /// and all learned reference scopes in flat arrays, so it is loaded without parsing: the file is mapped
+    /// to memory and the arrays are read in place. Sections are addressed by byte offsets from the beginning
+    /// of the image and aligned to indk_MODEL_ALIGNMENT bytes. Strings are stored once in the string table
+    /// and referenced by ID. Synapse positions and Lambda values use the layout of indk::Neuron::Store
+    /// (one row of SynapsesStride values per dimension, SynapsesStride is a multiple of indk_MODEL_STRIDE_STEP), receptor positions are receptor-major,
+    /// reference scopes use the layout of the scope matrix of indk::Neuron::Store (one row of ScopesStride values per receptor and dimension).
+    /// The image uses the byte order of the host that wrote it.
+    /// Neurons can be attached to the opened image (see indk::NeuralNet::doAttachModel), in this case the learned
+    /// geometry is used in place and the memory of the image is shared between all processes that attach the same file.
+    class Model {
+    public:
+        typedef struct {
+            char Magic[8];
+            uint32_t Version;
+            uint32_t ByteOrder;
+            uint64_t Size;
+            uint64_t Name, Description, ModelVersion;
+            uint64_t EntriesCount, Entries;
+            uint64_t OutputsCount, Outputs;
+            uint64_t NeuronsCount, Neurons;
+            uint64_t EnsemblesCount, Ensembles;
+            uint64_t StringsCount, Strings, StringsData;
+        } Header;
+
+        /// Neuron record. Latency is used only if the neuron has the LatencyFlag set.
+        /// Synapses are stored in the order of their storage indexes, SynapseEntry keeps the entry index of every synapse.
+        /// ReceptorScopes keeps the count of scopes of every receptor, ScopePos keeps ReceptorsCount*DimensionsCount rows
+        /// of ScopesStride values (the stride is not less than the count of scopes of every receptor).
+        typedef struct {
+            uint64_t Name;
+            int64_t Latency;
+            uint32_t Xm, DimensionsCount;
+            int32_t ProcessingMode, OutputMode;
+            uint32_t Flags, Reserved;
+            uint64_t EntriesCount, Entries;
+            uint64_t SynapsesCount, SynapsesStride;
+            uint64_t SynapsePos, SynapseLambda, SynapseEntry, SynapseType, SynapseK1, SynapseK2, SynapseTl;
+            uint64_t ReceptorsCount, ReceptorPos0, ReceptorK3;
+            uint64_t ScopesStride, ReceptorScopes, ScopePos;
+        } NeuronRecord;
+
+        /// Ensemble record. Members is the array of neuron name IDs.
+        typedef struct {
+            uint64_t Name, MembersCount, Members;
+        } EnsembleRecord;
+
+        typedef enum {
+            LatencyFlag = 1,
+        } NeuronFlags;
+
+        /// Builder of the binary model image.
+        class Builder {
+        private:
+            std::vector<char> Data;
+            std::vector<std::string> Strings;
+            std::unordered_map<std::string, uint64_t> StringIndex;
+            std::vector<indk::Model::NeuronRecord> Neurons;
+            std::vector<indk::Model::EnsembleRecord> Ensembles;
+            std::vector<uint64_t> Entries, Outputs;
+            uint64_t Name, Description, ModelVersion;
+        public:
+            Builder();
+            uint64_t doAddString(const std::string&);
+            uint64_t doAddSection(const void*, uint64_t);
+            void doAddEntry(const std::string&);
+            void doAddOutput(const std::string&);
+            void doAddNeuron(const indk::Model::NeuronRecord&);
+            void doAddEnsemble(const std::string&, const std::vector<std::string>&);
+            const std::vector<char>& doBuild();
+            void doWrite(const std::string&);
+            void setName(const std::string&, const std::string&, const std::string&);
+        };
+    private:
+        const char *Data;
+        uint64_t Size;
+        void *Mapping;
+        uint64_t MappingSize;
+        std::vector<uint64_t> Buffer;
+
+        void doCheck();
+        const void* getSection(uint64_t, uint64_t, uint64_t ElementSize = 1) const;
+    public:
+        Model();
+        explicit Model(const std::string&);
+        Model(const indk::Model&) = delete;
+        indk::Model& operator=(const indk::Model&) = delete;
+        void doOpen(const std::string&);
+        void doOpen(const void*, uint64_t);
+        void doClose();
+        static bool isModel(const std::string&);
+        static void doConvertToBinary(const std::string&, const std::string&);
+        static void doConvertToJSON(const std::string&, const std::string&);
+        static uint64_t getCount(uint64_t, uint64_t, uint64_t Extra = 0);
+        const indk::Model::Header* getHeader() const;
+        const indk::Model::NeuronRecord* getNeuron(uint64_t) const;
+        const indk::Model::EnsembleRecord* getEnsemble(uint64_t) const;
+        std::string getString(uint64_t) const;
+        std::vector<std::string> getStrings(uint64_t, uint64_t) const;
+        bool isMapped() const;
+        bool isOpen() const;
+        uint64_t getSize() const;
+
+        /**
+         * Get typed array of the image section.
+         * @param Offset Section offset.
+         * @param Count Count of elements.
+         * @return Pointer to the first element.
+         */
+        template <typename T> const T* getArray(uint64_t Offset, uint64_t Count) const {
+            return (const T*)getSection(Offset, Count, sizeof(T));
+        }
+        ~Model();
+    };
+}
+
+#endif //INTERFERENCE_MODEL_H
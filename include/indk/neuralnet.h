@@ -11,13 +11,24 @@
 #define INTERFERENCE_NEURALNET_H
 
 #include <map>
+#include <list>
 #include <algorithm>
 #include <tuple>
 #include <functional>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <atomic>
 #include <indk/neuron.h>
 #include <indk/system.h>
 #include <indk/interlink.h>
+#include <indk/signal.h>
+#include <indk/model.h>
+#include <indk/checkpoint.h>
+
+#define indk_SIGNAL_WINDOW 64
+#define indk_STRUCTURE_BATCH 256
 
 namespace indk {
     typedef enum {
@@ -29,35 +40,169 @@ namespace indk {
     typedef std::vector<std::pair<std::string, std::vector<std::string>>> EntryList;
     typedef std::pair<float, std::string> OutputValue;
 
+    /// Input signal delivery step of the execution plan. Entries are referenced by index in the target neuron,
+    /// neurons are referenced by index in the plan neuron list. Port is the input port of the target neuron
+    /// used by the dataflow backends.
+    typedef struct {
+        uint64_t Input;
+        uint64_t To;
+        int64_t Entry;
+        uint64_t Port;
+        std::vector<int64_t> ZeroEntries;
+    } ExecutionEntry;
+
+    /// Link step of the execution plan. Neurons are referenced by index in the plan neuron list.
+    typedef struct {
+        uint64_t From, To;
+        int64_t Entry;
+        uint64_t Port;
+        int64_t Shift;
+        bool Initial;
+    } ExecutionLink;
+
+    /// Compiled execution plan. Links are stored in topological order of their
+    /// source neurons, links that read the previous tick output (Shift = 1) go first.
+    /// Outputs keeps the outgoing links of every neuron for the dataflow backends.
+    /// Every input step and link has its own port in the target neuron (Ports keeps the entry of every port),
+    /// signals are written to the port slot of the tick in Inbox and counted by the atomic Ready counter of the
+    /// tick, the neuron is scheduled by the sender of its last signal and moves the signals to its entries itself.
+    /// Next is the next tick of every neuron.
+    typedef struct {
+        std::vector<indk::Neuron*> Neurons;
+        std::unordered_map<indk::Neuron*, uint64_t> Index;
+        std::vector<std::vector<uint64_t>> Outputs;
+        std::vector<std::vector<int64_t>> Ports;
+        std::vector<uint64_t> InboxOffset;
+        std::vector<float> Inbox;
+        std::unique_ptr<std::atomic<uint32_t>[]> Ready;
+        std::vector<int64_t> Next;
+        std::vector<uint64_t> FanIn;
+        std::vector<indk::ExecutionEntry> Entries;
+        std::vector<indk::ExecutionLink> Links;
+        bool Acyclic;
+    } ExecutionPlan;
+
+    /// Residency index of the lazily attached model (see indk::NeuralNet::doAttachModel). Records keeps the image
+    /// record of every neuron, Links keeps the output links of every neuron, Owners keeps the ensemble that owns the neuron.
+    /// Residency is tracked per ensemble, Resident keeps the resident ensembles from the most to the least recently used.
+    /// Learned and culling settings are applied to the neurons on materialisation.
+    typedef struct {
+        const indk::Model *Image;
+        std::unordered_map<std::string, uint64_t> Records;
+        std::unordered_map<std::string, std::vector<std::string>> Links;
+        std::unordered_map<std::string, std::string> Owners;
+        std::list<std::string> Resident;
+        std::unordered_map<std::string, std::list<std::string>::iterator> ResidentIndex;
+        uint64_t Limit;
+        bool Learned;
+        float CullingEpsilon, CullingSkin;
+    } ModelResidency;
+
+    /// Checkpointed state of the neuron. Structure is the hash of everything but the reference scopes,
+    /// Scopes keeps the hashes of the reference scopes of all receptors, ScopesCount keeps the count of scopes of every receptor.
+    typedef struct {
+        uint64_t Structure;
+        std::vector<uint64_t> Scopes;
+        std::vector<uint64_t> ScopesCount;
+    } NeuronCheckpoint;
+
+    /// State of the checkpoint log (see indk::NeuralNet::doCheckpoint). Size is the end of the log, SnapshotSize is
+    /// the size of its snapshot record. The log is compacted when the records appended after the snapshot exceed
+    /// Compaction times the snapshot size.
+    typedef struct {
+        std::string Path;
+        uint64_t Topology;
+        std::unordered_map<std::string, indk::NeuronCheckpoint> Neurons;
+        uint64_t Size, SnapshotSize;
+        float Compaction;
+    } CheckpointState;
+
+    /// Result of one sample of the batch recognition: output signals and pattern difference values of the output neurons.
+    typedef struct {
+        std::vector<indk::OutputValue> Outputs;
+        std::vector<float> Patterns;
+    } RecognitionResult;
+
+    /**
+     * Handle of the asynchronous signal transfer.
+     */
+    class AsyncTransfer {
+    private:
+        std::shared_future<std::vector<indk::OutputValue>> Result;
+        std::shared_ptr<std::atomic<bool>> Cancelled;
+    public:
+        AsyncTransfer() = default;
+        AsyncTransfer(std::shared_future<std::vector<indk::OutputValue>>, std::shared_ptr<std::atomic<bool>>);
+        void doCancel();
+        void doWait() const;
+        std::vector<indk::OutputValue> getResult() const;
+        bool isReady() const;
+        bool isCancelled() const;
+    };
+
     /**
      * Main neural net class.
      */
     class NeuralNet {
     private:
         std::string Name, Description, Version;
-        int64_t t;
+        int64_t t, TransferEnd;
 
         EntryList Entries;
         std::map<std::string, std::vector<std::string>> Ensembles;
         std::map<std::string, indk::Neuron*> Neurons;
         std::map<std::string, int> Latencies;
         std::vector<std::string> Outputs;
+        std::vector<indk::Neuron*> OutputTable;
+        std::unordered_map<std::string, uint64_t> OutputIndex;
+        std::map<std::string, std::vector<uint64_t>> EnsembleOutputs;
+        bool OutputTableValid;
 
         std::map<std::string, std::vector<std::string>> StateSyncList;
 
         int64_t doFindEntry(const std::string&);
         void doParseLinks(const EntryList&, const std::string&);
-        void doSignalProcessStart(const std::vector<std::vector<float>>&, const EntryList&);
+        void doBuildExecutionPlan(const EntryList&);
+        uint64_t doExecutePlan(bool);
+        void doExecuteTask(indk::Neuron*);
+        void doDeliver(uint64_t, uint64_t, float, int64_t);
+        void doSignalProcessStart(const indk::SignalMatrix&, uint64_t, uint64_t);
         void doSyncNeuronStates(const std::string&);
+        void doBuildOutputTable();
+        void doBuildModel(const indk::Model&, bool, bool);
+        void doClearStructure();
+        indk::Neuron* doMaterialiseNeuron(const std::string&);
+        void doMaterialiseModel();
+        void doEvictEnsembles();
+        void doBuildImage(indk::Model::Builder&, const std::vector<std::string>&, bool);
+        void doLinkStructure();
+        void doUpdateCheckpointState();
+        uint64_t doHashTopology();
 
         indk::LinkList Links;
+        indk::ExecutionPlan Plan;
         std::string PrepareID;
         bool StateSyncEnabled;
         int LastUsedComputeBackend;
 
+        std::atomic<bool> *TransferCancel;
+        std::vector<std::shared_ptr<indk::Executor>> AsyncExecutors;
+        std::mutex AsyncLock;
+
         indk::Interlink *InterlinkService;
         std::vector<std::vector<std::string>> InterlinkDataBuffer;
 
+        std::shared_ptr<indk::Runtime> BoundRuntime, ActiveRuntime;
+        std::shared_ptr<indk::Model> AttachedModel;
+        indk::ModelResidency Residency;
+        indk::CheckpointState CheckpointLog;
+
+        NeuralNet(const indk::NeuralNet*, const std::shared_ptr<indk::Runtime>&);
+        indk::AsyncTransfer doSubmitAsync(const std::function<std::vector<indk::OutputValue>()>&, const std::function<void(std::vector<indk::OutputValue>)>&);
+        indk::Computer* getComputeBackend();
+        int getComputeBackendKind();
+        int getComputeBackendParameter();
+
     public:
         NeuralNet();
         explicit NeuralNet(const std::string &path);
@@ -80,12 +225,20 @@ namespace indk {
         void doPrepare();
         void doStructurePrepare();
         std::vector<indk::OutputValue> doSignalTransfer(const std::vector<std::vector<float>>& X, const std::vector<std::string>& inputs = {});
-        void doSignalTransferAsync(const std::vector<std::vector<float>>&, const std::function<void(std::vector<indk::OutputValue>)>& Callback = nullptr, const std::vector<std::string>& inputs = {});
+        std::vector<indk::OutputValue> doSignalTransfer(const indk::SignalMatrix& X, const std::vector<std::string>& inputs = {});
+        void doSignalSend(const indk::SignalMatrix& X, const std::vector<std::string>& inputs = {});
+        indk::AsyncTransfer doSignalTransferAsync(const std::vector<std::vector<float>>&, const std::function<void(std::vector<indk::OutputValue>)>& Callback = nullptr, const std::vector<std::string>& inputs = {});
         std::vector<indk::OutputValue> doLearn(const std::vector<std::vector<float>>&, bool prepare = true, const std::vector<std::string>& inputs = {});
+        std::vector<indk::OutputValue> doLearn(const indk::SignalMatrix&, bool prepare = true, const std::vector<std::string>& inputs = {});
         std::vector<indk::OutputValue> doRecognise(const std::vector<std::vector<float>>&, bool prepare = true, const std::vector<std::string>& inputs = {});
-        void doLearnAsync(const std::vector<std::vector<float>>&, const std::function<void(std::vector<indk::OutputValue>)>& Callback = nullptr, bool prepare = true, const std::vector<std::string>& inputs = {});
-        void doRecogniseAsync(const std::vector<std::vector<float>>&, const std::function<void(std::vector<indk::OutputValue>)>& Callback = nullptr, bool prepare = true, const std::vector<std::string>& inputs = {});
+        std::vector<indk::OutputValue> doRecognise(const indk::SignalMatrix&, bool prepare = true, const std::vector<std::string>& inputs = {});
+        std::vector<indk::RecognitionResult> doRecogniseBatch(const std::vector<std::vector<std::vector<float>>>& Samples, const std::vector<std::string>& inputs = {}, unsigned int Threads = 0);
+        indk::AsyncTransfer doLearnAsync(const std::vector<std::vector<float>>&, const std::function<void(std::vector<indk::OutputValue>)>& Callback = nullptr, bool prepare = true, const std::vector<std::string>& inputs = {});
+        indk::AsyncTransfer doRecogniseAsync(const std::vector<std::vector<float>>&, const std::function<void(std::vector<indk::OutputValue>)>& Callback = nullptr, bool prepare = true, const std::vector<std::string>& inputs = {});
+        void doWaitAsync();
         std::vector<indk::OutputValue> doSignalReceive(const std::string& ensemble = "");
+        void doSignalReceive(float *Y, int64_t Tick = -1);
+        void doSignalReceive(float *Y, const std::vector<uint64_t>& OutputIDs, int64_t Tick = -1);
         indk::Neuron* doReplicateNeuron(const std::string& from, const std::string& to, bool integrate);
         void doDeleteNeuron(const std::string& name);
         void doReplicateEnsemble(const std::string& From, const std::string& To, bool CopyEntries = false);
@@ -93,18 +246,36 @@ namespace indk {
         void doClearCache();
         void setStructure(std::ifstream&);
         void setStructure(const std::string &Str);
+        void setStructure(const indk::Model&);
+        void doLoadModel(const std::string& Path);
+        void doSaveModel(const std::string& Path);
+        void doAttachModel(const std::string& Path, bool Lazy = false);
+        void doCheckpoint(const std::string& Path);
+        void doCompactCheckpoint(const std::string& Path);
+        void doLoadCheckpoint(const std::string& Path);
+        void setCheckpointCompaction(float Ratio);
         void setLearned(bool);
         void setStateSyncEnabled(bool enabled = true);
+        void setCulling(float Epsilon, float Skin = 0);
+        void setRuntime(const std::shared_ptr<indk::Runtime>& NetRuntime);
+        void setResidentEnsemblesLimit(uint64_t Limit);
         bool isLearned();
+        bool isAttached() const;
         std::string getStructure(bool minimized = true);
         std::string getName();
         std::string getDescription();
         std::string getVersion();
         std::vector<indk::Neuron*> getEnsemble(const std::string&);
+        std::shared_ptr<indk::Runtime> getRuntime();
+        int64_t getOutputID(const std::string&);
+        uint64_t getOutputsCount() const;
+        int getOutputLatency(uint64_t OutputID) const;
+        const std::vector<uint64_t>& getEnsembleOutputs(const std::string&);
         indk::Neuron* getNeuron(const std::string&);
         std::vector<indk::Neuron*> getNeurons();
         uint64_t getNeuronCount();
         int64_t getSignalBufferSize();
+        uint64_t getResidentEnsemblesCount() const;
         ~NeuralNet();
     };
 }
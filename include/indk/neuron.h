@@ -14,10 +14,15 @@
 #include <vector>
 #include <atomic>
 #include <map>
+#include <memory>
 #include <iostream>
 #include <indk/position.h>
+#include <indk/model.h>
+#include <indk/arena.h>
 
 namespace indk {
+    class Computer;
+
     typedef enum {
         ProcessMin,
         ProcessAverage,
@@ -26,10 +31,14 @@ namespace indk {
     typedef unsigned int TopologyID;
 
     class Neuron {
+    public:
+        class Store;
+        typedef void (*ProcessFunction)(indk::Neuron*);
     private:
         class Entry;
         class Synapse;
         class Receptor;
+        indk::Neuron::Store *Storage;
         std::vector<std::pair<std::string, indk::Neuron::Entry*>> Entries;
         std::vector<std::string> Links;
         std::vector<indk::Neuron::Receptor*> Receptors;
@@ -39,10 +48,20 @@ namespace indk {
         float *OutputSignal;
         int64_t OutputSignalSize;
         int64_t OutputSignalPointer;
+        std::vector<float> TrajectoryPos;
+        std::vector<int64_t> TrajectoryTicks;
+        uint64_t TrajectoryCapacity, TrajectoryPointer;
         int NID, ProcessingMode, OutputMode;
+        int64_t PendingTick, PendingCount;
         bool Learned;
         std::vector<float> OutputsPredefined;
         std::string Name;
+        ProcessFunction ProcessKernel;
+        indk::Computer *Backend;
+
+        void doBindStore();
+        void doSelectKernel();
+        void doCaptureTrajectory();
     public:
         /**
          * Neuron states.
@@ -82,22 +101,38 @@ namespace indk {
 
         typedef std::tuple<float, int> PatternDefinition;
 
+        /**
+         * Captured receptor trajectory. Every record keeps the positions of all receptors at the tick
+         * (Stride values, receptor-major), records are ordered from the oldest to the newest.
+         */
+        typedef struct {
+            uint64_t Stride;
+            std::vector<int64_t> Ticks;
+            std::vector<float> Positions;
+        } Trajectory;
+
         Neuron();
         Neuron(const indk::Neuron&);
         Neuron(unsigned int, unsigned int, int64_t, const std::vector<std::string>& InputSignals);
+        Neuron(const indk::Model&, uint64_t);
+        indk::Neuron* doCreateContext() const;
         void doCreateNewSynapse(const std::string&, std::vector<float>, float, int64_t, int);
         void doCreateNewSynapseCluster(const std::vector<float>& PosVector, unsigned R, float k1, int64_t Tl, int NT);
         void doCreateNewReceptor(std::vector<float>);
         void doCreateNewReceptorCluster(const std::vector<float>& PosVector, unsigned R, unsigned C);
         bool doSignalSendEntry(const std::string&, float, int64_t);
+        bool doSignalSendEntry(int64_t, float, int64_t);
         std::pair<int64_t, float> doSignalReceive(int64_t tT = -1);
         void doFinalizeInput(float);
+        void doProcess();
         void doPrepare();
         void doFinalize();
         void doCreateNewScope(float output = 0);
         void doChangeScope(uint64_t);
         void doReset();
+        std::vector<float> doCompareScopes() const;
         indk::Neuron::PatternDefinition doComparePattern(int ProcessingMethod = indk::ScopeProcessingMethods::ProcessMin) const;
+        std::vector<indk::Neuron::PatternDefinition> doComparePatternTop(uint64_t) const;
         void doLinkOutput(const std::string&);
         void doClearOutputLinks();
         void doClearEntries();
@@ -106,11 +141,14 @@ namespace indk {
         void doReplaceEntryName(const std::string&, const std::string&);
         void doReserveSignalBuffer(int64_t);
         void setTime(int64_t);
+        void setTrajectoryCapture(uint64_t);
         void setEntries(const std::vector<std::string>& inputs);
         void setLambda(float);
         void setk1(float);
         void setk2(float);
         void setk3(float);
+        void setCulling(float Epsilon, float Skin = 0);
+        void setComputeBackend(indk::Computer*);
         void setNID(int);
         void setProcessingMode(int);
         void setOutputMode(int);
@@ -121,7 +159,9 @@ namespace indk {
         std::vector<std::string> getEntries() const;
         indk::Neuron::Entry*  getEntry(int64_t) const;
         indk::Neuron::Receptor* getReceptor(int64_t) const;
+        indk::Neuron::Store* getStore() const;
         std::vector<std::string> getWaitingEntries();
+        int64_t getEntryIndex(const std::string&) const;
         int64_t getEntriesCount() const;
         unsigned int getSynapsesCount() const;
         int64_t getReceptorsCount() const;
@@ -132,6 +172,8 @@ namespace indk {
         int getNID() const;
         std::string getName();
         int64_t getSignalBufferSize() const;
+        uint64_t getTrajectoryCapture() const;
+        indk::Neuron::Trajectory getTrajectory() const;
         int getState(int64_t) const;
         int getProcessingMode() const;
         int getOutputMode() const;
@@ -147,9 +189,11 @@ namespace indk {
         int64_t SignalPointer;
     public:
         Entry();
-        Entry(const indk::Neuron::Entry&);
+        Entry(const indk::Neuron::Entry&, indk::Neuron::Store*, bool ShareGeometry = false);
         bool doCheckState(int64_t) const;
-        void doAddSynapse(indk::Position*, unsigned int, float, int64_t, int);
+        void doAddSynapse(indk::Neuron::Store*, const indk::Position*, float, int64_t, int);
+        void doAttachSynapse(indk::Neuron::Store*, uint64_t, float, float, int64_t, int);
+        void doBindStore();
         void doIn(float, int64_t);
         void doProcess();
         void doPrepare();
@@ -167,20 +211,20 @@ namespace indk {
 
     class Neuron::Synapse {
     private:
+        indk::Neuron::Store *Storage;
+        uint64_t SID;
         indk::Position* SPos;
         float ok1, ok2, k1, k2;
-        float Lambda;
         int NeurotransmitterType;
         int64_t Tl;
-        float Gamma, dGamma;
         float lGamma, ldGamma;
         long long QCounter;
         std::vector<float> GammaQ;
         std::atomic<int64_t> QSize;
     public:
-        Synapse();
-        Synapse(const indk::Neuron::Synapse&);
-        Synapse(indk::Position*, float, float, int64_t, int);
+        Synapse(const indk::Neuron::Synapse&, indk::Neuron::Store*, bool ShareGeometry = false);
+        Synapse(indk::Neuron::Store*, uint64_t, float, int64_t, int);
+        void doBindStore();
         void doIn(float);
         void doSendToQueue(float, float);
         bool doInFromQueue(int64_t);
@@ -200,12 +244,14 @@ namespace indk {
         float getdGamma() const;
         int getNeurotransmitterType() const;
         int64_t getQSize();
-        ~Synapse() = default;
+        uint64_t getSID() const;
+        ~Synapse();
     };
 
     class Neuron::Receptor {
     private:
-        std::vector<indk::Position*> CP, CPf;
+        indk::Neuron::Store *Storage;
+        uint64_t RID;
         //indk::Position *RPos, *RPos0, *RPosf;
         std::vector<indk::Position*> ReferencePos;
         indk::Position* DefaultPos;
@@ -216,10 +262,14 @@ namespace indk {
         float L, Lf;
         float Fi, dFi;
         uint64_t Scope;
+        mutable uint64_t ScopesGeneration;
+
+        void doBindScopes() const;
+        void doDetachScopes();
     public:
-        Receptor();
-        Receptor(const indk::Neuron::Receptor&);
-        Receptor(indk::Position*, float);
+        Receptor(const indk::Neuron::Receptor&, indk::Neuron::Store*, bool ShareGeometry = false);
+        Receptor(indk::Neuron::Store*, uint64_t, float, int64_t ScopesCount = -1);
+        void doBindStore();
         bool doCheckActive() const;
         void doLock();
         void doUnlock();
@@ -227,19 +277,20 @@ namespace indk {
         void doChangeScope(uint64_t);
         void doReset();
         void doPrepare();
-        void doSavePos();
         void doUpdateSensitivityValue();
         void doUpdatePos(indk::Position*);
+        float doMove(const float*, float);
         void setPos(indk::Position*);
+        void doAttachScopes(uint64_t);
+        void setReferencePos(uint64_t, const float*);
         void setRs(float);
         void setk3(float);
         void setFi(float);
-        std::vector<indk::Position*> getCP() const;
-        std::vector<indk::Position*> getCPf() const;
         indk::Position* getPos() const;
         indk::Position* getPos0() const;
         indk::Position* getPosf() const;
-        std::vector<indk::Position*> getReferencePosScopes();
+        const std::vector<indk::Position*>& getReferencePosScopes() const;
+        uint64_t getScopesCount() const;
         float getRs() const;
         float getk3() const;
         float getFi();
@@ -248,7 +299,100 @@ namespace indk {
         bool isLocked() const;
         float getL() const;
         float getLf() const;
-        ~Receptor() = default;
+        uint64_t getRID() const;
+        ~Receptor();
+    };
+
+    /// Packed per-neuron storage. Keeps synapse coordinates in structure-of-arrays
+    /// layout (one aligned row per dimension) next to the Lambda, Gamma and dGamma
+    /// values, and receptor default and phantom positions as aligned
+    /// receptor-major arrays. Synapse and receptor positions are views over this storage.
+    /// With culling enabled, the store also keeps a uniform grid over the synapse positions
+    /// and per-receptor neighbour lists, so the kernels skip negligible synapse-receptor pairs.
+    /// A context store shares synapse positions, Lambda values, default receptor positions and the scope matrix
+    /// with its source store and keeps its own Gamma, dGamma and phantom receptor positions. The shared arrays are
+    /// reference-counted: a store that changes a shared array copies it first, so the source can change its structure
+    /// while contexts exist and every context keeps the geometry it was created with.
+    /// An attached store reads the learned geometry (including the scope matrix) from external arrays (the mapped
+    /// binary model image), the external arrays are never written and are copied on the first change.
+    /// Reference scopes of all receptors are kept in one scope matrix: every receptor has DimensionsCount rows
+    /// of ScopesCapacity values (one value per scope), so a receptor position is compared with all scopes
+    /// in a single pass (see doCompareScopes).
+    /// Entries, synapses, receptors and their position views are created in the store arena, reference scopes
+    /// and their coordinates are created in the scope arena, so the memory of the neuron structure is released
+    /// at once with the store (and the scope arena on the neuron reset).
+    class Neuron::Store {
+    private:
+        unsigned int Xm, DimensionsCount;
+        uint64_t SynapsesCount, SynapsesCapacity;
+        uint64_t ReceptorsCount, ReceptorsCapacity;
+        float *SynapsePos;
+        float *Lambda;
+        float *Gamma;
+        float *dGamma;
+        float *ReceptorPos0;
+        float *ReceptorPosf;
+        float *ScopePos;
+        std::shared_ptr<float> SynapsePosBuffer, LambdaBuffer, ReceptorPos0Buffer, ScopePosBuffer;
+        std::vector<uint64_t> FreeSynapses;
+        uint64_t ScopesCapacity, ScopesGeneration;
+        bool Relocated;
+        bool ExternalSynapses, ExternalReceptors, ExternalScopes;
+
+        float CullingEpsilon, CullingSkin, CullingRadius;
+        bool IndexValid;
+        std::map<std::vector<int64_t>, std::vector<uint32_t>> Grid;
+        std::vector<std::vector<uint32_t>> Neighbours;
+        std::vector<float> NeighboursAnchor;
+        std::vector<char> NeighboursValid;
+        indk::Arena Objects, Scopes;
+
+        void doReserveSynapses(uint64_t);
+        void doReserveReceptors(uint64_t);
+        bool isSynapsesShared() const;
+        bool isReceptorsShared() const;
+        bool isScopesShared() const;
+        void doBuildIndex();
+        void doBuildNeighbours(uint64_t, const float*);
+        std::vector<int64_t> getCell(const float*) const;
+    public:
+        Store(unsigned int, unsigned int);
+        Store(const indk::Neuron::Store&) = delete;
+        explicit Store(const indk::Neuron::Store*);
+        Store(unsigned int, unsigned int, uint64_t, uint64_t, const float*, const float*, uint64_t, const float*, uint64_t, const float*);
+        uint64_t doAddSynapse(const indk::Position*, float);
+        uint64_t doAddReceptor(const indk::Position*);
+        void doReserveScopes(uint64_t);
+        void doCompareScopes(uint64_t, uint64_t, float*) const;
+        void doReleaseSynapse(uint64_t);
+        void doReleaseSynapses();
+        void doClearRelocated();
+        void doInvalidateIndex();
+        void doUpdateIndex();
+        void setCulling(float, float);
+        void setLambda(uint64_t, float);
+        bool isRelocated() const;
+        bool isCullingEnabled() const;
+        const std::vector<uint32_t>& getNeighbours(uint64_t, const float*);
+        float getCullingEpsilon() const;
+        float getCullingSkin() const;
+        float* getSynapsePos(unsigned int) const;
+        float* getLambda() const;
+        float* getGamma() const;
+        float* getdGamma() const;
+        float* getReceptorPos0(uint64_t) const;
+        float* getReceptorPosf(uint64_t) const;
+        float* getScopePos(uint64_t, uint64_t) const;
+        uint64_t getScopesCapacity() const;
+        uint64_t getScopesGeneration() const;
+        uint64_t getSynapsesCount() const;
+        uint64_t getSynapsesCapacity() const;
+        uint64_t getReceptorsCount() const;
+        unsigned int getXm() const;
+        unsigned int getDimensionsCount() const;
+        indk::Arena* getArena();
+        indk::Arena* getScopeArena();
+        ~Store();
     };
 }
 
@@ -18,18 +18,24 @@ namespace indk {
     /// Object position class. Provides the ability to store Cartesian
     /// coordinates of object positions in n-dimensional space,
     /// and also allows you to perform basic arithmetic operations on them:
-    /// add, subtract, multiply, and divide.
+    /// add, subtract, multiply, and divide. A position can either own its
+    /// coordinates or be a view over coordinates stored elsewhere (for example,
+    /// in the packed per-neuron store), in which case values are read with a stride.
     class Position {
     private:
         unsigned int Xm;
         unsigned int DimensionsCount;
+        unsigned int Stride;
         float *X;
+        bool View;
     public:
         Position();
         Position(const indk::Position&);
         Position(unsigned int, unsigned int);
         Position(unsigned int, std::vector<float>);
+        Position(unsigned int, unsigned int, float*, unsigned int Stride = 1);
         void doAdd(const indk::Position*);
+        void doAdd(const float*);
         void doSubtract(const indk::Position*);
         void doDivide(float);
         void doMultiply(float);
@@ -39,10 +45,14 @@ namespace indk {
         void setPosition(std::vector<float>);
         void setDimensionsCount(unsigned int);
         void setXm(unsigned int);
+        void setData(float*, unsigned int Stride = 1);
         unsigned int getDimensionsCount() const;
         unsigned int getXm() const;
         float getPositionValue(unsigned int) const;
+        void getPositionValues(float*) const;
         float getDistanceFrom(const indk::Position*);
+        float getDistanceFrom(const float*) const;
+        bool isView() const;
         indk::Position& operator= (const indk::Position&);
 
         static float getDistance(const indk::Position&, const indk::Position&);
@@ -0,0 +1,38 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        indk/runtime.h
+// Purpose:     Compute runtime class header
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef INTERFERENCE_RUNTIME_H
+#define INTERFERENCE_RUNTIME_H
+
+#include <mutex>
+#include <indk/computer.h>
+
+namespace indk {
+    /// Compute backend instance that neural nets can be bound to (see indk::NeuralNet::setRuntime).
+    /// Several neural nets can share one runtime: transfers of the multithread and OpenCL backends
+    /// are serialised by the runtime lock, the default backend has no shared state and is not locked.
+    /// Neural nets that are not bound to a runtime use the global runtime (see indk::System::setComputeBackend).
+    class Runtime {
+    private:
+        indk::Computer *Backend;
+        int BackendKind, BackendParameter;
+        std::mutex Lock;
+    public:
+        explicit Runtime(int Backend = 0, int Parameter = 0);
+        Runtime(const indk::Runtime&) = delete;
+        std::mutex& getLock();
+        indk::Computer* getComputeBackend() const;
+        int getComputeBackendKind() const;
+        int getComputeBackendParameter() const;
+        bool isSynchronizationNeeded() const;
+        ~Runtime();
+    };
+}
+
+#endif //INTERFERENCE_RUNTIME_H
@@ -0,0 +1,57 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        indk/session.h
+// Purpose:     Streaming session class header
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef INTERFERENCE_SESSION_H
+#define INTERFERENCE_SESSION_H
+
+#include <vector>
+#include <functional>
+#include <indk/neuralnet.h>
+
+#define indk_SESSION_CAPACITY 1024
+
+namespace indk {
+    /// Streaming session of the neural net. Input frames are pushed one or several at a time, the neural net
+    /// keeps its state between the pushes. Output frame of the input frame `k` is ready when the tick `k + latency`
+    /// of every output neuron is computed (see getOutputLatency), so outputs of the neurons with latency are aligned
+    /// with the input frames they belong to. Ready frames are passed to the callback or kept in the bounded queue
+    /// until they are pulled, the oldest frames are dropped when the queue is full.
+    /// The session is not thread safe, the neural net must not be used by other calls while the session is active.
+    class Session {
+    public:
+        typedef std::function<void(int64_t Frame, const float *Y)> FrameCallback;
+    private:
+        indk::NeuralNet *Net;
+        std::vector<std::string> Inputs;
+        uint64_t OutputsCount, Capacity, Columns;
+        int64_t Time, MaxLatency;
+        std::vector<int64_t> Latencies;
+        std::vector<float> History;
+        std::vector<float> Ready;
+        std::vector<int64_t> ReadyFrames;
+        uint64_t ReadyFirst, ReadyCount, Dropped;
+        std::vector<float> Frame;
+        FrameCallback Callback;
+
+        void doCollect(int64_t);
+    public:
+        explicit Session(indk::NeuralNet *NN, bool Learning = false, const std::vector<std::string>& inputs = {}, uint64_t Capacity = indk_SESSION_CAPACITY);
+        void doPush(const indk::SignalMatrix& X);
+        void doPush(const std::vector<float>& X);
+        bool doPull(int64_t &FrameID, float *Y);
+        void doFlush();
+        void setCallback(const FrameCallback& Callback);
+        uint64_t getReadyCount() const;
+        uint64_t getDroppedCount() const;
+        uint64_t getOutputsCount() const;
+        int64_t getTime() const;
+    };
+}
+
+#endif //INTERFERENCE_SESSION_H
@@ -0,0 +1,38 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        indk/signal.h
+// Purpose:     Input signal matrix view class header
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef INTERFERENCE_SIGNAL_H
+#define INTERFERENCE_SIGNAL_H
+
+#include <vector>
+#include <cstdint>
+
+namespace indk {
+    /// Read-only view over input signals: one row per tick, one column per input (entry).
+    /// The view does not own the data, rows are read in place during the signal transfer,
+    /// so the data must stay valid until the transfer is done.
+    class SignalMatrix {
+    private:
+        const float *Data;
+        std::vector<const float*> RowTable;
+        uint64_t Rows, Columns, Stride;
+    public:
+        SignalMatrix();
+        SignalMatrix(const float *Data, uint64_t Rows, uint64_t Columns, uint64_t Stride = 0);
+        SignalMatrix(const std::vector<std::vector<float>>&);
+        indk::SignalMatrix getRows(uint64_t First, uint64_t Count) const;
+        const float* getRow(uint64_t) const;
+        uint64_t getRowsCount() const;
+        uint64_t getColumnsCount() const;
+        uint64_t getStride() const;
+        bool isEmpty() const;
+    };
+}
+
+#endif //INTERFERENCE_SIGNAL_H
@@ -11,7 +11,13 @@
 
 #include <mutex>
 #include <condition_variable>
+#include <memory>
 #include <indk/computer.h>
+#include <indk/executor.h>
+#include <indk/runtime.h>
+
+#define indk_KERNEL_RECEPTOR_WORK_THRESHOLD 1000000
+#define indk_ASYNC_QUEUE_DEPTH 64
 
 namespace indk {
     typedef std::tuple<std::string, std::string, void*, void*, int> LinkDefinition;
@@ -22,12 +28,19 @@ namespace indk {
         static bool isSynchronizationNeeded();
 
         /**
-        * Set compute backend.
+        * Set compute backend of the global runtime. The global runtime is used by neural nets that are not bound to their own runtime
+        * (see indk::NeuralNet::setRuntime). Do not change the global backend while neural nets that use it are computing.
         * @param Backend Compute backend value.
         * @param Parameter Custom parameter.
         */
         static void setComputeBackend(int Backend, int Parameter = 0);
 
+        /**
+         * Get global runtime. The runtime with the default compute backend is created on first use.
+         * @return Global runtime object.
+         */
+        static std::shared_ptr<indk::Runtime> getRuntime();
+
         /**
          * Set library verbosity level.
          * @param VL New verbosity level value.
@@ -58,6 +71,52 @@ namespace indk {
          */
         static int getComputeBackendParameter();
 
+        /**
+         * Set instruction set for native CPU compute kernels. If the CPU does not support the instruction set, the best supported one is used.
+         * @param InstructionSet Instruction set value.
+         */
+        static void setInstructionSet(int InstructionSet);
+
+        /**
+         * Get instruction set used by native CPU compute kernels. By default it is the best instruction set supported by the CPU.
+         * @return Instruction set value.
+         */
+        static int getInstructionSet();
+
+        /**
+         * Split the receptor loop of large neurons between threads of the native CPU compute kernels.
+         * A neuron is split when its work (synapses count x receptors count x dimensions count) reaches the threshold.
+         * The output does not depend on the threads count.
+         * @param Threads Threads count including the calling thread, 0 or 1 disables splitting (default).
+         * @param Threshold Minimal neuron work to split.
+         */
+        static void setReceptorParallelism(unsigned int Threads, uint64_t Threshold = indk_KERNEL_RECEPTOR_WORK_THRESHOLD);
+
+        /**
+         * Set count of threads used to build neurons when the neural net structure is loaded (see indk::NeuralNet::setStructure).
+         * @param Threads Threads count including the calling thread, 0 - hardware concurrency (default).
+         */
+        static void setStructureThreads(unsigned int Threads);
+
+        /**
+         * Get count of threads used to build neurons when the neural net structure is loaded.
+         * @return Threads count, 0 - hardware concurrency.
+         */
+        static unsigned int getStructureThreads();
+
+        /**
+         * Set parameters of the executor used by the asynchronous neural net methods. The previous executor finishes its queued tasks first.
+         * @param Threads Count of executor threads, 0 - hardware concurrency (default).
+         * @param QueueDepth Maximal count of queued tasks, asynchronous calls block while the queue is full. 0 - unbounded.
+         */
+        static void setAsyncExecutor(unsigned int Threads, unsigned int QueueDepth = indk_ASYNC_QUEUE_DEPTH);
+
+        /**
+         * Get executor used by the asynchronous neural net methods. The executor is created on first use.
+         * @return Executor object.
+         */
+        static std::shared_ptr<indk::Executor> getAsyncExecutor();
+
         /**
          * Compute backends enum.
          */
@@ -69,6 +128,18 @@ namespace indk {
             /// OpenCL compute backend.
             OpenCL
         } ComputeBackends;
+
+        /**
+         * Instruction sets enum.
+         */
+        typedef enum {
+            /// Portable scalar code.
+            InstructionSetScalar,
+            /// SSE4.2 vector code (x86 only).
+            InstructionSetSSE42,
+            /// AVX2 and FMA vector code (x86 only).
+            InstructionSetAVX2
+        } InstructionSets;
     };
 
     class Event {
@@ -14,6 +14,7 @@
 #include <indk/system.h>
 #include <indk/neuralnet.h>
 #include <fstream>
+#include <array>
 
 #define DEFINITIONS_COUNT 5
 
@@ -84,8 +85,9 @@ auto doLearnVocabulary(indk::NeuralNet *NN,
         dn -> doCopyEntry(source, n->getName());
         n -> doLinkOutput(dn->getName());
 
+        auto et = n -> getEntryIndex("ET");
         for (const auto& ch: word) {
-            n -> doSignalSendEntry("ET", (float)ch, n->getTime());
+            n -> doSignalSendEntry(et, (float)ch, n->getTime());
         }
         n -> doFinalize();
         n -> setOutputMode(indk::Neuron::OutputModes::OutputModeLatch);
@@ -124,6 +126,11 @@ void doCreateContextSpace(indk::NeuralNet *NN, const std::vector<std::vector<flo
     NN -> doIncludeNeuronToEnsemble(n->getName(), "CONTEXT");
     n -> doReset();
 
+    std::vector<int64_t> entries;
+    for (int j = 0; j < DEFINITIONS_COUNT; j++) {
+        entries.push_back(n->getEntryIndex("SPACE_E"+std::to_string(j+1)));
+    }
+
     int nstart = 0;
     while (nstart < encoded.size()) {
         indk::Position *pos = nullptr;
@@ -134,9 +141,9 @@ void doCreateContextSpace(indk::NeuralNet *NN, const std::vector<std::vector<flo
             if (pos) n -> getReceptor(0) -> getPos() -> setPosition(pos);
             for (int j = 0; j < DEFINITIONS_COUNT; j++) {
                 if (j == (int)encoded[r][1]) {
-                    n -> doSignalSendEntry("SPACE_E"+std::to_string(j+1), encoded[r][0], n->getTime());
+                    n -> doSignalSendEntry(entries[j], encoded[r][0], n->getTime());
                 } else {
-                    n -> doSignalSendEntry("SPACE_E"+std::to_string(j+1), 0, n->getTime());
+                    n -> doSignalSendEntry(entries[j], 0, n->getTime());
                 }
             }
             pos = n -> getReceptor(0) -> getPos();
@@ -10,6 +10,7 @@
 #include <vector>
 #include <fstream>
 #include <cstring>
+#include <array>
 
 typedef std::vector<std::array<uint8_t, 3>> BMPImage;
 
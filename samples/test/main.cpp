@@ -8,19 +8,33 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <cmath>
+#include <ctime>
 #include <fstream>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 #include <indk/neuralnet.h>
+#include <indk/error.h>
+#include <indk/kernel.h>
+#include <indk/computer.h>
 #include <indk/profiler.h>
+#include <indk/backends/multithread.h>
+#include <indk/session.h>
+#include <indk/arena.h>
 #include <iomanip>
 
 
 indk::NeuralNet *NN;
 std::vector<std::vector<float>> X;
 
-std::vector<std::tuple<indk::System::ComputeBackends, int, std::string>> backends = {
-        std::make_tuple(indk::System::ComputeBackends::Default, 0, "singlethread"),
-        std::make_tuple(indk::System::ComputeBackends::Multithread, 2, "multithread"),
-        std::make_tuple(indk::System::ComputeBackends::OpenCL, 0, "OpenCL"),
+std::vector<std::tuple<indk::System::ComputeBackends, int, indk::System::InstructionSets, std::string>> backends = {
+        std::make_tuple(indk::System::ComputeBackends::Default, 0, indk::System::InstructionSets::InstructionSetScalar, "singlethread, scalar"),
+        std::make_tuple(indk::System::ComputeBackends::Default, 0, indk::System::InstructionSets::InstructionSetSSE42, "singlethread, SSE4.2"),
+        std::make_tuple(indk::System::ComputeBackends::Default, 0, indk::System::InstructionSets::InstructionSetAVX2, "singlethread, AVX2"),
+        std::make_tuple(indk::System::ComputeBackends::Multithread, 2, indk::System::InstructionSets::InstructionSetAVX2, "multithread"),
+        std::make_tuple(indk::System::ComputeBackends::OpenCL, 0, indk::System::InstructionSets::InstructionSetAVX2, "OpenCL"),
 };
 
 uint64_t getTimestampMS() {
@@ -72,8 +86,9 @@ int doTests(const std::string& name, float ref) {
 
     for (auto &b: backends) {
         NN -> doReset();
-        std::cout << std::setw(50) << std::left << name+" ("+std::get<2>(b)+"): ";
+        std::cout << std::setw(50) << std::left << name+" ("+std::get<3>(b)+"): ";
         indk::System::setComputeBackend(std::get<0>(b), std::get<1>(b));
+        indk::System::setInstructionSet(std::get<2>(b));
         count += doTest(ref);
     }
     std::cout << std::endl;
@@ -81,13 +96,1207 @@ int doTests(const std::string& name, float ref) {
     return count;
 }
 
+std::string doReadFile(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+
+// neural net of the structure with `size` copies of the A1 ensemble, loaded by the DOM reader
+indk::NeuralNet* doCreateNet(const std::string& structure, int size, bool CopyEntries = false) {
+    auto NN = new indk::NeuralNet();
+    NN -> setStructure(structure);
+    for (int i = 2; i <= size; i++) {
+        NN -> doReplicateEnsemble("A1", "A"+std::to_string(i), CopyEntries);
+    }
+    return NN;
+}
+
+// neural net of the general structure with `size` ensembles learned on X
+indk::NeuralNet* doCreateLearnedNet(int size, bool CopyEntries = false) {
+    auto NN = doCreateNet(doReadFile("structures/structure_general.json"), size, CopyEntries);
+    NN -> doLearn(X);
+    return NN;
+}
+
+bool isEqual(const std::vector<float>& a, const std::vector<float>& b, float eps = 1e-3) {
+    if (a.size() != b.size()) return false;
+    for (uint64_t i = 0; i < a.size(); i++) {
+        if (std::fabs(a[i]-b[i]) > eps) return false;
+    }
+    return true;
+}
+
+bool isEqual(const std::vector<indk::OutputValue>& a, const std::vector<indk::OutputValue>& b, float eps = 1e-3) {
+    if (a.size() != b.size()) return false;
+    for (uint64_t i = 0; i < a.size(); i++) {
+        if (a[i].second != b[i].second || std::fabs(a[i].first-b[i].first) > eps) return false;
+    }
+    return true;
+}
+
+// signal different from the learned one, so that the outputs and pattern differences are not trivial
+std::vector<std::vector<float>> getSignal(int length = 100) {
+    std::vector<std::vector<float>> S;
+    for (int i = 0; i < length; i++) {
+        S.push_back({50+25*std::sin(i/10.f), 50+25*std::cos(i/7.f)});
+    }
+    return S;
+}
+
+// outputs of the recognition and pattern differences of all neurons
+std::pair<std::vector<indk::OutputValue>, std::vector<float>> doRecogniseSignal(indk::NeuralNet *N, const std::vector<std::vector<float>>& S) {
+    auto Y = N -> doRecognise(S);
+    return std::make_pair(Y, N->doComparePatterns());
+}
+
+bool isEqual(const std::pair<std::vector<indk::OutputValue>, std::vector<float>>& a,
+             const std::pair<std::vector<indk::OutputValue>, std::vector<float>>& b, float eps = 1e-3) {
+    return isEqual(a.first, b.first, eps) && isEqual(a.second, b.second, eps);
+}
+
+// synapse and receptor views read the same values as the packed rows of the neuron store, the synapse rows
+// are aligned and the view setters write to the store
+bool doCheckGeometryStore() {
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(3));
+    for (auto N: A->getNeurons()) {
+        auto S = N -> getStore();
+        if ((uintptr_t)S->getLambda()%64 || (uintptr_t)S->getGamma()%64) return false;
+        for (unsigned d = 0; d < N->getDimensionsCount(); d++) {
+            if ((uintptr_t)S->getSynapsePos(d)%64) return false;
+        }
+        for (int64_t e = 0; e < N->getEntriesCount(); e++) {
+            auto E = N -> getEntry(e);
+            for (int64_t k = 0; k < E->getSynapsesCount(); k++) {
+                auto Sy = E -> getSynapse(k);
+                if (S->getLambda()[Sy->getSID()] != Sy->getLambda()) return false;
+                for (unsigned d = 0; d < N->getDimensionsCount(); d++) {
+                    if (S->getSynapsePos(d)[Sy->getSID()] != Sy->getPos()->getPositionValue(d)) return false;
+                }
+                Sy -> setGamma(k+1);
+                if (S->getGamma()[Sy->getSID()] != k+1) return false;
+            }
+        }
+        for (int64_t r = 0; r < N->getReceptorsCount(); r++) {
+            auto R = N -> getReceptor(r);
+            for (unsigned d = 0; d < N->getDimensionsCount(); d++) {
+                if (S->getReceptorPos0(R->getRID())[d] != R->getPos0()->getPositionValue(d)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// a released synapse slot has no influence on receptors and does not copy the geometry shared with a context store,
+// the next added synapse reuses the slot, so the synapse count does not grow
+bool doCheckSynapseRelease() {
+    indk::Neuron::Store S(100, 2);
+    for (int k = 0; k < 3; k++) {
+        indk::Position P(100, {10.f*k, 10.f});
+        S.doAddSynapse(&P, 0.1f);
+        S.getGamma()[k] = 1;
+    }
+    indk::Neuron::Store C(&S);
+    std::vector<float> RPos = {15, 15};
+    std::vector<float> dRPos(2);
+    auto fi = indk::Kernel::doInteract(&S, RPos.data(), dRPos.data());
+
+    S.doReleaseSynapse(1);
+    if (S.getSynapsesCount() != 3 || S.getLambda() != C.getLambda() || S.getGamma()[1] != 0 || C.getGamma()[1] != 1) return false;
+    auto released = indk::Kernel::doInteract(&S, RPos.data(), dRPos.data());
+    if (!(released < fi) || indk::Kernel::doInteract(&C, RPos.data(), dRPos.data()) != fi) return false;
+
+    indk::Position P(100, {50.f, 50.f});
+    if (S.doAddSynapse(&P, 0.2f) != 1 || S.getSynapsesCount() != 3) return false;
+    return S.getLambda() != C.getLambda() && S.getLambda()[1] == 0.2f && C.getLambda()[1] == 0.1f && S.getSynapsePos(0)[1] == 50;
+}
+
+// potential and receptor displacement of every receptor of the learned net computed by the interaction kernel
+std::vector<float> doInteractReceptors(indk::NeuralNet *N) {
+    std::vector<float> values;
+    for (auto Nx: N->getNeurons()) {
+        auto NS = Nx -> getStore();
+        std::vector<float> dRPos(Nx->getDimensionsCount());
+        for (int64_t r = 0; r < Nx->getReceptorsCount(); r++) {
+            values.push_back(indk::Kernel::doInteract(NS, NS->getReceptorPosf(Nx->getReceptor(r)->getRID()), dRPos.data()));
+            values.insert(values.end(), dRPos.begin(), dRPos.end());
+        }
+    }
+    return values;
+}
+
+// SSE4.2 and AVX2 interaction kernels give the same potential and displacement as the scalar one for every receptor,
+// instruction sets the CPU does not support fall back to the supported one, and the nets learn and recognise the same
+bool doCheckInstructionSets() {
+    auto S = getSignal();
+    indk::System::setInstructionSet(indk::System::InstructionSets::InstructionSetScalar);
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref = doRecogniseSignal(A.get(), S);
+    auto interactions = doInteractReceptors(A.get());
+
+    for (auto is: {indk::System::InstructionSets::InstructionSetSSE42, indk::System::InstructionSets::InstructionSetAVX2}) {
+        indk::System::setInstructionSet(is);
+        if (indk::System::getInstructionSet() != std::min<int>(is, indk::Kernel::getSupportedInstructionSet())) return false;
+        auto values = doInteractReceptors(A.get());
+        if (values.size() != interactions.size()) return false;
+        for (uint64_t i = 0; i < values.size(); i++) {
+            if (std::fabs(values[i]-interactions[i]) > 1e-4*std::max(1.f, std::fabs(interactions[i]))) return false;
+        }
+        std::unique_ptr<indk::NeuralNet> B(doCreateLearnedNet(2));
+        if (!isEqual(doRecogniseSignal(B.get(), S), ref)) return false;
+    }
+    return true;
+}
+
+// two neuron structure with single synapses and receptors in the plane of the first two coordinates,
+// the rest of `dimensions` coordinates are zero, the reversed structure declares the consumer neuron first
+std::string getPlanarStructure(int dimensions, bool reversed = false) {
+    auto getPosition = [dimensions] (float x, float y) {
+        std::string pos = "["+std::to_string(x)+", "+std::to_string(y);
+        for (int d = 2; d < dimensions; d++) pos += ", 0";
+        return pos+"]";
+    };
+    auto getNeuron = [&getPosition, dimensions] (const std::string& name, const std::string& inputs, int entries) {
+        std::string neuron = "{\"name\": \""+name+"\", \"size\": 1000, \"dimensions\": "+std::to_string(dimensions)+
+                             ", \"input_signals\": "+inputs+", \"ensemble\": \"A1\", \"synapses\": [";
+        for (int e = 0; e < entries; e++) {
+            neuron += std::string(e ? ", " : "")+"{\"position\": "+getPosition(25+50*e, 50)+", \"entry\": "+std::to_string(e)+", \"k1\": 10}";
+        }
+        neuron += "], \"receptors\": [";
+        for (int r = 0; r < 6; r++) {
+            neuron += std::string(r ? ", " : "")+"{\"position\": "+getPosition(50+10*std::cos(r), 50+10*std::sin(r))+"}";
+        }
+        return neuron+"]}";
+    };
+    auto neurons = getNeuron("N1", "[\"E1\", \"E2\"]", 2)+", "+getNeuron("N2", "[\"N1\"]", 1);
+    if (reversed) neurons = getNeuron("N2", "[\"N1\"]", 1)+", "+getNeuron("N1", "[\"E1\", \"E2\"]", 2);
+    return "{\"entries\": [\"E1\", \"E2\"], \"neurons\": ["+neurons+"], \"output_signals\": [\"N2\"], "
+           "\"name\": \"planar\", \"desc\": \"\", \"version\": \"\"}";
+}
+
+// 2D and 3D neurons get their own kernel for every processing mode and the other dimension counts share the generic one,
+// the specialised and the generic kernels work the same on the same planar geometry in all processing modes
+bool doCheckKernelSpecialisation() {
+    auto S = getSignal();
+    std::vector<indk::Kernel::ProcessFunction> kernels;
+    for (auto mode: {indk::Neuron::ProcessingModeDefault, indk::Neuron::ProcessingModeAutoReset, indk::Neuron::ProcessingModeAutoRollback}) {
+        for (unsigned dimensions: {2, 3, 4}) {
+            auto kernel = indk::Kernel::getProcessFunction(dimensions, mode);
+            if (std::find(kernels.begin(), kernels.end(), kernel) != kernels.end()) return false;
+            kernels.push_back(kernel);
+        }
+        if (indk::Kernel::getProcessFunction(5, mode) != kernels.back()) return false;
+
+        std::pair<std::vector<indk::OutputValue>, std::vector<float>> ref;
+        for (int dimensions = 2; dimensions <= 5; dimensions++) {
+            std::unique_ptr<indk::NeuralNet> A(doCreateNet(getPlanarStructure(dimensions), 2));
+            if (A->getNeuronCount() != 4) return false;
+            for (auto N: A->getNeurons()) N -> setProcessingMode(mode);
+            A -> doLearn(X);
+            auto result = doRecogniseSignal(A.get(), S);
+            if (dimensions == 2) ref = result;
+            else if (!isEqual(result, ref)) return false;
+        }
+    }
+    return true;
+}
+
+// count of synapses visited by all receptors of the net and count of all synapse-receptor pairs
+std::pair<uint64_t, uint64_t> getCullingPairs(indk::NeuralNet *N) {
+    std::pair<uint64_t, uint64_t> pairs(0, 0);
+    for (auto Nx: N->getNeurons()) {
+        auto NS = Nx -> getStore();
+        for (int64_t r = 0; r < Nx->getReceptorsCount(); r++) {
+            auto RID = Nx -> getReceptor(r) -> getRID();
+            pairs.first += NS -> getNeighbours(RID, NS->getReceptorPosf(RID)).size();
+            pairs.second += NS -> getSynapsesCount();
+        }
+    }
+    return pairs;
+}
+
+// single neuron structure with the grid of 10x10 synapses with the step of 6 and receptors around the grid center,
+// the neuron size gives the Lambda value of 1
+std::string getGridStructure() {
+    std::string synapses, receptors;
+    for (int i = 0; i < 100; i++) {
+        synapses += std::string(i ? ", " : "")+"{\"position\": ["+std::to_string(3+6*(i%10))+", "+std::to_string(3+6*(i/10))+
+                    "], \"entry\": "+std::to_string(i%2)+", \"k1\": 10}";
+    }
+    for (int r = 0; r < 6; r++) {
+        receptors += std::string(r ? ", " : "")+"{\"position\": ["+std::to_string(30+5*std::cos(r))+", "+std::to_string(30+5*std::sin(r))+"]}";
+    }
+    return "{\"entries\": [\"E1\", \"E2\"], \"neurons\": [{\"name\": \"N1\", \"size\": 64, \"dimensions\": 2, "
+           "\"input_signals\": [\"E1\", \"E2\"], \"ensemble\": \"A1\", \"synapses\": ["+synapses+"], \"receptors\": ["+receptors+"]}], "
+           "\"output_signals\": [\"N1\"], \"name\": \"grid\", \"desc\": \"\", \"version\": \"\"}";
+}
+
+// culling with the cutoff beyond the neuron space visits all synapses and works the same as the full synapse set,
+// small cutoff skips synapses and only slightly changes the result, with and without the skin radius
+bool doCheckCulling() {
+    // the grid neuron is small, so it gets smaller signals
+    for (const auto &structure: {std::make_pair(doReadFile("structures/structure_general.json"), 1.f), std::make_pair(getGridStructure(), .1f)}) {
+        auto L = X, S = getSignal();
+        for (auto &x: L) for (auto &v: x) v *= structure.second;
+        for (auto &x: S) for (auto &v: x) v *= structure.second;
+        std::unique_ptr<indk::NeuralNet> A(doCreateNet(structure.first, 2));
+        A -> doLearn(L);
+        auto ref = doRecogniseSignal(A.get(), S);
+
+        for (float skin: {0.f, 5.f}) {
+            for (auto cutoff: {std::make_pair(1e-30f, 1e-3f), std::make_pair(1e-7f, 1e-2f)}) {
+                std::unique_ptr<indk::NeuralNet> B(doCreateNet(structure.first, 2));
+                B -> setCulling(cutoff.first, skin);
+                B -> doLearn(L);
+                if (!isEqual(doRecogniseSignal(B.get(), S), ref, cutoff.second)) return false;
+                auto pairs = getCullingPairs(B.get());
+                if (cutoff.first < 1e-10 ? pairs.first != pairs.second : pairs.first >= pairs.second) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// neighbour list of the receptor only has the synapses within the cutoff radius plus the skin, it is kept while the receptor
+// stays within the skin radius from the position the list was built at, and is rebuilt after the receptor moves further
+bool doCheckCullingSkin() {
+    constexpr float skin = 5;
+    std::unique_ptr<indk::NeuralNet> A(doCreateNet(getGridStructure(), 1));
+    auto N = A -> getNeuron("N1");
+    auto NS = N -> getStore();
+    auto RID = N -> getReceptor(0) -> getRID();
+    // neighbour list built anew at the position, setCulling drops the index
+    auto getBuilt = [N, NS, RID] (const std::vector<float>& pos) {
+        N -> setCulling(1e-7, skin);
+        return NS -> getNeighbours(RID, pos.data());
+    };
+
+    std::vector<float> P = {30, 30}, Q = P;
+    auto list = getBuilt(P);
+    if (list.empty() || list.size() >= NS->getSynapsesCount()) return false;
+    while (Q[0] < P[0]+skin && getBuilt(Q) == list) Q[0] += 0.5;
+    if (Q[0] >= P[0]+skin) return false;
+
+    getBuilt(P);
+    if (NS->getNeighbours(RID, Q.data()) != list) return false;
+    Q[0] = P[0] + skin*2;
+    auto far = getBuilt(Q);
+    getBuilt(P);
+    return far != list && NS->getNeighbours(RID, Q.data()) == far;
+}
+
+// execution plan computes the neurons in the order of their links, whatever order they are declared in, and is rebuilt
+// after the structure changes: the net with the ensemble replicated after the plan was compiled works the same as the net
+// compiled with it, and the same as the smaller net after the ensemble is deleted
+bool doCheckExecutionPlan() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref2 = doRecogniseSignal(A.get(), S);
+    std::unique_ptr<indk::NeuralNet> B(doCreateLearnedNet(3));
+    auto ref3 = doRecogniseSignal(B.get(), S);
+
+    std::unique_ptr<indk::NeuralNet> P(doCreateNet(getPlanarStructure(3), 2)), R(doCreateNet(getPlanarStructure(3, true), 2));
+    P -> doLearn(X);
+    R -> doLearn(X);
+    if (!isEqual(doRecogniseSignal(R.get(), S), doRecogniseSignal(P.get(), S))) return false;
+
+    std::unique_ptr<indk::NeuralNet> C(doCreateNet(doReadFile("structures/structure_general.json"), 2));
+    C -> doStructurePrepare();
+    C -> doReplicateEnsemble("A1", "A3");
+    C -> doLearn(X);
+    if (!isEqual(doRecogniseSignal(C.get(), S), ref3)) return false;
+    for (auto N: C->getEnsemble("A3")) C -> doDeleteNeuron(N->getName());
+    return isEqual(doRecogniseSignal(C.get(), S), ref2);
+}
+
+// neuron receiving the signal by entry indices works the same as the neuron receiving it by entry names,
+// entries are sent in reverse order to the indexed one and it is computed once, when the last entry of the tick is filled
+bool doCheckEntryRouting() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(1));
+    auto N = A -> getNeuron("N1");
+    indk::Neuron P(*N), Q(*N);
+    std::vector<float> yp, yq;
+
+    auto entries = Q.getEntries();
+    if (Q.getEntryIndex("E0") != -1 || Q.doSignalSendEntry((int64_t)entries.size(), 0, 0)) return false;
+    for (int64_t t = 0; t < (int64_t)S.size(); t++) {
+        P.doSignalSendEntry("E1", S[t][0], t);
+        P.doSignalSendEntry("E2", S[t][1], t);
+        for (auto e = (int64_t)entries.size()-1; e >= 0; e--) {
+            if (Q.getTime() != t || Q.doSignalSendEntry(Q.getEntryIndex(entries[e]), S[t][entries[e] == "E1" ? 0 : 1], t) != !e) return false;
+        }
+        if (Q.getTime() != t+1) return false;
+        yp.push_back(P.doSignalReceive().second);
+        yq.push_back(Q.doSignalReceive().second);
+    }
+    return P.getTime() == (int64_t)S.size() && isEqual(yq, yp) &&
+           std::fabs(std::get<0>(Q.doComparePattern())-std::get<0>(P.doComparePattern())) < 1e-3;
+}
+
+// multithread backend schedules the cyclic neuron graph so that it learns and recognises the same as the default one,
+// its idle workers block instead of spinning, and the error of a neuron is thrown to the caller
+bool doCheckMultithread() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(3));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    for (int threads: {2, 4}) {
+        indk::System::setComputeBackend(indk::System::ComputeBackends::Multithread, threads);
+        std::unique_ptr<indk::NeuralNet> B(doCreateLearnedNet(3));
+        if (!isEqual(doRecogniseSignal(B.get(), S), ref)) return false;
+
+        auto T = std::clock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if ((std::clock()-T)*1000/CLOCKS_PER_SEC > 20) return false;
+
+        // receptors of the small grid neuron are moved out of its space by the full scale signal
+        std::unique_ptr<indk::NeuralNet> C(doCreateNet(getGridStructure(), 1));
+        try {
+            C -> doLearn(X);
+            return false;
+        } catch (indk::Error &e) {
+            if (std::string(e.what()).find("EX_POSITION_OUT_RANGES")) return false;
+        }
+    }
+    return true;
+}
+
+// multithread backend runs the default count of workers for the parameter below 2 and reports the count it runs,
+// and computes the net with more workers than neurons the same as the default backend
+bool doCheckWorkerCount() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(1));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    for (int threads: {0, 1, 3, 8}) {
+        indk::System::setComputeBackend(indk::System::ComputeBackends::Multithread, threads);
+        if (indk::System::getComputeBackendParameter() != (threads < 2 ? indk_MULTITHREAD_DEFAULT_NUM : threads)) return false;
+        std::unique_ptr<indk::NeuralNet> B(doCreateLearnedNet(1));
+        if (!isEqual(doRecogniseSignal(B.get(), S), ref)) return false;
+    }
+    return true;
+}
+
+// receptors of every neuron split between threads give exactly the same result as the single receptor loop
+// whatever the count of threads is, with the default and the multithread backend
+bool doCheckReceptorParallelism() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    bool passed = true;
+    for (unsigned threads: {2, 3}) {
+        indk::System::setReceptorParallelism(threads, 0);
+        passed = passed && indk::Kernel::getReceptorThreads() == threads && indk::Kernel::getReceptorWorkThreshold() == 0;
+        for (auto backend: {indk::System::ComputeBackends::Default, indk::System::ComputeBackends::Multithread}) {
+            indk::System::setComputeBackend(backend, 2);
+            std::unique_ptr<indk::NeuralNet> B(doCreateLearnedNet(2));
+            passed = passed && isEqual(doRecogniseSignal(B.get(), S), ref, 0);
+        }
+    }
+    indk::System::setReceptorParallelism(0);
+    return passed;
+}
+
+// every sample of the batch is recognised the same as by the sequential doRecognise calls, whatever the count
+// of batch threads is, and the batch does not change the state of the net itself
+bool doCheckBatchRecognition() {
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    std::vector<std::vector<std::vector<float>>> samples;
+    std::vector<std::pair<std::vector<indk::OutputValue>, std::vector<float>>> ref;
+    for (int length = 20; length <= 100; length += 20) {
+        samples.push_back(getSignal(length));
+        ref.push_back(doRecogniseSignal(A.get(), samples.back()));
+    }
+    auto time = A -> getNeuron("N1") -> getTime();
+
+    for (unsigned threads: {1, 3}) {
+        auto results = A -> doRecogniseBatch(samples, {}, threads);
+        if (results.size() != samples.size()) return false;
+        for (uint64_t i = 0; i < results.size(); i++) {
+            if (!isEqual(std::make_pair(results[i].Outputs, results[i].Patterns), ref[i])) return false;
+        }
+    }
+    return A->getNeuron("N1")->getTime() == time && isEqual(A->doComparePatterns(), ref.back().second, 0);
+}
+
+// the matrix is a view: rows point into the caller's data (strided or nested vectors) without copies,
+// a matrix with less columns than the used entries is rejected, and signals read in place from
+// the flat strided matrix, with the columns in other order than the entries, give the same result
+// as the signals of the nested vectors
+bool doCheckSignalMatrix() {
+    auto S = getSignal();
+    std::vector<float> flat(12);
+    indk::SignalMatrix M(flat.data(), 3, 2, 4), P(flat.data(), 6, 2);
+    if (M.getStride() != 4 || P.getStride() != 2) return false;
+    for (uint64_t r = 0; r < 3; r++) if (M.getRow(r) != flat.data()+r*4) return false;
+    indk::SignalMatrix V(S);
+    if (V.getRowsCount() != S.size() || V.getColumnsCount() != 2) return false;
+    for (uint64_t r = 0; r < S.size(); r++) if (V.getRow(r) != S[r].data()) return false;
+    if (!indk::SignalMatrix().isEmpty()) return false;
+
+    std::unique_ptr<indk::NeuralNet> C(doCreateLearnedNet(2));
+    try {
+        C -> doRecognise(indk::SignalMatrix(flat.data(), 6, 1), true, {"E1", "E2"});
+        return false;
+    } catch (indk::Error &e) {
+        if (std::string(e.what()).find("EX_NEURALNET_INPUT") != 0) return false;
+    }
+
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    constexpr uint64_t stride = 3;
+    std::vector<float> learning(X.size()*stride, -1), recognition(S.size()*stride, -1);
+    for (uint64_t i = 0; i < X.size(); i++) {
+        learning[i*stride] = X[i][1];
+        learning[i*stride+1] = X[i][0];
+    }
+    for (uint64_t i = 0; i < S.size(); i++) {
+        recognition[i*stride] = S[i][1];
+        recognition[i*stride+1] = S[i][0];
+    }
+
+    std::unique_ptr<indk::NeuralNet> B(doCreateNet(doReadFile("structures/structure_general.json"), 2));
+    B -> doLearn(indk::SignalMatrix(learning.data(), X.size(), 2, stride), true, {"E2", "E1"});
+    auto Y = B -> doRecognise(indk::SignalMatrix(recognition.data(), S.size(), 2, stride), true, {"E2", "E1"});
+    return isEqual(std::make_pair(Y, B->doComparePatterns()), ref);
+}
+
+// an output ID is the index of the output in the output list and survives the table rebuild,
+// the buffer gets exactly getOutputsCount() signals, and the signals written by output IDs are
+// the same as the named output signals, also after the table is rebuilt for the replicated ensemble
+bool doCheckOutputTable() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    int64_t first = -1;
+
+    for (int size = 2; size <= 3; size++) {
+        if (size == 3) {
+            A -> doReplicateEnsemble("A1", "A3");
+            A -> doLearn(X);
+        }
+        auto ref = A -> doRecognise(S);
+        if (A->getOutputsCount() != (uint64_t)size || A->getOutputID("N1") != -1) return false;
+
+        std::vector<float> Y(A->getOutputsCount()+1, -1);
+        A -> doSignalReceive(Y.data());
+        if (Y.back() != -1) return false;
+        for (uint64_t o = 0; o < ref.size(); o++) {
+            auto id = A -> getOutputID(ref[o].second);
+            if (id != (int64_t)o || std::fabs(Y[id]-ref[o].first) > 1e-6) return false;
+        }
+        if (size == 3 && A->getOutputID(ref[0].second) != first) return false;
+        first = A -> getOutputID(ref[0].second);
+
+        auto ids = A -> getEnsembleOutputs("A2");
+        auto yref = A -> doSignalReceive("A2");
+        Y.assign(ids.size(), 0);
+        A -> doSignalReceive(Y.data(), ids);
+        if (ids.size() != 1 || yref.size() != 1 || std::fabs(Y[0]-yref[0].first) > 1e-6) return false;
+    }
+    return true;
+}
+
+// asynchronous jobs of two nets run on the executor at the same time, jobs of one net run in submission order,
+// so both nets learn and recognise the same as synchronously
+bool doCheckAsync() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    std::vector<std::unique_ptr<indk::NeuralNet>> nets;
+    std::vector<indk::AsyncTransfer> transfers;
+    std::vector<std::vector<indk::OutputValue>> callbacks(2);
+    for (int i = 0; i < 2; i++) {
+        nets.emplace_back(doCreateNet(doReadFile("structures/structure_general.json"), 2));
+        nets[i] -> doLearnAsync(X);
+        transfers.push_back(nets[i]->doRecogniseAsync(S, [&callbacks, i] (std::vector<indk::OutputValue> Y) {
+            callbacks[i] = Y;
+        }));
+    }
+    for (int i = 0; i < 2; i++) {
+        nets[i] -> doWaitAsync();
+        if (!transfers[i].isReady() || !isEqual(callbacks[i], ref.first)) return false;
+        if (!isEqual(std::make_pair(transfers[i].getResult(), nets[i]->doComparePatterns()), ref)) return false;
+    }
+    return true;
+}
+
+// blocks the only worker of the executor until the gate is opened, so the next jobs stay queued
+void doBlockExecutor(const std::shared_ptr<std::atomic<int>>& gate) {
+    indk::System::getAsyncExecutor() -> doSubmit(gate.get(), [gate] () {
+        *gate = 1;
+        while (*gate != 2) std::this_thread::yield();
+    });
+    while (*gate != 1) std::this_thread::yield();
+}
+
+bool isCancelled(const indk::AsyncTransfer& T) {
+    try {
+        T.getResult();
+    } catch (indk::Error &e) {
+        return std::string(e.what()).find("EX_NEURALNET_CANCELLED") == 0;
+    }
+    return false;
+}
+
+// a cancelled queued transfer does not start, a running transfer stops after the current tick,
+// both end with EX_NEURALNET_CANCELLED and do not call the callback, the submission blocks
+// while the bounded queue is full, and the transfers left on a replaced executor are waited for
+bool doCheckAsyncControl() {
+    auto S = getSignal();
+    auto ticks = std::make_shared<std::atomic<int>>(0);
+    auto running = std::make_shared<indk::AsyncTransfer>();
+    std::atomic<bool> called(false);
+    auto callback = [&called] (std::vector<indk::OutputValue>) { called = true; };
+
+    indk::System::setAsyncExecutor(1, 1);
+    auto executor = indk::System::getAsyncExecutor();
+    if (executor->getThreadsCount() != 1 || executor->getQueueDepth() != 1) return false;
+
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    indk::Profiler::doAttachCallback(A.get(), indk::Profiler::EventFlags::EventTick, [ticks, running] (indk::NeuralNet*) {
+        if (++*ticks == 1) running -> doCancel();
+    });
+
+    auto gate = std::make_shared<std::atomic<int>>(0);
+    doBlockExecutor(gate);
+    auto queued = A -> doRecogniseAsync(S, callback);
+    queued.doCancel();
+    *gate = 2;
+    if (!isCancelled(queued) || *ticks != 0 || called) return false;
+
+    gate = std::make_shared<std::atomic<int>>(0);
+    doBlockExecutor(gate);
+    *running = A -> doRecogniseAsync(S, callback);
+    *gate = 2;
+    if (!isCancelled(*running) || *ticks != 1 || called) return false;
+
+    gate = std::make_shared<std::atomic<int>>(0);
+    doBlockExecutor(gate);
+    auto first = A -> doRecogniseAsync(S);
+    std::atomic<bool> submitted(false);
+    indk::AsyncTransfer second;
+    std::thread submitter([&] () {
+        second = A -> doRecogniseAsync(S);
+        submitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    bool blocked = !submitted;
+    *gate = 2;
+    submitter.join();
+    A -> doWaitAsync();
+
+    // a transfer left on a replaced executor is waited for and runs before the next transfer of the net
+    gate = std::make_shared<std::atomic<int>>(0);
+    doBlockExecutor(gate);
+    auto left = A -> doRecogniseAsync(S);
+    indk::System::setAsyncExecutor(1);
+    auto next = A -> doRecogniseAsync(S);
+    std::atomic<bool> waited(false);
+    std::thread waiter([&] () {
+        A -> doWaitAsync();
+        waited = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    bool ordered = !waited && !next.isReady();
+    *gate = 2;
+    waiter.join();
+    indk::System::setAsyncExecutor(0);
+
+    return blocked && first.isReady() && second.isReady() && !isCancelled(second) &&
+           ordered && left.isReady() && next.isReady();
+}
+
+// a runtime reports its own backend and whether it needs the transfer lock, unbound nets follow the global
+// runtime, nets bound to their own runtimes keep their backends when the global backend changes, two nets
+// sharing the multithread runtime work on it at the same time, and all of them give the same result
+// as the global default backend
+bool doCheckRuntime() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    auto multithread = std::make_shared<indk::Runtime>(indk::System::ComputeBackends::Multithread, 2);
+    std::unique_ptr<indk::NeuralNet> B(doCreateNet(doReadFile("structures/structure_general.json"), 2));
+    std::unique_ptr<indk::NeuralNet> C(doCreateNet(doReadFile("structures/structure_general.json"), 2));
+    std::unique_ptr<indk::NeuralNet> D(doCreateNet(doReadFile("structures/structure_general.json"), 2));
+    B -> setRuntime(multithread);
+    C -> setRuntime(multithread);
+    D -> setRuntime(std::make_shared<indk::Runtime>(indk::System::ComputeBackends::Default));
+    if (multithread->getComputeBackendKind() != indk::System::ComputeBackends::Multithread || multithread->getComputeBackendParameter() != 2) return false;
+    if (!multithread->isSynchronizationNeeded() || D->getRuntime()->isSynchronizationNeeded()) return false;
+
+    // an unbound net follows the global runtime, the replaced global runtime stays valid while it is held
+    auto global = indk::System::getRuntime();
+    if (A->getRuntime() != global) return false;
+    indk::System::setComputeBackend(indk::System::ComputeBackends::Multithread, 3);
+    if (A->getRuntime() != indk::System::getRuntime() || A->getRuntime() == global) return false;
+    if (global->getComputeBackendKind() != indk::System::ComputeBackends::Default || !global->getComputeBackend()) return false;
+    if (D->getRuntime()->getComputeBackendKind() != indk::System::ComputeBackends::Default) return false;
+
+    std::vector<std::pair<std::vector<indk::OutputValue>, std::vector<float>>> results(2);
+    std::thread T([&B, &S, &results] () {
+        B -> doLearn(X);
+        results[0] = doRecogniseSignal(B.get(), S);
+    });
+    C -> doLearn(X);
+    results[1] = doRecogniseSignal(C.get(), S);
+    T.join();
+    D -> doLearn(X);
+
+    return B->getRuntime() == multithread && isEqual(results[0], ref) && isEqual(results[1], ref) &&
+           isEqual(doRecogniseSignal(D.get(), S), ref);
+}
+
+// signal buffers hold one tick for the default backend and the tick window plus the previous tick
+// for the multithread backend, whatever the sequence length is, and the sequence split in two transfers
+// without preparing the net between them gives the same result as one transfer, with both backends
+bool doCheckSignalBuffers() {
+    auto S = getSignal(200);
+    std::vector<std::vector<float>> S1(S.begin(), S.begin()+100), S2(S.begin()+100, S.end());
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    for (auto backend: {indk::System::ComputeBackends::Default, indk::System::ComputeBackends::Multithread}) {
+        indk::System::setComputeBackend(backend, 2);
+        std::unique_ptr<indk::NeuralNet> B(doCreateLearnedNet(2));
+        int64_t size = backend == indk::System::ComputeBackends::Default ? 1 : indk_SIGNAL_WINDOW+1;
+        if (!isEqual(doRecogniseSignal(B.get(), S), ref) || B->getSignalBufferSize() != size) return false;
+        B -> doRecognise(S1);
+        auto Y = B -> doRecognise(S2, false);
+        if (!isEqual(std::make_pair(Y, B->doComparePatterns()), ref) || B->getSignalBufferSize() != size) return false;
+    }
+    return true;
+}
+
+// every output frame of the streaming session is the same as the output of doRecognise over the frames pushed
+// up to the frame plus the output latency (zero frames after the last one, as the session is flushed), for frames
+// pushed one at a time and as a matrix, with the default and the multithread backend, the full queue drops
+// the oldest frames and the callback gets every frame in order instead of the queue
+bool doCheckSession() {
+    constexpr int length = 40;
+    auto S = getSignal(length);
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    std::vector<std::vector<float>> ref(length, std::vector<float>(A->getOutputsCount()));
+    auto padded = S;
+    for (uint64_t o = 0; o < A->getOutputsCount(); o++) {
+        padded.resize(std::max<uint64_t>(padded.size(), length+A->getOutputLatency(o)), {0, 0});
+    }
+    for (uint64_t o = 0; o < A->getOutputsCount(); o++) {
+        for (int k = 0; k < length; k++) {
+            A -> doRecognise(std::vector<std::vector<float>>(padded.begin(), padded.begin()+k+A->getOutputLatency(o)+1));
+            A -> doSignalReceive(&ref[k][o], std::vector<uint64_t>{o});
+        }
+    }
+    A -> doRecognise(padded);
+    auto patterns = A -> doComparePatterns();
+
+    for (auto backend: {indk::System::ComputeBackends::Default, indk::System::ComputeBackends::Multithread}) {
+        indk::System::setComputeBackend(backend, 2);
+        std::unique_ptr<indk::NeuralNet> B(doCreateLearnedNet(2));
+        indk::Session session(B.get(), false, {}, length);
+        std::vector<float> rows;
+        for (int k = 0; k < length; k++) {
+            if (k < length/2) session.doPush(S[k]);
+            else rows.insert(rows.end(), S[k].begin(), S[k].end());
+        }
+        session.doPush(indk::SignalMatrix(rows.data(), length-length/2, 2));
+        session.doFlush();
+
+        int64_t frame;
+        std::vector<float> Y(session.getOutputsCount());
+        for (int k = 0; k < length; k++) {
+            if (!session.doPull(frame, Y.data()) || frame != k || !isEqual(Y, ref[k])) return false;
+        }
+        if (session.getReadyCount() || session.getDroppedCount() || !isEqual(B->doComparePatterns(), patterns)) return false;
+    }
+
+    // the full queue drops the oldest frames, the callback gets every frame in order
+    std::unique_ptr<indk::NeuralNet> C(doCreateLearnedNet(2));
+    indk::Session bounded(C.get(), false, {}, 5);
+    for (const auto &x: S) bounded.doPush(x);
+    bounded.doFlush();
+    int64_t frame;
+    std::vector<float> Y(bounded.getOutputsCount());
+    if (bounded.getReadyCount() != 5 || bounded.getDroppedCount() != length-5) return false;
+    for (int k = length-5; k < length; k++) {
+        if (!bounded.doPull(frame, Y.data()) || frame != k || !isEqual(Y, ref[k])) return false;
+    }
+    if (bounded.doPull(frame, Y.data())) return false;
+
+    std::unique_ptr<indk::NeuralNet> D(doCreateLearnedNet(2));
+    indk::Session streamed(D.get());
+    int64_t next = 0;
+    bool ordered = true;
+    streamed.setCallback([&] (int64_t Frame, const float *Yf) {
+        ordered = ordered && Frame == next && isEqual(std::vector<float>(Yf, Yf+streamed.getOutputsCount()), ref[Frame]);
+        next++;
+    });
+    for (const auto &x: S) streamed.doPush(x);
+    streamed.doFlush();
+    return ordered && next == length && !streamed.getReadyCount();
+}
+
+// learned net loaded from the binary model has the same structure and works the same as the saved one,
+// saving it again gives the same file, the converters keep the structure, and the truncated model
+// and the model with the damaged magic are rejected
+bool doCheckBinaryModel() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    A -> doSaveModel("check_model.indk");
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    indk::NeuralNet B;
+    B.doLoadModel("check_model.indk");
+    B.doSaveModel("check_model_copy.indk");
+    auto model = doReadFile("check_model.indk");
+    bool passed = B.getStructure() == A->getStructure() && doReadFile("check_model_copy.indk") == model &&
+                  isEqual(doRecogniseSignal(&B, S), ref);
+
+    // the image starts with the magic, the converters keep the structure in both directions
+    passed = passed && indk::Model::isModel("check_model.indk") && !indk::Model::isModel("structures/structure_general.json");
+    indk::Model::doConvertToJSON("check_model.indk", "check_model.json");
+    passed = passed && doReadFile("check_model.json") == B.getStructure(false);
+    indk::NeuralNet D, E("structures/structure_general.json");
+    indk::Model::doConvertToBinary("structures/structure_general.json", "check_model_copy.indk");
+    D.doLoadModel("check_model_copy.indk");
+    passed = passed && D.getStructure() == E.getStructure();
+
+    for (auto size: {model.size()/2, model.size()}) {
+        auto damaged = model.substr(0, size);
+        if (size == model.size()) damaged[0] ^= 1;
+        std::ofstream stream("check_model_copy.indk", std::ios::binary | std::ios::trunc);
+        stream.write(damaged.data(), damaged.size());
+        stream.close();
+        try {
+            indk::NeuralNet C;
+            C.doLoadModel("check_model_copy.indk");
+            passed = false;
+        } catch (indk::Error &e) {
+            passed = passed && std::string(e.what()).find("EX_MODEL_FORMAT") == 0;
+        }
+    }
+
+    std::remove("check_model.indk");
+    std::remove("check_model.json");
+    std::remove("check_model_copy.indk");
+    return passed;
+}
+
+// two nets attached to the same model file work the same as the net loaded from it, read the geometry from
+// aligned sections, and keep working the same
+// after one of them changes the geometry by setLambda and learning, the model file itself is not changed
+bool doCheckAttachedModel() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    A -> doSaveModel("check_model.indk");
+    auto model = doReadFile("check_model.indk");
+    bool passed;
+
+    {
+        indk::NeuralNet B, C, D;
+        B.doAttachModel("check_model.indk");
+        C.doAttachModel("check_model.indk");
+        D.doLoadModel("check_model.indk");
+        auto ref = doRecogniseSignal(&D, S);
+        passed = B.isAttached() && !D.isAttached() && isEqual(doRecogniseSignal(&B, S), ref) && isEqual(doRecogniseSignal(&C, S), ref);
+        for (auto N: B.getNeurons()) {
+            auto store = N -> getStore();
+            passed = passed && !((uintptr_t)store->getLambda()%64) && !((uintptr_t)store->getSynapsePos(0)%64);
+        }
+
+        for (auto N: {B.getNeuron("N2"), D.getNeuron("N2")}) N -> setLambda(0.5);
+        B.doLearn(X);
+        D.doLearn(X);
+        ref = doRecogniseSignal(&D, S);
+        passed = passed && isEqual(doRecogniseSignal(&B, S), ref) && !isEqual(doRecogniseSignal(&C, S), ref);
+    }
+
+    passed = passed && doReadFile("check_model.indk") == model;
+    std::remove("check_model.indk");
+    return passed;
+}
+
+// neurons built on several structure threads give the same structure and work the same as the neurons built on one thread,
+// and with any thread count only the neurons preceding the first invalid definition are kept
+bool doCheckStructureThreads() {
+    auto S = getSignal();
+    auto threads = indk::System::getStructureThreads();
+    indk::System::setStructureThreads(1);
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    // the structure with the invalid definition of N4, the error message is not printed to the test output
+    auto invalid = doReadFile("structures/structure_general.json");
+    auto n4 = invalid.find("\"dimensions\": 3", invalid.find("\"N4\""));
+    invalid.replace(n4, 15, "\"dimensions\": 2");
+    std::stringstream messages;
+    auto output = std::cout.rdbuf(messages.rdbuf());
+
+    bool passed = true;
+    for (unsigned t: {1, 2, 4}) {
+        indk::System::setStructureThreads(t);
+        std::unique_ptr<indk::NeuralNet> B(doCreateLearnedNet(2));
+        passed = passed && B->getStructure() == A->getStructure() && isEqual(doRecogniseSignal(B.get(), S), ref);
+
+        indk::NeuralNet C;
+        C.setStructure(invalid);
+        auto neurons = C.getNeurons();
+        passed = passed && neurons.size() == 3 && C.getNeuron("N3") && !C.getNeuron("N4");
+    }
+    std::cout.rdbuf(output);
+    indk::System::setStructureThreads(threads);
+    return passed && messages.str().find("Error: position vector size not equal dimension count") == 0;
+}
+
+// streaming reader builds the same structures as the DOM reader, for the structure files and for the learned
+// structure with the reference scopes, and drops the whole structure with an invalid neuron definition,
+// a missing required key or a truncated document
+bool doCheckStreamingReader() {
+    for (const auto &path: {"structures/structure_general.json", "structures/structure_bench.json"}) {
+        indk::NeuralNet A, B;
+        std::ifstream structure(path);
+        A.setStructure(structure);
+        B.setStructure(doReadFile(path));
+        if (!A.getNeuronCount() || A.getStructure() == "" || A.getStructure() != B.getStructure()) return false;
+    }
+
+    std::unique_ptr<indk::NeuralNet> L(doCreateLearnedNet(2));
+    auto learned = L -> getStructure(false);
+    auto general = doReadFile("structures/structure_general.json");
+    std::vector<std::string> broken;
+    auto n4 = general.find("\"dimensions\": 3", general.find("\"N4\""));
+    broken.push_back(general);
+    broken.back().replace(n4, 15, "\"dimensions\": 2");
+    for (const auto &key: {"\"size\"", "\"name\": \"N", "\"radius\"", "\"count\""}) {
+        broken.push_back(general);
+        broken.back().replace(broken.back().rfind(key), 2, "\"x");
+    }
+    broken.push_back(general.substr(0, general.size()/2));
+
+    std::stringstream messages;
+    auto output = std::cout.rdbuf(messages.rdbuf());
+    auto verbosity = indk::System::getVerbosityLevel();
+    indk::System::setVerbosityLevel(0);
+    bool passed = true;
+    for (uint64_t i = 0; i <= broken.size(); i++) {
+        std::ofstream(std::string("check_structure.json")) << (i ? broken[i-1] : learned);
+        indk::NeuralNet A, B;
+        std::ifstream structure("check_structure.json");
+        A.setStructure(structure);
+        if (!i) {
+            B.setStructure(learned);
+            passed = passed && A.getNeuronCount() && A.getStructure(false) == B.getStructure(false);
+        } else passed = passed && !A.getNeuronCount();
+    }
+    indk::System::setVerbosityLevel(verbosity);
+    std::cout.rdbuf(output);
+    std::remove("check_structure.json");
+    return passed;
+}
+
+// ensembles of the lazily attached model with the residency limit are loaded and released as the inputs select them,
+// keeping exactly the limit of the most recently used ensembles, work the same as the ensembles of the fully
+// attached model, and the full structure request leaves the lazy mode
+bool doCheckLazyModel() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateNet(doReadFile("structures/structure_general.json"), 4, true));
+    A -> doLearn(std::vector<std::vector<float>>(X.size(), std::vector<float>(X[0].size()*4, 50)));
+    A -> doSaveModel("check_model.indk");
+    bool passed = true;
+
+    {
+        indk::NeuralNet F, L;
+        F.doAttachModel("check_model.indk");
+        L.doAttachModel("check_model.indk", true);
+        L.setResidentEnsemblesLimit(2);
+        passed = L.getResidentEnsemblesCount() == 0;
+        uint64_t used = 0;
+        for (int i: {1, 2, 3, 4, 1, 3}) {
+            auto ename = "A"+std::to_string(i);
+            std::vector<std::string> inputs = {"E1", "E2"};
+            if (i > 1) inputs = {ename+"E1", ename+"E2"};
+            F.doRecognise(S, true, inputs);
+            L.doRecognise(S, true, inputs);
+            auto Y = L.doSignalReceive(ename);
+            used++;
+            passed = passed && L.getResidentEnsemblesCount() == std::min<uint64_t>(used, 2) && Y.size() == 1 && isEqual(Y, F.doSignalReceive(ename)) &&
+                     isEqual(L.doComparePatterns(ename), F.doComparePatterns(ename));
+        }
+        // the full structure leaves the lazy mode, residency is not tracked any more
+        passed = passed && L.getStructure() == F.getStructure() && !L.getResidentEnsemblesCount();
+        L.doRecognise(S, true, {"E1", "E2"});
+        passed = passed && !L.getResidentEnsemblesCount() && L.getNeuronCount() == F.getNeuronCount();
+    }
+
+    std::remove("check_model.indk");
+    return passed;
+}
+
+// net replayed from the checkpoint log works the same as the net loaded from the binary model saved at the same time,
+// the torn last record is dropped on replay and overwritten by the next checkpoint of the same change, the checkpoint
+// without changes appends nothing, deleted neurons are dropped on replay, and the log is compacted to a snapshot
+bool doCheckCheckpoint() {
+    auto S = getSignal();
+    std::remove("check_log.indk");
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    A -> setCheckpointCompaction(0);
+    A -> doCheckpoint("check_log.indk");
+    A -> doSaveModel("check_model1.indk");
+    auto snapshot = doReadFile("check_log.indk").size();
+
+    A -> doCreateNewScope();
+    A -> doLearn(S);
+    A -> doCheckpoint("check_log.indk");
+    A -> doSaveModel("check_model2.indk");
+
+    auto getResult = [&S] (const std::string& path, bool log) {
+        indk::NeuralNet N;
+        if (log) N.doLoadCheckpoint(path);
+        else N.doLoadModel(path);
+        return doRecogniseSignal(&N, S);
+    };
+    auto ref1 = getResult("check_model1.indk", false);
+    auto ref2 = getResult("check_model2.indk", false);
+    auto log = doReadFile("check_log.indk");
+    bool passed = log.size() > snapshot && isEqual(getResult("check_log.indk", true), ref2);
+
+    std::ofstream("check_log.indk", std::ios::binary | std::ios::trunc).write(log.data(), log.size()-16);
+    passed = passed && isEqual(getResult("check_log.indk", true), ref1);
+
+    std::unique_ptr<indk::NeuralNet> B(new indk::NeuralNet());
+    B -> doLoadCheckpoint("check_log.indk");
+    B -> doCreateNewScope();
+    B -> doLearn(S);
+    B -> doCheckpoint("check_log.indk");
+    passed = passed && doReadFile("check_log.indk") == log;
+
+    // the checkpoint without changes appends nothing, the deleted neuron is dropped on replay
+    B.reset(new indk::NeuralNet());
+    B -> doLoadCheckpoint("check_log.indk");
+    B -> setCheckpointCompaction(0);
+    B -> doCheckpoint("check_log.indk");
+    passed = passed && doReadFile("check_log.indk") == log;
+    B -> doDeleteNeuron("N6");
+    B -> doCheckpoint("check_log.indk");
+    {
+        indk::NeuralNet C;
+        C.doLoadCheckpoint("check_log.indk");
+        passed = passed && doReadFile("check_log.indk").size() > log.size() && !C.getNeuron("N6") && C.getStructure() == B->getStructure();
+    }
+
+    // the log that outgrows the compaction ratio is rewritten as the snapshot of the current state
+    B -> setCheckpointCompaction(0.001);
+    B -> doCreateNewScope();
+    B -> doLearn(S);
+    B -> doCheckpoint("check_log.indk");
+    B -> doCheckpoint("check_log2.indk");
+    passed = passed && doReadFile("check_log.indk") == doReadFile("check_log2.indk");
+
+    for (auto path: {"check_log.indk", "check_log2.indk", "check_model1.indk", "check_model2.indk"}) std::remove(path);
+    return passed;
+}
+
+// neurons created after many structure reloads, replications and deletions in the same net work the same
+// as the neurons of the fresh net, the neuron reset releases the learned scopes, and the arena places objects
+// one after another in the bounded blocks and keeps the last block on release
+bool doCheckArena() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    std::unique_ptr<indk::NeuralNet> B(new indk::NeuralNet());
+    for (int i = 0; i < 5; i++) {
+        B -> setStructure(doReadFile("structures/structure_general.json"));
+        for (int e = 2; e <= 4; e++) B -> doReplicateEnsemble("A1", "A"+std::to_string(e));
+        B -> doRecognise(S);
+        for (int e = 2; e <= 4; e++) {
+            for (auto N: B->getEnsemble("A"+std::to_string(e))) B -> doDeleteNeuron(N->getName());
+        }
+    }
+    B -> setStructure(doReadFile("structures/structure_general.json"));
+    B -> doReplicateEnsemble("A1", "A2");
+    B -> doLearn(X);
+    if (B->getNeuronCount() != A->getNeuronCount() || !isEqual(doRecogniseSignal(B.get(), S), ref)) return false;
+
+    // the reset releases the scope arena in bulk, the neuron gets the scopes of the fresh neuron
+    std::unique_ptr<indk::NeuralNet> F(doCreateNet(doReadFile("structures/structure_general.json"), 2));
+    auto N = B -> getNeuron("N1");
+    B -> doCreateNewScope();
+    B -> doLearn(X);
+    auto fresh = F -> getNeuron("N1") -> getStore() -> getScopeArena() -> getSize();
+    if (N->getStore()->getScopeArena()->getSize() <= fresh) return false;
+    N -> doReset();
+    if (N->getStore()->getScopeArena()->getSize() != fresh) return false;
+
+    // objects are placed one after another, blocks grow up to the maximal size, the release keeps the last block
+    indk::Arena arena;
+    if (arena.getCapacity()) return false;
+    auto first = (char*)arena.doAllocate(24, 8);
+    if ((char*)arena.doAllocate(8, 8) != first+24 || arena.getCapacity() != indk_ARENA_BLOCK_MIN) return false;
+    for (int i = 0; i < 3000; i++) {
+        if ((uintptr_t)arena.doAllocate(1000, 8)%8) return false;
+    }
+    if (arena.getSize() != 32+3000*1000 || arena.getCapacity() >= arena.getSize()+indk_ARENA_BLOCK_MAX) return false;
+    arena.doRelease();
+    auto capacity = arena.getCapacity();
+    arena.doAllocate(16, 8);
+    return arena.getSize() == 16 && capacity <= indk_ARENA_BLOCK_MAX && arena.getCapacity() == capacity;
+}
+
+// trajectory ring buffer that wraps around keeps the newest records of the full trajectory with the current
+// receptor positions last, the capture does not change the result, is disabled by default, and survives the reset
+bool doCheckTrajectory() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateLearnedNet(2));
+    auto ref = doRecogniseSignal(A.get(), S);
+
+    std::unique_ptr<indk::NeuralNet> B(doCreateLearnedNet(2)), C(doCreateLearnedNet(2));
+    B -> getNeuron("N1") -> setTrajectoryCapture(S.size()*2);
+    C -> getNeuron("N1") -> setTrajectoryCapture(16);
+    if (!isEqual(doRecogniseSignal(B.get(), S), ref) || !isEqual(doRecogniseSignal(C.get(), S), ref)) return false;
+
+    auto full = B -> getNeuron("N1") -> getTrajectory();
+    auto ring = C -> getNeuron("N1") -> getTrajectory();
+    if (full.Ticks.size() != S.size() || ring.Ticks.size() != 16 || ring.Stride != full.Stride) return false;
+    auto first = full.Ticks.size() - ring.Ticks.size();
+    if (!std::equal(ring.Ticks.begin(), ring.Ticks.end(), full.Ticks.begin()+first) ||
+        !isEqual(ring.Positions, std::vector<float>(full.Positions.begin()+first*full.Stride, full.Positions.end()), 0)) return false;
+
+    // the newest record keeps the current phantom positions of all receptors, receptor-major
+    auto N = C -> getNeuron("N1");
+    auto dimensions = N -> getDimensionsCount();
+    if (ring.Stride != (uint64_t)N->getReceptorsCount()*dimensions || !std::is_sorted(full.Ticks.begin(), full.Ticks.end())) return false;
+    for (int64_t r = 0; r < N->getReceptorsCount(); r++) {
+        for (unsigned d = 0; d < dimensions; d++) {
+            if (ring.Positions[(ring.Ticks.size()-1)*ring.Stride+r*dimensions+d] != N->getReceptor(r)->getPosf()->getPositionValue(d)) return false;
+        }
+    }
+
+    // the capture is disabled by default, the reset drops the records and keeps the capture enabled
+    if (!A->getNeuron("N1")->getTrajectory().Ticks.empty()) return false;
+    N -> doReset();
+    if (!N->getTrajectory().Ticks.empty() || N->getTrajectoryCapture() != 16) return false;
+    return true;
+}
+
+// scopes compared in one pass over the scope matrix give the same values as the receptor by receptor comparison,
+// the closest scopes are the first ones of the sorted values, and the scope matrix growth caused by one receptor
+// does not change the scopes of its siblings
+bool doCheckScopeComparison() {
+    auto S = getSignal();
+    std::unique_ptr<indk::NeuralNet> A(doCreateNet(doReadFile("structures/structure_general.json"), 2));
+    A -> doLearn(X);
+    for (int i = 1; i <= 3; i++) {
+        A -> doCreateNewScope();
+        A -> doLearn(getSignal(20*i));
+    }
+    A -> doRecognise(S);
+
+    for (auto N: A->getNeurons()) {
+        std::vector<float> ref(N->getReceptor(0)->getReferencePosScopes().size(), 0);
+        for (int64_t r = 0; r < N->getReceptorsCount(); r++) {
+            auto R = N -> getReceptor(r);
+            auto scopes = R -> getReferencePosScopes();
+            for (uint64_t i = 0; i < scopes.size(); i++) {
+                ref[i] += indk::Computer::doCompareFunction(scopes[i], R->getPosf()) / N->getReceptorsCount();
+            }
+        }
+        if (ref.size() != 4 || !isEqual(N->doCompareScopes(), ref)) return false;
+
+        std::vector<int> order(ref.size());
+        for (uint64_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&ref] (int a, int b) { return ref[a] < ref[b]; });
+        auto top = N -> doComparePatternTop(3);
+        if (top.size() != 3 || std::get<1>(top[0]) != std::get<1>(N->doComparePattern())) return false;
+        for (uint64_t i = 0; i < top.size(); i++) {
+            if (std::fabs(std::get<0>(top[i])-ref[order[i]]) > 1e-3) return false;
+        }
+        if (std::fabs(std::get<0>(N->doComparePattern())-ref[order[0]]) > 1e-3) return false;
+
+        // the new scope of one receptor grows the scope matrix, the scopes of its siblings keep their values
+        if (N->getReceptorsCount() < 2) continue;
+        std::vector<float> sibling;
+        for (auto sc: N->getReceptor(1)->getReferencePosScopes()) {
+            for (unsigned d = 0; d < N->getDimensionsCount(); d++) sibling.push_back(sc->getPositionValue(d));
+        }
+        for (int i = 0; i < 8; i++) N -> getReceptor(0) -> doCreateNewScope();
+        std::vector<float> after;
+        for (auto sc: N->getReceptor(1)->getReferencePosScopes()) {
+            for (unsigned d = 0; d < N->getDimensionsCount(); d++) after.push_back(sc->getPositionValue(d));
+        }
+        if (N->getReceptor(0)->getReferencePosScopes().size() != ref.size()+8 || !isEqual(after, sibling, 0)) return false;
+    }
+    return true;
+}
+
+std::vector<std::pair<std::string, std::function<bool()>>> checks = {
+        std::make_pair("Geometry store", doCheckGeometryStore),
+        std::make_pair("Synapse release", doCheckSynapseRelease),
+        std::make_pair("Instruction sets", doCheckInstructionSets),
+        std::make_pair("Kernel specialisation", doCheckKernelSpecialisation),
+        std::make_pair("Culling", doCheckCulling),
+        std::make_pair("Culling skin", doCheckCullingSkin),
+        std::make_pair("Execution plan", doCheckExecutionPlan),
+        std::make_pair("Entry routing", doCheckEntryRouting),
+        std::make_pair("Multithread", doCheckMultithread),
+        std::make_pair("Worker count", doCheckWorkerCount),
+        std::make_pair("Receptor parallelism", doCheckReceptorParallelism),
+        std::make_pair("Batch recognition", doCheckBatchRecognition),
+        std::make_pair("Signal matrix", doCheckSignalMatrix),
+        std::make_pair("Output table", doCheckOutputTable),
+        std::make_pair("Async transfer", doCheckAsync),
+        std::make_pair("Async control", doCheckAsyncControl),
+        std::make_pair("Runtime", doCheckRuntime),
+        std::make_pair("Signal buffers", doCheckSignalBuffers),
+        std::make_pair("Session", doCheckSession),
+        std::make_pair("Binary model", doCheckBinaryModel),
+        std::make_pair("Attached model", doCheckAttachedModel),
+        std::make_pair("Structure threads", doCheckStructureThreads),
+        std::make_pair("Streaming reader", doCheckStreamingReader),
+        std::make_pair("Lazy model", doCheckLazyModel),
+        std::make_pair("Checkpoint", doCheckCheckpoint),
+        std::make_pair("Arena", doCheckArena),
+        std::make_pair("Trajectory", doCheckTrajectory),
+        std::make_pair("Scope comparison", doCheckScopeComparison),
+};
+
+int doChecks(int InstructionSet) {
+    int count = 0;
+
+    for (auto &c: checks) {
+        indk::System::setComputeBackend(indk::System::ComputeBackends::Default);
+        indk::System::setInstructionSet(InstructionSet);
+        std::cout << std::setw(50) << std::left << c.first+": ";
+        auto T = getTimestampMS();
+        bool passed = false;
+        try {
+            passed = c.second();
+        } catch (std::exception &e) {
+            std::cout << e.what() << " ";
+        }
+        T = getTimestampMS() - T;
+        std::cout << std::setw(20) << std::left << "done ["+std::to_string(T)+" ms] ";
+        std::cout << (passed ? "[PASSED]" : "[FAILED]") << std::endl;
+        count += passed;
+    }
+    std::cout << std::endl;
+
+    return count;
+}
+
 int main() {
     constexpr unsigned STRUCTURE_COUNT                      = 2;
     constexpr float SUPERSTRUCTURE_TEST_REFERENCE_OUTPUT    = 0.0291;
     constexpr float BENCHMARK_TEST_REFERENCE_OUTPUT         = 2.7622;
-    const unsigned TOTAL_TEST_COUNT                         = STRUCTURE_COUNT*backends.size();
+    const unsigned TOTAL_TEST_COUNT                         = STRUCTURE_COUNT*backends.size() + checks.size();
 
     int count = 0;
+    auto InstructionSet = indk::System::getInstructionSet();
     indk::System::setVerbosityLevel(1);
     NN = new indk::NeuralNet();
 
@@ -105,6 +1314,9 @@ int main() {
     doLoadModel("structures/structure_bench.json", 10001);
     count += doTests("Benchmark", BENCHMARK_TEST_REFERENCE_OUTPUT);
 
+    std::cout << "=== BEHAVIOUR TESTS ===" << std::endl;
+    count += doChecks(InstructionSet);
+
     std::cout << std::endl;
     std::cout << "Tests passed: [" << count << "/" << TOTAL_TEST_COUNT << "]" << std::endl;
     delete NN;
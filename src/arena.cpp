@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        arena.cpp
+// Purpose:     Region allocator class
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <indk/arena.h>
+
+indk::Arena::Arena() {
+    Current = nullptr;
+    Free = 0;
+    BlockSize = indk_ARENA_BLOCK_MIN;
+    Size = 0;
+}
+
+/**
+ * Allocate memory in the arena.
+ * @param Bytes Size of the memory.
+ * @param Alignment Alignment of the memory, power of two not greater than alignof(std::max_align_t).
+ * @return Pointer to the memory.
+ */
+void* indk::Arena::doAllocate(uint64_t Bytes, uint64_t Alignment) {
+    auto shift = (Alignment - (uintptr_t)Current%Alignment) % Alignment;
+    if (!Current || shift+Bytes > Free) {
+        auto bsize = std::max<uint64_t>(BlockSize, Bytes);
+        Blocks.emplace_back(new char[bsize], bsize);
+        Current = Blocks.back().first;
+        Free = bsize;
+        shift = 0;
+        if (BlockSize < indk_ARENA_BLOCK_MAX) BlockSize *= 2;
+    }
+    auto data = Current + shift;
+    Current = data + Bytes;
+    Free -= shift + Bytes;
+    Size += Bytes;
+    return data;
+}
+
+/**
+ * Release all memory of the arena at once. The last (largest) block is kept for the next allocations.
+ * Objects of the arena must be destroyed before.
+ */
+void indk::Arena::doRelease() {
+    if (Blocks.empty()) return;
+    auto last = Blocks.back();
+    Blocks.pop_back();
+    for (const auto &b: Blocks) delete [] b.first;
+    Blocks.assign(1, last);
+    Current = last.first;
+    Free = last.second;
+    Size = 0;
+}
+
+/**
+ * Get size of the allocated memory.
+ * @return Size in bytes.
+ */
+uint64_t indk::Arena::getSize() const {
+    return Size;
+}
+
+/**
+ * Get size of the arena blocks.
+ * @return Size in bytes.
+ */
+uint64_t indk::Arena::getCapacity() const {
+    uint64_t capacity = 0;
+    for (const auto &b: Blocks) capacity += b.second;
+    return capacity;
+}
+
+indk::Arena::~Arena() {
+    for (const auto &b: Blocks) delete [] b.first;
+}
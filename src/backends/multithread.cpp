@@ -11,140 +11,150 @@
 #include <indk/neuron.h>
 #include <indk/system.h>
 
+namespace {
+    // index of the worker that runs the current thread, -1 for non-worker threads
+    thread_local int CurrentWorker = -1;
+}
+
 indk::ComputeBackendMultithread::ComputeBackendMultithread(int WC) {
     WorkerCount = WC;
+    Queued = 0;
+    Idle = 0;
+    Outstanding = 0;
+    Stopped = false;
     while (Workers.size() < WorkerCount) {
-        auto w = new indk::Worker;
-        w -> thread = std::thread(tWorker, (void*)w);
-        Workers.emplace_back(w);
+        Workers.emplace_back(new indk::Worker);
+    }
+    for (unsigned int w = 0; w < WorkerCount; w++) {
+        Workers[w] -> thread = std::thread(tWorker, this, w);
     }
 }
 
-// TODO: handling of cases when computing of multiple neural networks goes in parallel
+// The backend object serves one transfer at a time, neural nets sharing it are serialised by indk::Runtime
 void indk::ComputeBackendMultithread::doRegisterHost(const std::vector<void*>& objects) {
-    int last = 0;
-    for (const auto &o: objects) {
-        if (last >= Workers.size()) last = 0;
-        Workers[last] -> objects.push_back(o);
-        Workers[last] -> event = new indk::Event;
-        Workers[last] -> done = false;
-        last++;
-    }
-    for (const auto &w: Workers) {
-        w -> cv.notify_one();
+    for (const auto &t: ObjectTable) delete t.second;
+    ObjectTable.clear();
+    for (uint64_t i = 0; i < objects.size(); i++) {
+        auto task = new indk::Task;
+        task -> object = objects[i];
+        task -> worker = i % WorkerCount;
+        task -> ready = 0;
+        ObjectTable.emplace(objects[i], task);
     }
 }
 
+/**
+ * Wait until all scheduled ticks are computed. Rethrows the first exception thrown by a task.
+ */
 void indk::ComputeBackendMultithread::doWaitTarget() {
-    for (const auto &w: Workers) {
-        while (!w->done.load()) {
-            ((indk::Event*)w->event) -> doWaitTimed(100);
-        }
+    std::unique_lock<std::mutex> lk(DoneMutex);
+    DoneCV.wait(lk, [this] { return !Outstanding.load(); });
+    if (Error) {
+        auto e = Error;
+        Error = nullptr;
+        std::rethrow_exception(e);
     }
 }
 
+/**
+ * Schedule next tick of the object. Called by the object when all its inputs for the tick are received.
+ * @param object Registered object.
+ */
 void indk::ComputeBackendMultithread::doProcess(void* object) {
-}
-
-[[noreturn]] void indk::ComputeBackendMultithread::tWorker(void* object) {
-    auto worker = (indk::Worker*)object;
-
-    while (true) {
-        std::unique_lock<std::mutex> lk(worker->m);
-        worker -> cv.wait(lk);
-
-        auto zPos = new indk::Position(0, 3);
-        auto dRPos = new indk::Position(0, 3);
-        auto nRPos = new indk::Position(0, 3);
-
-        std::vector<int64_t> times;
-        int tdone = 0;
-        uint64_t size = worker -> objects.size();
-        while (tdone < size) {
-            for (uint64_t n = 0; n < size; n++) {
-                if (n >= times.size()) times.push_back(0);
-                auto N = (indk::Neuron*)worker -> objects[n];
-                auto t = times[n];
-                auto ComputeSize = N -> getSignalBufferSize();
-
-                if (t >= ComputeSize) continue;
-
-                if (N->getState(t) != indk::Neuron::States::Pending) {
-                    continue;
-                }
-
-                float FiSum, D, P = 0;
-                auto Xm = N -> getXm();
-                auto DimensionsCount = N -> getDimensionsCount();
-
-                zPos -> setXm(Xm);
-                zPos -> setDimensionsCount(DimensionsCount);
-                dRPos -> setXm(Xm);
-                dRPos -> setDimensionsCount(DimensionsCount);
-                nRPos -> setXm(Xm);
-                nRPos -> setDimensionsCount(DimensionsCount);
-
-                indk::Position *RPos;
-
-                for (int j = 0; j < N->getEntriesCount(); j++) {
-                    auto E = N -> getEntry(j);
-                    E -> doProcess();
-                }
+    auto t = ObjectTable.find(object);
+    if (t == ObjectTable.end()) return;
 
-                for (int i = 0; i < N->getReceptorsCount(); i++) {
-                    auto R = N->getReceptor(i);
-                    if (!R->isLocked()) RPos = R -> getPos();
-                    else RPos = R -> getPosf();
-                    indk::Position *SPos;
-                    std::pair<float, float> FiValues;
-                    FiSum = 0;
-                    dRPos -> doZeroPosition();
+    Outstanding++;
+    // the object is queued only once, the task runs all ticks that are ready
+    if (!t->second->ready.fetch_add(1)) doSchedule(t->second);
+}
 
-                    for (int j = 0; j < N->getEntriesCount(); j++) {
-                        auto E = N -> getEntry(j);
+void indk::ComputeBackendMultithread::setTaskHandler(const std::function<void(void*)>& TaskHandler) {
+    Handler = TaskHandler;
+}
 
-                        for (unsigned int k = 0; k < E->getSynapsesCount(); k++) {
-                            auto *S = E -> getSynapse(k);
-                            SPos = S -> getPos();
-                            D = SPos -> getDistanceFrom(RPos);
-                            FiValues = indk::Computer::getFiFunctionValue(S->getLambda(), S->getGamma(), S->getdGamma(), D);
-                            if (FiValues.second > 0) {
-                                indk::Computer::getNewPosition(nRPos, RPos, SPos, indk::Computer::getFiVectorLength(FiValues.second), D);
-                                dRPos -> doAdd(nRPos);
-                            }
-                            FiSum += FiValues.first;
-                        }
-                    }
+void indk::ComputeBackendMultithread::doSchedule(indk::Task *task) {
+    bool idle;
+    {
+        std::lock_guard<std::mutex> lk(IdleMutex);
+        // tasks scheduled by a worker stay on the same worker, others go to the worker of the object
+        Workers[CurrentWorker >= 0 ? (unsigned int)CurrentWorker : task->worker] -> tasks.push_back(task);
+        Queued++;
+        idle = Idle;
+    }
+    if (idle) IdleCV.notify_one();
+}
 
-                    R -> setFi(FiSum);
-                    R -> doUpdatePos(dRPos);
-                    P += indk::Computer::getReceptorInfluenceValue(R->doCheckActive(), R->getdFi(), dRPos, zPos);
-                    R -> doUpdateSensitivityValue();
-                }
-                P /= (float)N->getReceptorsCount();
+/**
+ * Take a task from the own deque (newest first) or steal one from other workers (oldest first).
+ * Blocks while all deques are empty.
+ * @param w Worker index.
+ * @return Task or nullptr if the backend is stopped.
+ */
+indk::Task* indk::ComputeBackendMultithread::doPop(unsigned int w) {
+    std::unique_lock<std::mutex> lk(IdleMutex);
+    while (!Queued && !Stopped) {
+        Idle++;
+        IdleCV.wait(lk);
+        Idle--;
+    }
+    if (Stopped) return nullptr;
+    Queued--;
 
-                N -> doFinalizeInput(P);
-                t++;
-                times[n] = t;
-                if (t >= ComputeSize) {
-                    tdone++;
-                }
-            }
-            size = worker -> objects.size();
+    if (!Workers[w]->tasks.empty()) {
+        auto task = Workers[w] -> tasks.back();
+        Workers[w] -> tasks.pop_back();
+        return task;
+    }
+    for (unsigned int i = 1; i < WorkerCount; i++) {
+        auto victim = Workers[(w+i)%WorkerCount];
+        if (!victim->tasks.empty()) {
+            auto task = victim -> tasks.front();
+            victim -> tasks.pop_front();
+            return task;
         }
+    }
+    return nullptr;
+}
 
-        delete zPos;
-        delete nRPos;
-        delete dRPos;
+void indk::ComputeBackendMultithread::doRun(indk::Task *task) {
+    int64_t ready;
+    do {
+        try {
+            if (Handler) Handler(task->object);
+            else ((indk::Neuron*)task->object) -> doProcess();
+        } catch (...) {
+            std::lock_guard<std::mutex> lk(DoneMutex);
+            if (!Error) Error = std::current_exception();
+        }
+        ready = task -> ready.fetch_sub(1);
+        if (Outstanding.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lk(DoneMutex);
+            DoneCV.notify_all();
+        }
+    } while (ready > 1);
+}
 
-        worker -> done.store(true);
-        ((indk::Event*)worker->event) -> doNotifyOne();
-    }
+void indk::ComputeBackendMultithread::tWorker(indk::ComputeBackendMultithread *backend, unsigned int w) {
+    CurrentWorker = w;
+    while (auto task = backend->doPop(w)) backend -> doRun(task);
 }
 
 void indk::ComputeBackendMultithread::doUnregisterHost() {
-    for (const auto &w: Workers) {
-        w -> objects.clear();
-        delete (indk::Event*)w->event;
+    for (const auto &t: ObjectTable) delete t.second;
+    ObjectTable.clear();
+    Handler = nullptr;
+}
+
+indk::ComputeBackendMultithread::~ComputeBackendMultithread() {
+    {
+        std::lock_guard<std::mutex> lk(IdleMutex);
+        Stopped = true;
+    }
+    IdleCV.notify_all();
+    for (auto w: Workers) {
+        w -> thread.join();
+        delete w;
     }
+    doUnregisterHost();
 }
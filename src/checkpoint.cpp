@@ -0,0 +1,136 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        checkpoint.cpp
+// Purpose:     Checkpoint log class
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <fstream>
+#include <indk/checkpoint.h>
+#include <indk/model.h>
+#include <indk/error.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+indk::Checkpoint::Checkpoint() {
+    Size = 0;
+}
+
+/**
+ * Open checkpoint log.
+ * @param Path Path to the log file.
+ */
+indk::Checkpoint::Checkpoint(const std::string& Path): Checkpoint() {
+    doOpen(Path);
+}
+
+/**
+ * Read checkpoint log. The log is read to the internal buffer, record data is used in place.
+ * @param Path Path to the log file.
+ */
+void indk::Checkpoint::doOpen(const std::string& Path) {
+    Records.clear();
+    Buffer.clear();
+    Size = 0;
+
+    std::ifstream stream(Path, std::ios::binary | std::ios::ate);
+    if (!stream.is_open()) throw indk::Error(indk::Error::EX_CHECKPOINT_IO);
+    uint64_t fsize = stream.tellg();
+    stream.seekg(0);
+    Buffer.resize((fsize+indk_MODEL_ALIGNMENT)/sizeof(uint64_t)+1);
+    auto data = (char*)Buffer.data();
+    data += (indk_MODEL_ALIGNMENT - (uintptr_t)data%indk_MODEL_ALIGNMENT) % indk_MODEL_ALIGNMENT;
+    stream.read(data, fsize);
+    if (!stream.good()) throw indk::Error(indk::Error::EX_CHECKPOINT_IO);
+
+    auto header = (const indk::Checkpoint::Header*)data;
+    if (fsize < sizeof(indk::Checkpoint::Header) || memcmp(header->Magic, indk_CHECKPOINT_MAGIC, sizeof(indk_CHECKPOINT_MAGIC)) != 0 ||
+        header->Version != indk_CHECKPOINT_VERSION || header->ByteOrder != indk_MODEL_BYTE_ORDER)
+        throw indk::Error(indk::Error::EX_CHECKPOINT_FORMAT);
+
+    // the log ends at the first record that was not completely written
+    Size = getRecordSize(0);
+    while (Size+sizeof(indk::Checkpoint::RecordHeader) <= fsize) {
+        auto rheader = (const indk::Checkpoint::RecordHeader*)(data+Size);
+        if (rheader->Type < SnapshotRecord || rheader->Type > DeleteRecord) break;
+        if (rheader->Size > fsize || Size+getRecordSize(rheader->Size) > fsize) break;
+        Records.push_back({rheader->Type, rheader->Flags, data+Size+getRecordSize(0), rheader->Size});
+        Size += getRecordSize(rheader->Size);
+    }
+}
+
+/**
+ * Create empty checkpoint log. Existing file is replaced.
+ * @param Path Path to the log file.
+ */
+void indk::Checkpoint::doCreate(const std::string& Path) {
+    std::vector<char> data(getRecordSize(0), 0);
+    auto header = (indk::Checkpoint::Header*)data.data();
+    memcpy(header->Magic, indk_CHECKPOINT_MAGIC, sizeof(indk_CHECKPOINT_MAGIC));
+    header->Version = indk_CHECKPOINT_VERSION;
+    header->ByteOrder = indk_MODEL_BYTE_ORDER;
+
+    std::ofstream stream(Path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) throw indk::Error(indk::Error::EX_CHECKPOINT_IO);
+    stream.write(data.data(), data.size());
+    if (!stream.good()) throw indk::Error(indk::Error::EX_CHECKPOINT_IO);
+}
+
+/**
+ * Append the record to the checkpoint log. Data after the end of the log (the record that was not completely
+ * written) is replaced.
+ * @param Path Path to the log file.
+ * @param Offset End of the log (see getSize).
+ * @param Type Record type.
+ * @param Flags Record flags.
+ * @param Data Record data.
+ * @param DataSize Size of the record data.
+ * @return New end of the log.
+ */
+uint64_t indk::Checkpoint::doAppend(const std::string& Path, uint64_t Offset, uint32_t Type, uint32_t Flags, const void *Data, uint64_t DataSize) {
+    std::vector<char> header(getRecordSize(0), 0);
+    auto rheader = (indk::Checkpoint::RecordHeader*)header.data();
+    rheader->Type = Type;
+    rheader->Flags = Flags;
+    rheader->Size = DataSize;
+    std::vector<char> padding(getRecordSize(DataSize)-header.size()-DataSize, 0);
+
+#ifndef _WIN32
+    if (truncate(Path.c_str(), Offset) != 0) throw indk::Error(indk::Error::EX_CHECKPOINT_IO);
+#endif
+    std::fstream stream(Path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!stream.is_open()) throw indk::Error(indk::Error::EX_CHECKPOINT_IO);
+    stream.seekp(Offset);
+    stream.write(header.data(), header.size());
+    stream.write((const char*)Data, DataSize);
+    stream.write(padding.data(), padding.size());
+    stream.flush();
+    if (!stream.good()) throw indk::Error(indk::Error::EX_CHECKPOINT_IO);
+    return Offset + getRecordSize(DataSize);
+}
+
+/**
+ * Get size of the record in the log.
+ * @param DataSize Size of the record data.
+ * @return Size of the record header and data aligned to indk_MODEL_ALIGNMENT bytes.
+ */
+uint64_t indk::Checkpoint::getRecordSize(uint64_t DataSize) {
+    return indk_MODEL_ALIGNMENT + (DataSize+indk_MODEL_ALIGNMENT-1) / indk_MODEL_ALIGNMENT * indk_MODEL_ALIGNMENT;
+}
+
+const std::vector<indk::Checkpoint::Record>& indk::Checkpoint::getRecords() const {
+    return Records;
+}
+
+/**
+ * Get end of the log.
+ * @return Size of the header and all completely written records.
+ */
+uint64_t indk::Checkpoint::getSize() const {
+    return Size;
+}
@@ -14,6 +14,14 @@ indk::Computer::Computer() {
 
 }
 
+/**
+ * Set the function that processes registered objects instead of the plain object processing.
+ * Backends that compute objects asynchronously call it once per ready tick of the object.
+ * @param Handler Task handler function.
+ */
+void indk::Computer::setTaskHandler(const std::function<void(void*)>&) {
+}
+
 std::vector<float> indk::Computer::doCompareCPFunction(std::vector<indk::Position*> CP, std::vector<indk::Position*> CPf) {
     std::vector<float> R;
     int64_t L = CP.size();
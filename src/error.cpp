@@ -23,8 +23,6 @@ indk::Error::Error(ExceptionType _ET, std::vector<float> _ED) {
 }
 
 const char* indk::Error::what() const noexcept {
-    std::string Msg;
-    char *B;
     switch (ET) {
         case EX_NEURALNET_NEURONS:
             Msg = std::string("EX_NEURALNET_NEURONS ~ Out of neuron list");
@@ -59,10 +57,23 @@ const char* indk::Error::what() const noexcept {
         case EX_POSITION_DIMENSIONS:
             Msg = std::string("EX_POSITION_DIMENSIONS ~ Not equal space dimensions of positions");
             break;
+        case EX_NEURALNET_CANCELLED:
+            Msg = std::string("EX_NEURALNET_CANCELLED ~ The asynchronous signal transfer was cancelled");
+            break;
+        case EX_MODEL_IO:
+            Msg = std::string("EX_MODEL_IO ~ Error reading or writing the model file");
+            break;
+        case EX_MODEL_FORMAT:
+            Msg = std::string("EX_MODEL_FORMAT ~ Invalid binary model image or unsupported image version");
+            break;
+        case EX_CHECKPOINT_IO:
+            Msg = std::string("EX_CHECKPOINT_IO ~ Error reading or writing the checkpoint log");
+            break;
+        case EX_CHECKPOINT_FORMAT:
+            Msg = std::string("EX_CHECKPOINT_FORMAT ~ Invalid checkpoint log or unsupported log version");
+            break;
         default:
             Msg = std::string("No exception");
     }
-    auto *S = new char[Msg.size()];
-    sprintf(S, "%s", Msg.c_str());
-    return S;
+    return Msg.c_str();
 }
@@ -0,0 +1,107 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        executor.cpp
+// Purpose:     Bounded async task executor class
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include <indk/executor.h>
+
+/**
+ * Create executor.
+ * @param Threads Count of worker threads, 0 - hardware concurrency.
+ * @param _QueueDepth Maximal count of queued (not started) tasks, 0 - unbounded.
+ */
+indk::Executor::Executor(unsigned int Threads, unsigned int _QueueDepth) {
+    QueueDepth = _QueueDepth;
+    Stop = false;
+    if (!Threads) Threads = std::thread::hardware_concurrency();
+    if (!Threads) Threads = 1;
+    for (unsigned int i = 0; i < Threads; i++) Workers.emplace_back(&indk::Executor::doWork, this);
+}
+
+void indk::Executor::doWork() {
+    std::unique_lock<std::mutex> lk(Lock);
+    while (true) {
+        auto task = Queue.begin();
+        while (task != Queue.end() && Active.count(task->Owner)) task++;
+        if (task == Queue.end()) {
+            if (Stop && Queue.empty()) return;
+            QueueCV.wait(lk);
+            continue;
+        }
+
+        auto owner = task -> Owner;
+        auto job = std::move(task->Job);
+        Queue.erase(task);
+        Active.insert(owner);
+        SpaceCV.notify_one();
+        lk.unlock();
+
+        try {
+            job();
+        } catch (...) {}
+        job = nullptr;
+
+        lk.lock();
+        Active.erase(owner);
+        auto p = Pending.find(owner);
+        if (!--p->second) Pending.erase(p);
+        DoneCV.notify_all();
+        if (!Queue.empty()) QueueCV.notify_all();
+    }
+}
+
+/**
+ * Add task to the queue. Blocks while the queue is full, so the task must not be submitted
+ * from a task of the same executor when the queue can be full.
+ * @param Owner Owner of the task, tasks of the same owner are executed sequentially.
+ * @param Job Task function.
+ */
+void indk::Executor::doSubmit(const void *Owner, const std::function<void()>& Job) {
+    std::unique_lock<std::mutex> lk(Lock);
+    SpaceCV.wait(lk, [this] { return !QueueDepth || Queue.size() < QueueDepth; });
+    Queue.push_back({Owner, Job});
+    Pending[Owner]++;
+    QueueCV.notify_one();
+}
+
+/**
+ * Wait until all submitted tasks of the owner are done.
+ * @param Owner Owner of the tasks.
+ */
+void indk::Executor::doWait(const void *Owner) {
+    std::unique_lock<std::mutex> lk(Lock);
+    DoneCV.wait(lk, [this, Owner] { return !Pending.count(Owner); });
+}
+
+/**
+ * Check if the owner has queued or running tasks.
+ * @param Owner Owner of the tasks.
+ */
+bool indk::Executor::isPending(const void *Owner) {
+    std::lock_guard<std::mutex> lk(Lock);
+    return Pending.count(Owner);
+}
+
+unsigned int indk::Executor::getThreadsCount() const {
+    return Workers.size();
+}
+
+unsigned int indk::Executor::getQueueDepth() const {
+    return QueueDepth;
+}
+
+/**
+ * Finish all queued tasks and stop the worker threads.
+ */
+indk::Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> lk(Lock);
+        Stop = true;
+    }
+    QueueCV.notify_all();
+    for (auto &w: Workers) w.join();
+}
@@ -0,0 +1,695 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        kernel.cpp
+// Purpose:     CPU compute kernels
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <indk/kernel.h>
+#include <indk/system.h>
+#include <indk/error.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define indk_KERNEL_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define indk_KERNEL_TARGET(ISA) __attribute__((target(ISA)))
+#else
+    #define indk_KERNEL_TARGET(ISA)
+#endif
+
+namespace {
+    // Kernels are instantiated for 2 and 3 dimensions, DC = 0 is the generic variant
+    // that takes the dimension count from the neuron at runtime.
+    template <unsigned DC>
+    class Coordinates {
+    private:
+        float Values[DC];
+    public:
+        explicit Coordinates(unsigned int) : Values() {}
+        float* data() { return Values; }
+    };
+
+    template <>
+    class Coordinates<0> {
+    private:
+        std::vector<float> Values;
+    public:
+        explicit Coordinates(unsigned int DimensionsCount) : Values(DimensionsCount, 0) {}
+        float* data() { return Values.data(); }
+    };
+
+    template <unsigned DC>
+    inline unsigned int getDimensionsCount(const indk::Neuron::Store *NS) {
+        return DC ? DC : NS->getDimensionsCount();
+    }
+
+    inline void doCheckRange(float Max, const float *dRPos, unsigned int DimensionsCount, float Xm) {
+        if (Max > Xm) {
+            throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {Max, Xm});
+        }
+        for (unsigned int d = 0; d < DimensionsCount; d++) {
+            if (dRPos[d] > Xm) {
+                throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {dRPos[d], Xm});
+            }
+        }
+    }
+
+    // Dense synapse range of the store: culled kernels iterate over neighbour index lists instead.
+    class SynapseRange {
+    private:
+        uint64_t Count;
+    public:
+        explicit SynapseRange(uint64_t SynapsesCount) : Count(SynapsesCount) {}
+        uint64_t size() const { return Count; }
+        uint64_t operator[](uint64_t i) const { return i; }
+    };
+
+    template <unsigned DC, typename Range>
+    float doInteractRange(const indk::Neuron::Store *NS, const Range &Synapses, const float *RPos, float *dRPos) {
+        const auto DimensionsCount = getDimensionsCount<DC>(NS);
+        auto Stride = NS -> getSynapsesCapacity();
+        auto SPos = NS -> getSynapsePos(0);
+        auto Lambda = NS -> getLambda();
+        auto Gamma = NS -> getGamma();
+        auto dGamma = NS -> getdGamma();
+        float FiSum = 0, Max = 0;
+
+        for (unsigned int d = 0; d < DimensionsCount; d++) dRPos[d] = 0;
+
+        for (uint64_t i = 0; i < Synapses.size(); i++) {
+            uint64_t k = Synapses[i];
+            float D = 0;
+            for (unsigned int d = 0; d < DimensionsCount; d++) {
+                auto v = SPos[d*Stride+k] - RPos[d];
+                D += v * v;
+            }
+            D = std::sqrt(D);
+
+            auto FiValues = indk::Computer::getFiFunctionValue(Lambda[k], Gamma[k], dGamma[k], D);
+            if (FiValues.second > 0) {
+                auto FiL = indk::Computer::getFiVectorLength(FiValues.second);
+                for (unsigned int d = 0; d < DimensionsCount; d++) {
+                    auto v = (RPos[d] - SPos[d*Stride+k]) / D * FiL;
+                    dRPos[d] += v;
+                    if (v > Max) Max = v;
+                }
+            }
+            FiSum += FiValues.first;
+        }
+
+        doCheckRange(Max, dRPos, DimensionsCount, NS->getXm());
+        return FiSum;
+    }
+
+    template <unsigned DC>
+    float doInteractScalar(const indk::Neuron::Store *NS, const float *RPos, float *dRPos) {
+        return doInteractRange<DC>(NS, SynapseRange(NS->getSynapsesCount()), RPos, dRPos);
+    }
+
+#ifdef indk_KERNEL_X86
+    // Vectorized exp (Cephes expf polynomial), accurate to a couple of ulp on the whole float range.
+    constexpr float EXP_HI         = 88.3762626647949f;
+    constexpr float EXP_LO         = -88.3762626647949f;
+    constexpr float EXP_LOG2E      = 1.44269504088896341f;
+    constexpr float EXP_C1         = 0.693359375f;
+    constexpr float EXP_C2         = -2.12194440e-4f;
+    constexpr float EXP_P0         = 1.9875691500E-4f;
+    constexpr float EXP_P1         = 1.3981999507E-3f;
+    constexpr float EXP_P2         = 8.3334519073E-3f;
+    constexpr float EXP_P3         = 4.1665795894E-2f;
+    constexpr float EXP_P4         = 1.6666665459E-1f;
+    constexpr float EXP_P5         = 5.0000001201E-1f;
+
+    // Per-dimension vector accumulators: stack array for the specialised kernels, thread buffer for the generic one.
+    template <unsigned DC, unsigned W>
+    class Accumulators {
+    private:
+        float Values[DC*W];
+    public:
+        explicit Accumulators(unsigned int) : Values() {}
+        float* data() { return Values; }
+    };
+
+    template <unsigned W>
+    class Accumulators<0, W> {
+    private:
+        float *Values;
+    public:
+        explicit Accumulators(unsigned int DimensionsCount) {
+            thread_local std::vector<float> Buffer;
+            Buffer.assign(DimensionsCount*W, 0);
+            Values = Buffer.data();
+        }
+        float* data() { return Values; }
+    };
+
+    indk_KERNEL_TARGET("sse4.2")
+    inline __m128 doExpSSE(__m128 x) {
+        x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(EXP_LO)), _mm_set1_ps(EXP_HI));
+        __m128 fx = _mm_floor_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2E)), _mm_set1_ps(0.5f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C1)));
+        x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C2)));
+        __m128 y = _mm_set1_ps(EXP_P0);
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P1));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P2));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P3));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P4));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P5));
+        y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, _mm_mul_ps(x, x)), x), _mm_set1_ps(1.f));
+        __m128i n = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(0x7f));
+        return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(n, 23)));
+    }
+
+    indk_KERNEL_TARGET("sse4.2")
+    inline float doHorizontalSumSSE(__m128 v) {
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+        return _mm_cvtss_f32(v);
+    }
+
+    indk_KERNEL_TARGET("sse4.2")
+    inline float doHorizontalMaxSSE(__m128 v) {
+        v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+        return _mm_cvtss_f32(v);
+    }
+
+    indk_KERNEL_TARGET("sse4.2")
+    inline void doInteractBlockSSE(const float *SPos, uint64_t Stride, const float *Lambda, const float *Gamma, const float *dGamma,
+                                   const float *RPos, unsigned int DimensionsCount, float *Acc, __m128 &vFiSum, __m128 &vMax) {
+        const __m128 zero = _mm_setzero_ps();
+        __m128 vD = zero;
+        for (unsigned int d = 0; d < DimensionsCount; d++) {
+            __m128 v = _mm_sub_ps(_mm_load_ps(SPos+d*Stride), _mm_set1_ps(RPos[d]));
+            vD = _mm_add_ps(vD, _mm_mul_ps(v, v));
+        }
+        vD = _mm_sqrt_ps(vD);
+
+        __m128 vLambda = _mm_load_ps(Lambda);
+        __m128 vE = _mm_mul_ps(vLambda, doExpSSE(_mm_mul_ps(_mm_sub_ps(zero, vLambda), vD)));
+        vFiSum = _mm_add_ps(vFiSum, _mm_mul_ps(_mm_load_ps(Gamma), vE));
+
+        __m128 vdFi = _mm_mul_ps(_mm_load_ps(dGamma), vE);
+        __m128 mask = _mm_cmpgt_ps(vdFi, zero);
+        if (!_mm_movemask_ps(mask)) return;
+
+        __m128 vFiL = _mm_sqrt_ps(_mm_and_ps(mask, vdFi));
+        for (unsigned int d = 0; d < DimensionsCount; d++) {
+            __m128 v = _mm_div_ps(_mm_sub_ps(_mm_set1_ps(RPos[d]), _mm_load_ps(SPos+d*Stride)), vD);
+            v = _mm_and_ps(mask, _mm_mul_ps(v, vFiL));
+            _mm_storeu_ps(Acc+d*4, _mm_add_ps(_mm_loadu_ps(Acc+d*4), v));
+            vMax = _mm_max_ps(vMax, v);
+        }
+    }
+
+    template <unsigned DC>
+    indk_KERNEL_TARGET("sse4.2")
+    float doInteractSSE(const indk::Neuron::Store *NS, const float *RPos, float *dRPos) {
+        const auto DimensionsCount = getDimensionsCount<DC>(NS);
+        auto SynapsesCount = NS -> getSynapsesCount();
+        auto Stride = NS -> getSynapsesCapacity();
+        auto SPos = NS -> getSynapsePos(0);
+        auto Lambda = NS -> getLambda();
+        auto Gamma = NS -> getGamma();
+        auto dGamma = NS -> getdGamma();
+        __m128 vFiSum = _mm_setzero_ps(), vMax = _mm_setzero_ps();
+        Accumulators<DC, 4> Acc(DimensionsCount);
+
+        // rows are padded to the multiple of 16 with zero lambda values, so there is no scalar tail
+        for (uint64_t k = 0; k < SynapsesCount; k += 8) {
+            doInteractBlockSSE(SPos+k, Stride, Lambda+k, Gamma+k, dGamma+k, RPos, DimensionsCount, Acc.data(), vFiSum, vMax);
+            doInteractBlockSSE(SPos+k+4, Stride, Lambda+k+4, Gamma+k+4, dGamma+k+4, RPos, DimensionsCount, Acc.data(), vFiSum, vMax);
+        }
+
+        for (unsigned int d = 0; d < DimensionsCount; d++) dRPos[d] = doHorizontalSumSSE(_mm_loadu_ps(Acc.data()+d*4));
+        doCheckRange(doHorizontalMaxSSE(vMax), dRPos, DimensionsCount, NS->getXm());
+        return doHorizontalSumSSE(vFiSum);
+    }
+
+    indk_KERNEL_TARGET("avx2,fma")
+    inline __m256 doExpAVX2(__m256 x) {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_LO)), _mm256_set1_ps(EXP_HI));
+        __m256 fx = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(EXP_LOG2E), _mm256_set1_ps(0.5f)));
+        x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(EXP_C1), x);
+        x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(EXP_C2), x);
+        __m256 y = _mm256_set1_ps(EXP_P0);
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P1));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P2));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P3));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P4));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P5));
+        y = _mm256_add_ps(_mm256_fmadd_ps(y, _mm256_mul_ps(x, x), x), _mm256_set1_ps(1.f));
+        __m256i n = _mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(0x7f));
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(n, 23)));
+    }
+
+    indk_KERNEL_TARGET("avx2,fma")
+    inline float doHorizontalSumAVX2(__m256 v) {
+        __m128 r = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        r = _mm_add_ps(r, _mm_movehl_ps(r, r));
+        r = _mm_add_ss(r, _mm_shuffle_ps(r, r, 1));
+        return _mm_cvtss_f32(r);
+    }
+
+    indk_KERNEL_TARGET("avx2,fma")
+    inline float doHorizontalMaxAVX2(__m256 v) {
+        __m128 r = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        r = _mm_max_ps(r, _mm_movehl_ps(r, r));
+        r = _mm_max_ss(r, _mm_shuffle_ps(r, r, 1));
+        return _mm_cvtss_f32(r);
+    }
+
+    template <unsigned DC>
+    indk_KERNEL_TARGET("avx2,fma")
+    float doInteractAVX2(const indk::Neuron::Store *NS, const float *RPos, float *dRPos) {
+        const auto DimensionsCount = getDimensionsCount<DC>(NS);
+        auto SynapsesCount = NS -> getSynapsesCount();
+        auto Stride = NS -> getSynapsesCapacity();
+        auto SPos = NS -> getSynapsePos(0);
+        auto Lambda = NS -> getLambda();
+        auto Gamma = NS -> getGamma();
+        auto dGamma = NS -> getdGamma();
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 vFiSum = zero, vMax = zero;
+        Accumulators<DC, 8> Acc(DimensionsCount);
+
+        // rows are padded to the multiple of 16 with zero lambda values, so there is no scalar tail
+        for (uint64_t k = 0; k < SynapsesCount; k += 8) {
+            __m256 vD = zero;
+            for (unsigned int d = 0; d < DimensionsCount; d++) {
+                __m256 v = _mm256_sub_ps(_mm256_load_ps(SPos+d*Stride+k), _mm256_set1_ps(RPos[d]));
+                vD = _mm256_fmadd_ps(v, v, vD);
+            }
+            vD = _mm256_sqrt_ps(vD);
+
+            __m256 vLambda = _mm256_load_ps(Lambda+k);
+            __m256 vE = _mm256_mul_ps(vLambda, doExpAVX2(_mm256_mul_ps(_mm256_sub_ps(zero, vLambda), vD)));
+            vFiSum = _mm256_fmadd_ps(_mm256_load_ps(Gamma+k), vE, vFiSum);
+
+            __m256 vdFi = _mm256_mul_ps(_mm256_load_ps(dGamma+k), vE);
+            __m256 mask = _mm256_cmp_ps(vdFi, zero, _CMP_GT_OQ);
+            if (!_mm256_movemask_ps(mask)) continue;
+
+            __m256 vFiL = _mm256_sqrt_ps(_mm256_and_ps(mask, vdFi));
+            for (unsigned int d = 0; d < DimensionsCount; d++) {
+                __m256 v = _mm256_div_ps(_mm256_sub_ps(_mm256_set1_ps(RPos[d]), _mm256_load_ps(SPos+d*Stride+k)), vD);
+                v = _mm256_and_ps(mask, _mm256_mul_ps(v, vFiL));
+                _mm256_storeu_ps(Acc.data()+d*8, _mm256_add_ps(_mm256_loadu_ps(Acc.data()+d*8), v));
+                vMax = _mm256_max_ps(vMax, v);
+            }
+        }
+
+        for (unsigned int d = 0; d < DimensionsCount; d++) dRPos[d] = doHorizontalSumAVX2(_mm256_loadu_ps(Acc.data()+d*8));
+        doCheckRange(doHorizontalMaxAVX2(vMax), dRPos, DimensionsCount, NS->getXm());
+        return doHorizontalSumAVX2(vFiSum);
+    }
+#endif
+
+    int doDetectInstructionSet() {
+#if defined(indk_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return indk::System::InstructionSets::InstructionSetAVX2;
+        if (__builtin_cpu_supports("sse4.2"))
+            return indk::System::InstructionSets::InstructionSetSSE42;
+#elif defined(indk_KERNEL_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        bool sse42 = info[2] & (1 << 20);
+        bool fma = info[2] & (1 << 12);
+        bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        bool avx2 = info[1] & (1 << 5);
+        if (avx && avx2 && fma)
+            return indk::System::InstructionSets::InstructionSetAVX2;
+        if (sse42)
+            return indk::System::InstructionSets::InstructionSetSSE42;
+#endif
+        return indk::System::InstructionSets::InstructionSetScalar;
+    }
+
+    template <unsigned DC>
+    indk::Kernel::InteractionFunction getInteractionFunction(int InstructionSet) {
+        switch (InstructionSet) {
+#ifdef indk_KERNEL_X86
+            case indk::System::InstructionSets::InstructionSetAVX2:
+                return doInteractAVX2<DC>;
+            case indk::System::InstructionSets::InstructionSetSSE42:
+                return doInteractSSE<DC>;
+#endif
+            default:
+                return doInteractScalar<DC>;
+        }
+    }
+
+    // Instruction set and kernels are selected on first use, so they do not depend on the order
+    // of static initialisation of the translation units.
+    int getSupportedInstructionSet() {
+        static const int SupportedInstructionSet = doDetectInstructionSet();
+        return SupportedInstructionSet;
+    }
+
+    std::atomic<int>& getCurrentInstructionSet() {
+        static std::atomic<int> CurrentInstructionSet(getSupportedInstructionSet());
+        return CurrentInstructionSet;
+    }
+
+    template <unsigned DC>
+    struct Interaction {
+        // the kernel may be replaced by indk::Kernel::setInstructionSet while the workers compute
+        static std::atomic<indk::Kernel::InteractionFunction>& getCurrent() {
+            static std::atomic<indk::Kernel::InteractionFunction> Current(getInteractionFunction<DC>(getCurrentInstructionSet()));
+            return Current;
+        }
+    };
+
+    template <unsigned DC>
+    inline bool isInScope(const indk::Position *RPos, const float *dRPos, const std::vector<indk::Position*> &Scopes, unsigned int DimensionsCount, float Xm) {
+        Coordinates<DC> NPosValues(DimensionsCount);
+        auto NPos = NPosValues.data();
+        for (unsigned int d = 0; d < DimensionsCount; d++) {
+            NPos[d] = RPos->getPositionValue(d) + dRPos[d];
+            if (NPos[d] > Xm) {
+                throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {NPos[d], Xm});
+            }
+        }
+
+        float dmin = -1;
+        for (auto s: Scopes) {
+            float D = 0;
+            for (unsigned int d = 0; d < DimensionsCount; d++) {
+                auto v = NPos[d] - s->getPositionValue(d);
+                D += v * v;
+            }
+            D = std::sqrt(D);
+            if (dmin == -1 || D <= dmin) dmin = D;
+        }
+        return dmin <= 10e-6;
+    }
+
+    // Threads that share the receptor loop of large neurons. One neuron is split at a time,
+    // neurons that find the pool busy are processed by the calling thread only.
+    class ReceptorPool {
+    private:
+        std::vector<std::thread> Threads;
+        std::mutex JobMutex, m;
+        std::condition_variable cv, DoneCV;
+        const std::function<void(int64_t, int64_t)> *Job = nullptr;
+        int64_t Count = 0, Chunk = 1;
+        std::atomic<int64_t> Next{0};
+        uint64_t Generation = 0;
+        unsigned int Running = 0;
+        bool Stopped = false;
+
+        void doWork() {
+            while (true) {
+                auto begin = Next.fetch_add(Chunk);
+                if (begin >= Count) break;
+                (*Job)(begin, std::min(begin+Chunk, Count));
+            }
+        }
+
+        void tWorker() {
+            uint64_t generation = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lk(m);
+                    cv.wait(lk, [this, generation] { return Stopped || Generation != generation; });
+                    if (Stopped) return;
+                    generation = Generation;
+                }
+                doWork();
+                std::lock_guard<std::mutex> lk(m);
+                if (!--Running) DoneCV.notify_one();
+            }
+        }
+
+        void doStop() {
+            {
+                std::lock_guard<std::mutex> lk(m);
+                Stopped = true;
+            }
+            cv.notify_all();
+            for (auto &t: Threads) t.join();
+            Threads.clear();
+            Stopped = false;
+        }
+    public:
+        void setThreads(unsigned int Count) {
+            std::lock_guard<std::mutex> jl(JobMutex);
+            doStop();
+            while (Threads.size()+1 < Count) Threads.emplace_back(&ReceptorPool::tWorker, this);
+        }
+
+        unsigned int getThreads() const {
+            return Threads.size() + 1;
+        }
+
+        /**
+         * Run the job over [0, Count) split into chunks, the calling thread takes part in the work.
+         * @return False if the pool is busy with another job or has no threads.
+         */
+        bool doRun(int64_t JobCount, const std::function<void(int64_t, int64_t)>& JobFunction) {
+            std::unique_lock<std::mutex> jl(JobMutex, std::try_to_lock);
+            if (!jl.owns_lock() || Threads.empty()) return false;
+            {
+                std::lock_guard<std::mutex> lk(m);
+                Job = &JobFunction;
+                Count = JobCount;
+                Chunk = std::max<int64_t>(1, JobCount/((int64_t)getThreads()*4));
+                Next = 0;
+                Running = Threads.size();
+                Generation++;
+            }
+            cv.notify_all();
+            doWork();
+            std::unique_lock<std::mutex> lk(m);
+            DoneCV.wait(lk, [this] { return !Running; });
+            return true;
+        }
+
+        ~ReceptorPool() {
+            doStop();
+        }
+    };
+
+    ReceptorPool Pool;
+    std::atomic<uint64_t> ReceptorWorkThreshold(indk_KERNEL_RECEPTOR_WORK_THRESHOLD);
+
+    /**
+     * Move one receptor.
+     * @return Receptor contribution to the neuron output.
+     */
+    template <unsigned DC, int ProcessingMode, bool Culling>
+    inline float doProcessReceptor(indk::Neuron *N, int64_t i, unsigned int DimensionsCount, float *RPos, float *dRPos) {
+        auto NS = N -> getStore();
+        auto R = N -> getReceptor(i);
+        auto Locked = R -> isLocked();
+        float FiSum;
+
+        if (ProcessingMode == indk::Neuron::ProcessingModeAutoReset && Locked) {
+            R -> doPrepare();
+        }
+
+        auto Pos = Locked ? R->getPosf() : R->getPos();
+        Pos -> getPositionValues(RPos);
+        if (Culling) FiSum = doInteractRange<DC>(NS, NS->getNeighbours(R->getRID(), RPos), RPos, dRPos);
+        else FiSum = Interaction<DC>::getCurrent().load(std::memory_order_relaxed)(NS, RPos, dRPos);
+
+        if (ProcessingMode == indk::Neuron::ProcessingModeAutoRollback && Locked) {
+            if (!isInScope<DC>(Pos, dRPos, R->getReferencePosScopes(), DimensionsCount, N->getXm()))
+                return 0;
+        }
+
+        return R -> doMove(dRPos, FiSum);
+    }
+
+    /**
+     * Move receptors of the neuron using the receptor pool.
+     * @return False if the pool was busy and nothing was done.
+     */
+    template <unsigned DC, int ProcessingMode, bool Culling>
+    bool doProcessReceptorsParallel(indk::Neuron *N, unsigned int DimensionsCount, float &P) {
+        auto RCount = N -> getReceptorsCount();
+        std::vector<float> Contributions(RCount, 0);
+        std::mutex ErrorMutex;
+        std::exception_ptr Error;
+        int64_t ErrorIndex = RCount;
+
+        // neighbour lists of different receptors are built concurrently over the same grid
+        if (Culling) N -> getStore() -> doUpdateIndex();
+
+        std::function<void(int64_t, int64_t)> Job = [&] (int64_t Begin, int64_t End) {
+            Coordinates<DC> RPosValues(DimensionsCount), dRPosValues(DimensionsCount);
+            auto RPos = RPosValues.data();
+            auto dRPos = dRPosValues.data();
+            for (auto i = Begin; i < End; i++) {
+                try {
+                    Contributions[i] = doProcessReceptor<DC, ProcessingMode, Culling>(N, i, DimensionsCount, RPos, dRPos);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lk(ErrorMutex);
+                    if (i < ErrorIndex) {
+                        ErrorIndex = i;
+                        Error = std::current_exception();
+                    }
+                    return;
+                }
+            }
+        };
+        if (!Pool.doRun(RCount, Job)) return false;
+        if (Error) std::rethrow_exception(Error);
+
+        // deterministic reduction in receptor order
+        for (auto c: Contributions) P += c;
+        return true;
+    }
+
+    template <unsigned DC, int ProcessingMode, bool Culling>
+    void doProcessNeuron(indk::Neuron *N) {
+        auto NS = N -> getStore();
+        const auto DimensionsCount = getDimensionsCount<DC>(NS);
+        auto RCount = N -> getReceptorsCount();
+        float P = 0;
+
+        for (int j = 0; j < N->getEntriesCount(); j++) {
+            N -> getEntry(j) -> doProcess();
+        }
+
+        auto Work = (uint64_t)NS->getSynapsesCount() * RCount * DimensionsCount;
+        auto Parallel = RCount > 1 && Work >= ReceptorWorkThreshold.load() && Pool.getThreads() > 1 &&
+                        doProcessReceptorsParallel<DC, ProcessingMode, Culling>(N, DimensionsCount, P);
+
+        if (!Parallel) {
+            Coordinates<DC> RPosValues(DimensionsCount), dRPosValues(DimensionsCount);
+            auto RPos = RPosValues.data();
+            auto dRPos = dRPosValues.data();
+
+            for (int64_t i = 0; i < RCount; i++) {
+                P += doProcessReceptor<DC, ProcessingMode, Culling>(N, i, DimensionsCount, RPos, dRPos);
+            }
+        }
+        P /= (float)RCount;
+
+        N -> doFinalizeInput(P);
+
+        if (ProcessingMode == indk::Neuron::ProcessingModeAutoRollback && N->isLearned()) {
+            if (P == 0) {
+                for (int j = 0; j < N->getEntriesCount(); j++) {
+                    N -> getEntry(j) -> doRollback();
+                }
+            }
+        } else if (ProcessingMode == indk::Neuron::ProcessingModeAutoReset && N->isLearned()) {
+            for (int j = 0; j < N->getEntriesCount(); j++) {
+                N -> getEntry(j) -> doFinalize();
+            }
+        }
+    }
+
+    template <unsigned DC, bool Culling>
+    indk::Kernel::ProcessFunction getProcessFunction(int ProcessingMode) {
+        switch (ProcessingMode) {
+            case indk::Neuron::ProcessingModeAutoReset:
+                return doProcessNeuron<DC, indk::Neuron::ProcessingModeAutoReset, Culling>;
+            case indk::Neuron::ProcessingModeAutoRollback:
+                return doProcessNeuron<DC, indk::Neuron::ProcessingModeAutoRollback, Culling>;
+            default:
+                return doProcessNeuron<DC, indk::Neuron::ProcessingModeDefault, Culling>;
+        }
+    }
+
+    template <unsigned DC>
+    indk::Kernel::ProcessFunction getProcessFunction(int ProcessingMode, bool Culling) {
+        return Culling ? getProcessFunction<DC, true>(ProcessingMode) : getProcessFunction<DC, false>(ProcessingMode);
+    }
+}
+
+/**
+ * Get neuron processing kernel specialised for the dimensions count and processing mode.
+ * @param DimensionsCount Neuron space dimensions count.
+ * @param ProcessingMode Neuron processing mode.
+ * @param Culling Use receptor neighbour lists instead of the whole synapse set.
+ * @return Processing kernel function.
+ */
+indk::Kernel::ProcessFunction indk::Kernel::getProcessFunction(unsigned int DimensionsCount, int ProcessingMode, bool Culling) {
+    switch (DimensionsCount) {
+        case 2:
+            return ::getProcessFunction<2>(ProcessingMode, Culling);
+        case 3:
+            return ::getProcessFunction<3>(ProcessingMode, Culling);
+        default:
+            return ::getProcessFunction<0>(ProcessingMode, Culling);
+    }
+}
+
+/**
+ * Compute the influence of all neuron synapses on the receptor.
+ * @param NS Packed neuron storage.
+ * @param RPos Receptor coordinates.
+ * @param dRPos Output receptor displacement coordinates.
+ * @return Sum of neurotransmitter levels (Fi) at the receptor position.
+ */
+float indk::Kernel::doInteract(const indk::Neuron::Store *NS, const float *RPos, float *dRPos) {
+    switch (NS->getDimensionsCount()) {
+        case 2:
+            return Interaction<2>::getCurrent().load(std::memory_order_relaxed)(NS, RPos, dRPos);
+        case 3:
+            return Interaction<3>::getCurrent().load(std::memory_order_relaxed)(NS, RPos, dRPos);
+        default:
+            return Interaction<0>::getCurrent().load(std::memory_order_relaxed)(NS, RPos, dRPos);
+    }
+}
+
+/**
+ * Set instruction set for the interaction kernels. Falls back to the best instruction set supported by the CPU.
+ * Safe to call while neural nets compute, the transfers in progress switch kernels between receptors.
+ * @param InstructionSet Instruction set value.
+ */
+void indk::Kernel::setInstructionSet(int InstructionSet) {
+    if (InstructionSet > ::getSupportedInstructionSet() || InstructionSet < 0) InstructionSet = ::getSupportedInstructionSet();
+    getCurrentInstructionSet() = InstructionSet;
+    Interaction<0>::getCurrent() = getInteractionFunction<0>(InstructionSet);
+    Interaction<2>::getCurrent() = getInteractionFunction<2>(InstructionSet);
+    Interaction<3>::getCurrent() = getInteractionFunction<3>(InstructionSet);
+}
+
+/**
+ * Split the receptor loop of neurons with work (synapses x receptors x dimensions) above the threshold between threads.
+ * @param Threads Threads count including the calling thread, 0 or 1 disables splitting.
+ * @param Threshold Minimal neuron work to split.
+ */
+void indk::Kernel::setReceptorParallelism(unsigned int Threads, uint64_t Threshold) {
+    ReceptorWorkThreshold = Threshold;
+    Pool.setThreads(Threads);
+}
+
+int indk::Kernel::getInstructionSet() {
+    return getCurrentInstructionSet();
+}
+
+unsigned int indk::Kernel::getReceptorThreads() {
+    return Pool.getThreads();
+}
+
+uint64_t indk::Kernel::getReceptorWorkThreshold() {
+    return ReceptorWorkThreshold;
+}
+
+int indk::Kernel::getSupportedInstructionSet() {
+    return ::getSupportedInstructionSet();
+}
@@ -0,0 +1,362 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        model.cpp
+// Purpose:     Binary model image class
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <fstream>
+#include <indk/model.h>
+#include <indk/neuralnet.h>
+#include <indk/error.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+indk::Model::Builder::Builder() {
+    Name = doAddString("");
+    Description = Name;
+    ModelVersion = Name;
+    Data.resize((sizeof(indk::Model::Header)+indk_MODEL_ALIGNMENT-1)/indk_MODEL_ALIGNMENT*indk_MODEL_ALIGNMENT, 0);
+}
+
+/**
+ * Add string to the string table. Equal strings share the same ID.
+ * @param Str String.
+ * @return String ID.
+ */
+uint64_t indk::Model::Builder::doAddString(const std::string& Str) {
+    auto s = StringIndex.find(Str);
+    if (s != StringIndex.end()) return s->second;
+    StringIndex.insert(std::make_pair(Str, Strings.size()));
+    Strings.push_back(Str);
+    return Strings.size() - 1;
+}
+
+/**
+ * Add aligned data section to the image.
+ * @param Section Section data.
+ * @param Size Section size in bytes.
+ * @return Section offset.
+ */
+uint64_t indk::Model::Builder::doAddSection(const void *Section, uint64_t Size) {
+    auto offset = (Data.size()+indk_MODEL_ALIGNMENT-1) / indk_MODEL_ALIGNMENT * indk_MODEL_ALIGNMENT;
+    Data.resize(offset+Size, 0);
+    if (Size) memcpy(Data.data()+offset, Section, Size);
+    return offset;
+}
+
+void indk::Model::Builder::doAddEntry(const std::string& Entry) {
+    Entries.push_back(doAddString(Entry));
+}
+
+void indk::Model::Builder::doAddOutput(const std::string& Output) {
+    Outputs.push_back(doAddString(Output));
+}
+
+void indk::Model::Builder::doAddNeuron(const indk::Model::NeuronRecord& Record) {
+    Neurons.push_back(Record);
+}
+
+/**
+ * Add ensemble record.
+ * @param Ensemble Ensemble name.
+ * @param Members Names of the ensemble neurons.
+ */
+void indk::Model::Builder::doAddEnsemble(const std::string& Ensemble, const std::vector<std::string>& Members) {
+    std::vector<uint64_t> members;
+    for (const auto &m: Members) members.push_back(doAddString(m));
+    Ensembles.push_back({doAddString(Ensemble), members.size(), doAddSection(members.data(), members.size()*sizeof(uint64_t))});
+}
+
+void indk::Model::Builder::setName(const std::string& _Name, const std::string& _Description, const std::string& _ModelVersion) {
+    Name = doAddString(_Name);
+    Description = doAddString(_Description);
+    ModelVersion = doAddString(_ModelVersion);
+}
+
+/**
+ * Complete the image. Sections can not be added after the image is completed.
+ * @return Image data.
+ */
+const std::vector<char>& indk::Model::Builder::doBuild() {
+    indk::Model::Header header{};
+    memcpy(header.Magic, indk_MODEL_MAGIC, sizeof(indk_MODEL_MAGIC));
+    header.Version = indk_MODEL_VERSION;
+    header.ByteOrder = indk_MODEL_BYTE_ORDER;
+    header.Name = Name;
+    header.Description = Description;
+    header.ModelVersion = ModelVersion;
+    header.EntriesCount = Entries.size();
+    header.Entries = doAddSection(Entries.data(), Entries.size()*sizeof(uint64_t));
+    header.OutputsCount = Outputs.size();
+    header.Outputs = doAddSection(Outputs.data(), Outputs.size()*sizeof(uint64_t));
+    header.NeuronsCount = Neurons.size();
+    header.Neurons = doAddSection(Neurons.data(), Neurons.size()*sizeof(indk::Model::NeuronRecord));
+    header.EnsemblesCount = Ensembles.size();
+    header.Ensembles = doAddSection(Ensembles.data(), Ensembles.size()*sizeof(indk::Model::EnsembleRecord));
+
+    std::vector<uint64_t> offsets;
+    std::string data;
+    for (const auto &s: Strings) {
+        offsets.push_back(data.size());
+        data.append(s);
+    }
+    offsets.push_back(data.size());
+    header.StringsCount = Strings.size();
+    header.Strings = doAddSection(offsets.data(), offsets.size()*sizeof(uint64_t));
+    header.StringsData = doAddSection(data.data(), data.size());
+    header.Size = Data.size();
+    memcpy(Data.data(), &header, sizeof(header));
+    return Data;
+}
+
+/**
+ * Complete the image and write it to file.
+ * @param Path Path to the model file.
+ */
+void indk::Model::Builder::doWrite(const std::string& Path) {
+    doBuild();
+    std::ofstream stream(Path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) throw indk::Error(indk::Error::EX_MODEL_IO);
+    stream.write(Data.data(), Data.size());
+    if (!stream.good()) throw indk::Error(indk::Error::EX_MODEL_IO);
+}
+
+indk::Model::Model() {
+    Data = nullptr;
+    Size = 0;
+    Mapping = nullptr;
+    MappingSize = 0;
+}
+
+/**
+ * Open binary model image.
+ * @param Path Path to the model file.
+ */
+indk::Model::Model(const std::string& Path): Model() {
+    doOpen(Path);
+}
+
+/**
+ * Open binary model image. The file is mapped to memory read-only: pages of the image are shared between
+ * all processes that map the same file, neurons attached to the image copy the arrays they change.
+ * If mapping is not available on the platform, the file is read to the internal buffer.
+ * @param Path Path to the model file.
+ */
+void indk::Model::doOpen(const std::string& Path) {
+    doClose();
+#ifndef _WIN32
+    int fd = open(Path.c_str(), O_RDONLY);
+    if (fd < 0) throw indk::Error(indk::Error::EX_MODEL_IO);
+    struct stat st{};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        auto mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            Mapping = mapping;
+            MappingSize = st.st_size;
+            Data = (const char*)mapping;
+            Size = st.st_size;
+        }
+    }
+    close(fd);
+#endif
+    if (!Data) {
+        std::ifstream stream(Path, std::ios::binary | std::ios::ate);
+        if (!stream.is_open()) throw indk::Error(indk::Error::EX_MODEL_IO);
+        Size = stream.tellg();
+        stream.seekg(0);
+        Buffer.resize((Size+indk_MODEL_ALIGNMENT)/sizeof(uint64_t)+1);
+        auto data = (char*)Buffer.data();
+        data += (indk_MODEL_ALIGNMENT - (uintptr_t)data%indk_MODEL_ALIGNMENT) % indk_MODEL_ALIGNMENT;
+        stream.read(data, Size);
+        if (!stream.good()) {
+            doClose();
+            throw indk::Error(indk::Error::EX_MODEL_IO);
+        }
+        Data = data;
+    }
+
+    try {
+        doCheck();
+    } catch (indk::Error &e) {
+        doClose();
+        throw;
+    }
+}
+
+/**
+ * Open binary model image in memory. The image is used in place, so the memory must outlive the model object.
+ * @param ImageData Image data, aligned to indk_MODEL_ALIGNMENT bytes.
+ * @param ImageSize Size of the image data.
+ */
+void indk::Model::doOpen(const void *ImageData, uint64_t ImageSize) {
+    doClose();
+    Data = (const char*)ImageData;
+    Size = ImageSize;
+    try {
+        doCheck();
+    } catch (indk::Error &e) {
+        doClose();
+        throw;
+    }
+}
+
+void indk::Model::doCheck() {
+    if (Size < sizeof(indk::Model::Header)) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+    auto header = (const indk::Model::Header*)Data;
+    if (memcmp(header->Magic, indk_MODEL_MAGIC, sizeof(indk_MODEL_MAGIC)) != 0 || header->Version != indk_MODEL_VERSION ||
+        header->ByteOrder != indk_MODEL_BYTE_ORDER || header->Size > Size)
+        throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+    getArray<uint64_t>(header->Entries, header->EntriesCount);
+    getArray<uint64_t>(header->Outputs, header->OutputsCount);
+    getArray<indk::Model::NeuronRecord>(header->Neurons, header->NeuronsCount);
+    getArray<indk::Model::EnsembleRecord>(header->Ensembles, header->EnsemblesCount);
+    auto offsets = getArray<uint64_t>(header->Strings, getCount(header->StringsCount, 1, 1));
+    getSection(header->StringsData, offsets[header->StringsCount]);
+    for (uint64_t i = 0; i < header->StringsCount; i++) {
+        if (offsets[i] > offsets[i+1]) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+    }
+}
+
+/**
+ * Close the image. Views returned by the image accessors are not valid after closing.
+ */
+void indk::Model::doClose() {
+#ifndef _WIN32
+    if (Mapping) munmap(Mapping, MappingSize);
+#endif
+    Mapping = nullptr;
+    MappingSize = 0;
+    Buffer.clear();
+    Buffer.shrink_to_fit();
+    Data = nullptr;
+    Size = 0;
+}
+
+/**
+ * Check if the file is a binary model image.
+ * @param Path Path to the file.
+ * @return True if the file starts with the binary model signature.
+ */
+bool indk::Model::isModel(const std::string& Path) {
+    char magic[sizeof(indk_MODEL_MAGIC)] = {0};
+    std::ifstream stream(Path, std::ios::binary);
+    if (!stream.is_open()) return false;
+    stream.read(magic, sizeof(magic));
+    return stream.good() && memcmp(magic, indk_MODEL_MAGIC, sizeof(indk_MODEL_MAGIC)) == 0;
+}
+
+/**
+ * Convert JSON neural net structure to binary model image.
+ * @param JSONPath Path to the JSON structure file.
+ * @param BinaryPath Path to the binary model file.
+ */
+void indk::Model::doConvertToBinary(const std::string& JSONPath, const std::string& BinaryPath) {
+    indk::NeuralNet NN(JSONPath);
+    NN.doSaveModel(BinaryPath);
+}
+
+/**
+ * Convert binary model image to JSON neural net structure.
+ * @param BinaryPath Path to the binary model file.
+ * @param JSONPath Path to the JSON structure file.
+ */
+void indk::Model::doConvertToJSON(const std::string& BinaryPath, const std::string& JSONPath) {
+    indk::NeuralNet NN;
+    NN.doLoadModel(BinaryPath);
+    std::ofstream stream(JSONPath, std::ios::trunc);
+    if (!stream.is_open()) throw indk::Error(indk::Error::EX_MODEL_IO);
+    stream << NN.getStructure(false);
+    if (!stream.good()) throw indk::Error(indk::Error::EX_MODEL_IO);
+}
+
+const void* indk::Model::getSection(uint64_t Offset, uint64_t Count, uint64_t ElementSize) const {
+    if (!Count) return nullptr;
+    // the count is checked before it is multiplied by the element size, so the check can not overflow
+    if (!Data || Offset > Size || Count > (Size-Offset)/ElementSize || Offset%sizeof(uint64_t))
+        throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+    return Data + Offset;
+}
+
+/**
+ * Get count of elements of the section that keeps `Count` records of `Width` elements and `Extra` elements more.
+ * @return Count of elements.
+ * @throws indk::Error::EX_MODEL_FORMAT if the count does not fit 64 bits.
+ */
+uint64_t indk::Model::getCount(uint64_t Count, uint64_t Width, uint64_t Extra) {
+    if (Width && Count > (UINT64_MAX-Extra)/Width) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+    return Count*Width + Extra;
+}
+
+const indk::Model::Header* indk::Model::getHeader() const {
+    return (const indk::Model::Header*)Data;
+}
+
+/**
+ * Get neuron record.
+ * @param NID Index of the neuron record.
+ * @return Neuron record.
+ */
+const indk::Model::NeuronRecord* indk::Model::getNeuron(uint64_t NID) const {
+    if (!Data || NID >= getHeader()->NeuronsCount) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+    return getArray<indk::Model::NeuronRecord>(getHeader()->Neurons, getHeader()->NeuronsCount) + NID;
+}
+
+/**
+ * Get ensemble record.
+ * @param EID Index of the ensemble record.
+ * @return Ensemble record.
+ */
+const indk::Model::EnsembleRecord* indk::Model::getEnsemble(uint64_t EID) const {
+    if (!Data || EID >= getHeader()->EnsemblesCount) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+    return getArray<indk::Model::EnsembleRecord>(getHeader()->Ensembles, getHeader()->EnsemblesCount) + EID;
+}
+
+/**
+ * Get string from the string table.
+ * @param SID String ID.
+ * @return String.
+ */
+std::string indk::Model::getString(uint64_t SID) const {
+    auto header = getHeader();
+    if (!Data || SID >= header->StringsCount) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+    auto offsets = getArray<uint64_t>(header->Strings, getCount(header->StringsCount, 1, 1));
+    return std::string(Data+header->StringsData+offsets[SID], offsets[SID+1]-offsets[SID]);
+}
+
+/**
+ * Get strings referenced by the array of string IDs.
+ * @param Offset Offset of the string ID array.
+ * @param Count Count of the strings.
+ * @return Vector of strings.
+ */
+std::vector<std::string> indk::Model::getStrings(uint64_t Offset, uint64_t Count) const {
+    std::vector<std::string> strings;
+    auto ids = getArray<uint64_t>(Offset, Count);
+    for (uint64_t i = 0; i < Count; i++) strings.push_back(getString(ids[i]));
+    return strings;
+}
+
+bool indk::Model::isMapped() const {
+    return Mapping != nullptr;
+}
+
+bool indk::Model::isOpen() const {
+    return Data != nullptr;
+}
+
+uint64_t indk::Model::getSize() const {
+    return Size;
+}
+
+indk::Model::~Model() {
+    doClose();
+}
@@ -7,39 +7,731 @@
 // Licence:     MIT licence
 /////////////////////////////////////////////////////////////////////////////
 
+#include <cstring>
+#include <cstdio>
 #include <fstream>
 #include <queue>
 #include <thread>
+#include <chrono>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <unordered_set>
 #include <json.hpp>
 #include <indk/neuralnet.h>
+#include <indk/error.h>
 #include <indk/profiler.h>
 
 typedef nlohmann::json json;
 
+namespace {
+    /// Synapse definition of the neural net structure.
+    typedef struct {
+        std::vector<float> Position;
+        float k1;
+        unsigned int Tl, Radius;
+        int NT;
+        int64_t Entry;
+        bool Cluster;
+    } SynapseDefinition;
+
+    /// Receptor definition of the neural net structure. Scopes keeps coordinates of all scopes one after another.
+    typedef struct {
+        std::vector<float> Position, Scopes;
+        std::vector<uint64_t> ScopeSizes;
+        unsigned int Count, Radius;
+        bool Cluster;
+    } ReceptorDefinition;
+
+    /// Neuron definition of the neural net structure. Keeps the neuron in compact form until the neuron is built.
+    typedef struct {
+        std::string Name, Ensemble;
+        unsigned int Size, Dimensions;
+        int Latency;
+        bool LatencySet, EnsembleSet;
+        std::vector<std::string> Inputs;
+        std::vector<SynapseDefinition> Synapses;
+        std::vector<ReceptorDefinition> Receptors;
+    } NeuronDefinition;
+
+    SynapseDefinition getSynapseDefinition() {
+        return {{}, 1.2, 0, 0, 0, -1, false};
+    }
+
+    ReceptorDefinition getReceptorDefinition() {
+        return {{}, {}, {}, 0, 0, false};
+    }
+
+    NeuronDefinition getNeuronDefinition() {
+        return {"", "", 0, 0, 0, false, false, {}, {}, {}};
+    }
+
+    /**
+     * Read neuron definition from its JSON object.
+     * @param jneuron JSON definition of the neuron.
+     * @return Neuron definition.
+     */
+    NeuronDefinition doReadNeuron(const json &jneuron) {
+        auto isset = [] (const json &j, const char *key) {
+            auto v = j.find(key);
+            return v != j.end() && !v->is_null();
+        };
+        auto N = getNeuronDefinition();
+        N.Name = jneuron.at("name").get<std::string>();
+        N.Size = jneuron.at("size").get<unsigned int>();
+        N.Dimensions = jneuron.at("dimensions").get<unsigned int>();
+        if (isset(jneuron, "latency")) {
+            N.Latency = jneuron.at("latency").get<int>();
+            N.LatencySet = true;
+        }
+        if (isset(jneuron, "ensemble")) {
+            N.Ensemble = jneuron.at("ensemble").get<std::string>();
+            N.EnsembleSet = true;
+        }
+        if (isset(jneuron, "input_signals")) {
+            for (const auto &jent: jneuron.at("input_signals")) N.Inputs.push_back(jent.get<std::string>());
+        }
+
+        if (isset(jneuron, "synapses")) for (const auto &jsynapse: jneuron.at("synapses")) {
+            auto S = getSynapseDefinition();
+            for (const auto &jposition: jsynapse.at("position")) S.Position.push_back(jposition.get<float>());
+            if (isset(jsynapse, "k1")) S.k1 = jsynapse.at("k1").get<float>();
+            if (isset(jsynapse, "tl")) S.Tl = jsynapse.at("tl").get<unsigned int>();
+            if (isset(jsynapse, "neurotransmitter") && jsynapse.at("neurotransmitter").get<std::string>() == "deactivation") S.NT = 1;
+            if (isset(jsynapse, "type") && jsynapse.at("type").get<std::string>() == "cluster") {
+                S.Cluster = true;
+                S.Radius = jsynapse.at("radius").get<unsigned int>();
+            } else if (isset(jsynapse, "entry")) {
+                S.Entry = jsynapse.at("entry").get<unsigned int>();
+            }
+            N.Synapses.push_back(std::move(S));
+        }
+
+        if (isset(jneuron, "receptors")) for (const auto &jreceptor: jneuron.at("receptors")) {
+            auto R = getReceptorDefinition();
+            for (const auto &jposition: jreceptor.at("position")) R.Position.push_back(jposition.get<float>());
+            if (isset(jreceptor, "type") && jreceptor.at("type").get<std::string>() == "cluster") {
+                R.Cluster = true;
+                R.Count = jreceptor.at("count").get<unsigned int>();
+                R.Radius = jreceptor.at("radius").get<unsigned int>();
+            }
+            if (isset(jreceptor, "scopes")) for (const auto &jscope: jreceptor.at("scopes")) {
+                for (const auto &jposition: jscope) R.Scopes.push_back(jposition.get<float>());
+                R.ScopeSizes.push_back(jscope.size());
+            }
+            N.Receptors.push_back(std::move(R));
+        }
+        return N;
+    }
+
+    /**
+     * Build neuron from its definition. Only the new neuron object is changed, so neurons of the structure
+     * can be built in parallel. Output links of the neuron are not set.
+     * @param D Neuron definition.
+     * @param error Error message, set if the neuron definition is not valid.
+     * @return New neuron object or nullptr if the definition is not valid.
+     */
+    indk::Neuron* doBuildNeuron(const NeuronDefinition &D, std::string &error) {
+        std::unique_ptr<indk::Neuron> N(new indk::Neuron(D.Size, D.Dimensions, 0, D.Inputs));
+
+        for (const auto &S: D.Synapses) {
+            if (D.Dimensions != S.Position.size()) {
+                error = "Error: position vector size not equal dimension count";
+                return nullptr;
+            }
+            if (S.Cluster) {
+                N -> doCreateNewSynapseCluster(S.Position, S.Radius, S.k1, S.Tl, S.NT);
+            } else {
+                if (S.Entry < 0) {
+                    error = "Error: entry number must be set";
+                    return nullptr;
+                }
+                N -> doCreateNewSynapse(D.Inputs.at(S.Entry), S.Position, S.k1, S.Tl, S.NT);
+            }
+        }
+
+        for (const auto &R: D.Receptors) {
+            if (D.Dimensions != R.Position.size()) {
+                error = "Error: position vector size not equal dimension count";
+                return nullptr;
+            }
+            auto first = N -> getReceptorsCount();
+            if (R.Cluster) N -> doCreateNewReceptorCluster(R.Position, R.Radius, R.Count);
+            else N -> doCreateNewReceptor(R.Position);
+
+            for (auto i = first; i < N->getReceptorsCount(); i++) {
+                auto r = N -> getReceptor(i);
+                auto scope = R.Scopes.begin();
+                for (const auto &size: R.ScopeSizes) {
+                    if (R.Cluster) N -> doCreateNewScope();
+                    else r -> doCreateNewScope();
+                    auto pos = indk::Position(D.Size, std::vector<float>(scope, scope+size));
+                    r -> setPos(&pos);
+                    scope += size;
+                }
+            }
+        }
+
+        N -> setName(D.Name);
+        return N.release();
+    }
+
+    /**
+     * Build neurons on the structure threads (see indk::System::setStructureThreads). Building stops on the first
+     * failed neuron, all neurons before it are built.
+     * @param Count Count of neurons.
+     * @param Build Function that builds neuron by its index, returns nullptr and sets error message on failure.
+     * @param Errors Error messages of the failed neurons.
+     * @param Exceptions Exceptions thrown by the failed neurons.
+     * @return Built neurons, nullptr for the failed and not built ones.
+     */
+    std::vector<indk::Neuron*> doBuildNeurons(uint64_t Count, const std::function<indk::Neuron*(uint64_t, std::string&)> &Build,
+                                             std::vector<std::string> &Errors, std::vector<std::exception_ptr> &Exceptions) {
+        std::vector<indk::Neuron*> neurons(Count, nullptr);
+        std::atomic<uint64_t> next(0);
+
+        auto worker = [&] () {
+            while (true) {
+                auto i = next.fetch_add(1);
+                if (i >= Count) break;
+                try {
+                    neurons[i] = Build(i, Errors[i]);
+                } catch (...) {
+                    Exceptions[i] = std::current_exception();
+                }
+                if (!neurons[i]) next = Count;
+            }
+        };
+
+        uint64_t threads = indk::System::getStructureThreads();
+        if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+        if (threads > Count) threads = Count;
+        std::vector<std::thread> workers;
+        for (uint64_t i = 1; i < threads; i++) workers.emplace_back(worker);
+        worker();
+        for (auto &w: workers) w.join();
+        return neurons;
+    }
+
+    /// SAX handler that reads the neural net structure from the JSON token stream. Every neuron is kept as compact
+    /// definition only until its object ends, then it is built and passed to the callback, so the whole document
+    /// is never kept in memory. Keys that the DOM reader requires (see doReadNeuron) are tracked per object,
+    /// parsing fails when a neuron, synapse or receptor object ends without one of them.
+    class StructureReader {
+    private:
+        typedef enum {
+            RoleRoot,
+            RoleEntries,
+            RoleOutputs,
+            RoleNeurons,
+            RoleNeuron,
+            RoleInputs,
+            RoleSynapses,
+            RoleSynapse,
+            RoleSynapsePosition,
+            RoleReceptors,
+            RoleReceptor,
+            RoleReceptorPosition,
+            RoleScopes,
+            RoleScope,
+            RoleSkip,
+        } Roles;
+
+        typedef struct {
+            int Role;
+            std::string Key;
+        } Frame;
+
+        std::vector<Frame> Frames;
+        NeuronDefinition Neuron;
+        std::unordered_set<std::string> NeuronKeys, SynapseKeys, ReceptorKeys;
+        std::function<bool(NeuronDefinition&)> NeuronCallback;
+
+        bool doTypeError(const std::string &type) {
+            Error = "Error parsing structure: unexpected "+type+" value of `"+Frames.back().Key+"`";
+            return false;
+        }
+
+        void doMarkKey() {
+            if (Frames.empty()) return;
+            const auto &frame = Frames.back();
+            switch (frame.Role) {
+                case RoleNeuron:
+                    NeuronKeys.insert(frame.Key);
+                    break;
+                case RoleSynapse:
+                    SynapseKeys.insert(frame.Key);
+                    break;
+                case RoleReceptor:
+                    ReceptorKeys.insert(frame.Key);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        bool doCheckKeys(const std::unordered_set<std::string> &keys, std::initializer_list<const char*> required, const std::string &object) {
+            for (auto k: required) {
+                if (!keys.count(k)) {
+                    Error = "Error parsing structure: missing `"+std::string(k)+"` of "+object;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool doNumber(double value) {
+            doMarkKey();
+            if (Frames.empty()) return true;
+            const auto &frame = Frames.back();
+            const auto &key = frame.Key;
+            switch (frame.Role) {
+                case RoleNeuron:
+                    if (key == "size") Neuron.Size = value;
+                    else if (key == "dimensions") Neuron.Dimensions = value;
+                    else if (key == "latency") {
+                        Neuron.Latency = value;
+                        Neuron.LatencySet = true;
+                    } else if (key == "name" || key == "ensemble") return doTypeError("number");
+                    return true;
+                case RoleSynapse:
+                    if (key == "entry") Neuron.Synapses.back().Entry = value;
+                    else if (key == "k1") Neuron.Synapses.back().k1 = value;
+                    else if (key == "tl") Neuron.Synapses.back().Tl = value;
+                    else if (key == "radius") Neuron.Synapses.back().Radius = value;
+                    else if (key == "neurotransmitter" || key == "type") return doTypeError("number");
+                    return true;
+                case RoleReceptor:
+                    if (key == "count") Neuron.Receptors.back().Count = value;
+                    else if (key == "radius") Neuron.Receptors.back().Radius = value;
+                    else if (key == "type") return doTypeError("number");
+                    return true;
+                case RoleSynapsePosition:
+                    Neuron.Synapses.back().Position.push_back(value);
+                    return true;
+                case RoleReceptorPosition:
+                    Neuron.Receptors.back().Position.push_back(value);
+                    return true;
+                case RoleScope:
+                    Neuron.Receptors.back().Scopes.push_back(value);
+                    Neuron.Receptors.back().ScopeSizes.back()++;
+                    return true;
+                case RoleRoot:
+                    if (key == "name" || key == "desc" || key == "version") return doTypeError("number");
+                    return true;
+                case RoleEntries:
+                case RoleOutputs:
+                case RoleInputs:
+                    return doTypeError("number");
+                default:
+                    return true;
+            }
+        }
+    public:
+        std::string Name, Description, Version, Error;
+        std::vector<std::string> Entries, Outputs;
+
+        explicit StructureReader(std::function<bool(NeuronDefinition&)> Callback) {
+            NeuronCallback = std::move(Callback);
+            Neuron = getNeuronDefinition();
+        }
+
+        bool null() {
+            return true;
+        }
+
+        bool boolean(bool) {
+            doMarkKey();
+            return true;
+        }
+
+        bool number_integer(json::number_integer_t value) {
+            return doNumber(value);
+        }
+
+        bool number_unsigned(json::number_unsigned_t value) {
+            return doNumber(value);
+        }
+
+        bool number_float(json::number_float_t value, const std::string&) {
+            return doNumber(value);
+        }
+
+        bool binary(json::binary_t&) {
+            return true;
+        }
+
+        bool string(json::string_t &value) {
+            doMarkKey();
+            if (Frames.empty()) return true;
+            const auto &frame = Frames.back();
+            const auto &key = frame.Key;
+            switch (frame.Role) {
+                case RoleRoot:
+                    if (key == "name") Name = value;
+                    else if (key == "desc") Description = value;
+                    else if (key == "version") Version = value;
+                    return true;
+                case RoleEntries:
+                    Entries.push_back(value);
+                    return true;
+                case RoleOutputs:
+                    Outputs.push_back(value);
+                    return true;
+                case RoleInputs:
+                    Neuron.Inputs.push_back(value);
+                    return true;
+                case RoleNeuron:
+                    if (key == "name") Neuron.Name = value;
+                    else if (key == "ensemble") {
+                        Neuron.Ensemble = value;
+                        Neuron.EnsembleSet = true;
+                    } else if (key == "size" || key == "dimensions" || key == "latency") return doTypeError("string");
+                    return true;
+                case RoleSynapse:
+                    if (key == "neurotransmitter") Neuron.Synapses.back().NT = value == "deactivation";
+                    else if (key == "type") Neuron.Synapses.back().Cluster = value == "cluster";
+                    else if (key == "entry" || key == "k1" || key == "tl" || key == "radius") return doTypeError("string");
+                    return true;
+                case RoleReceptor:
+                    if (key == "type") Neuron.Receptors.back().Cluster = value == "cluster";
+                    else if (key == "count" || key == "radius") return doTypeError("string");
+                    return true;
+                case RoleSynapsePosition:
+                case RoleReceptorPosition:
+                case RoleScope:
+                    return doTypeError("string");
+                default:
+                    return true;
+            }
+        }
+
+        bool start_object(std::size_t) {
+            int role = RoleSkip;
+            doMarkKey();
+            if (Frames.empty()) role = RoleRoot;
+            else if (Frames.back().Role == RoleNeurons) {
+                Neuron = getNeuronDefinition();
+                NeuronKeys.clear();
+                role = RoleNeuron;
+            } else if (Frames.back().Role == RoleSynapses) {
+                Neuron.Synapses.push_back(getSynapseDefinition());
+                SynapseKeys.clear();
+                role = RoleSynapse;
+            } else if (Frames.back().Role == RoleReceptors) {
+                Neuron.Receptors.push_back(getReceptorDefinition());
+                ReceptorKeys.clear();
+                role = RoleReceptor;
+            }
+            Frames.push_back({role, ""});
+            return true;
+        }
+
+        bool end_object() {
+            auto role = Frames.back().Role;
+            Frames.pop_back();
+            switch (role) {
+                case RoleNeuron: {
+                    if (!doCheckKeys(NeuronKeys, {"name", "size", "dimensions"}, "neuron `"+Neuron.Name+"`")) return false;
+                    auto result = NeuronCallback(Neuron);
+                    Neuron = getNeuronDefinition();
+                    return result;
+                }
+                case RoleSynapse:
+                    if (Neuron.Synapses.back().Cluster) return doCheckKeys(SynapseKeys, {"position", "radius"}, "synapse cluster of neuron `"+Neuron.Name+"`");
+                    return doCheckKeys(SynapseKeys, {"position"}, "synapse of neuron `"+Neuron.Name+"`");
+                case RoleReceptor:
+                    if (Neuron.Receptors.back().Cluster) return doCheckKeys(ReceptorKeys, {"position", "count", "radius"}, "receptor cluster of neuron `"+Neuron.Name+"`");
+                    return doCheckKeys(ReceptorKeys, {"position"}, "receptor of neuron `"+Neuron.Name+"`");
+                default:
+                    return true;
+            }
+        }
+
+        bool start_array(std::size_t) {
+            int role = RoleSkip;
+            doMarkKey();
+            if (!Frames.empty()) {
+                const auto &parent = Frames.back();
+                const auto &key = parent.Key;
+                switch (parent.Role) {
+                    case RoleRoot:
+                        if (key == "entries") role = RoleEntries;
+                        else if (key == "output_signals") role = RoleOutputs;
+                        else if (key == "neurons") role = RoleNeurons;
+                        break;
+                    case RoleNeuron:
+                        if (key == "input_signals") role = RoleInputs;
+                        else if (key == "synapses") role = RoleSynapses;
+                        else if (key == "receptors") role = RoleReceptors;
+                        break;
+                    case RoleSynapse:
+                        if (key == "position") role = RoleSynapsePosition;
+                        break;
+                    case RoleReceptor:
+                        if (key == "position") role = RoleReceptorPosition;
+                        else if (key == "scopes") role = RoleScopes;
+                        break;
+                    case RoleScopes:
+                        Neuron.Receptors.back().ScopeSizes.push_back(0);
+                        role = RoleScope;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            Frames.push_back({role, ""});
+            return true;
+        }
+
+        bool end_array() {
+            Frames.pop_back();
+            return true;
+        }
+
+        bool key(json::string_t &value) {
+            Frames.back().Key = value;
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception &e) {
+            Error = std::string("Error parsing structure: ") + e.what();
+            return false;
+        }
+    };
+
+    /**
+     * Create neuron from the record of the binary model image. The learned geometry is copied to the neuron.
+     * Output links of the neuron are not set.
+     * @param Image Model image.
+     * @param NID Neuron record index.
+     * @return New neuron object.
+     */
+    indk::Neuron* doCopyNeuron(const indk::Model &Image, uint64_t NID) {
+        auto nrecord = Image.getNeuron(NID);
+        auto ndimensions = nrecord->DimensionsCount;
+        auto inputs = Image.getStrings(nrecord->Entries, nrecord->EntriesCount);
+        if (nrecord->SynapsesStride < nrecord->SynapsesCount) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+
+        auto N = new indk::Neuron(nrecord->Xm, ndimensions, 0, inputs);
+        try {
+            N -> setName(Image.getString(nrecord->Name));
+            N -> setProcessingMode(nrecord->ProcessingMode);
+            N -> setOutputMode(nrecord->OutputMode);
+
+            auto spos = Image.getArray<float>(nrecord->SynapsePos, indk::Model::getCount(nrecord->SynapsesStride, ndimensions));
+            auto slambda = Image.getArray<float>(nrecord->SynapseLambda, nrecord->SynapsesCount);
+            auto sentry = Image.getArray<uint32_t>(nrecord->SynapseEntry, nrecord->SynapsesCount);
+            auto stype = Image.getArray<int32_t>(nrecord->SynapseType, nrecord->SynapsesCount);
+            auto sk1 = Image.getArray<float>(nrecord->SynapseK1, nrecord->SynapsesCount);
+            auto sk2 = Image.getArray<float>(nrecord->SynapseK2, nrecord->SynapsesCount);
+            auto stl = Image.getArray<int64_t>(nrecord->SynapseTl, nrecord->SynapsesCount);
+            std::vector<float> pos(ndimensions);
+            for (uint64_t s = 0; s < nrecord->SynapsesCount; s++) {
+                if (sentry[s] >= inputs.size()) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+                for (unsigned int d = 0; d < ndimensions; d++) pos[d] = spos[d*nrecord->SynapsesStride+s];
+                N -> doCreateNewSynapse(inputs[sentry[s]], pos, sk1[s], stl[s], stype[s]);
+                auto ne = N -> getEntry(sentry[s]);
+                auto ns = ne -> getSynapse(ne->getSynapsesCount()-1);
+                ns -> setLambda(slambda[s]);
+                ns -> setk2(sk2[s]);
+            }
+
+            auto rpos = Image.getArray<float>(nrecord->ReceptorPos0, indk::Model::getCount(nrecord->ReceptorsCount, ndimensions));
+            auto rk3 = Image.getArray<float>(nrecord->ReceptorK3, nrecord->ReceptorsCount);
+            auto rscopes = Image.getArray<uint64_t>(nrecord->ReceptorScopes, nrecord->ReceptorsCount);
+            auto scopes = Image.getArray<float>(nrecord->ScopePos, indk::Model::getCount(indk::Model::getCount(nrecord->ReceptorsCount, ndimensions), nrecord->ScopesStride));
+            std::vector<float> scope(ndimensions);
+            for (uint64_t r = 0; r < nrecord->ReceptorsCount; r++) {
+                if (rscopes[r] > nrecord->ScopesStride) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+                N -> doCreateNewReceptor(std::vector<float>(rpos+r*ndimensions, rpos+(r+1)*ndimensions));
+                auto nr = N -> getReceptor(r);
+                nr -> setk3(rk3[r]);
+                if (!rscopes[r]) nr -> doReset();
+                for (uint64_t sc = 0; sc < rscopes[r]; sc++) {
+                    if (sc) nr -> doCreateNewScope();
+                    for (unsigned int d = 0; d < ndimensions; d++) scope[d] = scopes[(r*ndimensions+d)*nrecord->ScopesStride+sc];
+                    nr -> setReferencePos(sc, scope.data());
+                }
+            }
+        } catch (...) {
+            delete N;
+            throw;
+        }
+        return N;
+    }
+
+    /// FNV-1a hash steps used to detect the changes between the checkpoints.
+    const uint64_t HashBasis = 14695981039346656037ULL;
+
+    uint64_t doHashValue(uint64_t H, uint64_t Value) {
+        return (H ^ Value) * 1099511628211ULL;
+    }
+
+    uint64_t doHashFloat(uint64_t H, float Value) {
+        uint32_t bits;
+        memcpy(&bits, &Value, sizeof(bits));
+        return doHashValue(H, bits);
+    }
+
+    uint64_t doHashString(uint64_t H, const std::string& Value) {
+        H = doHashValue(H, Value.size());
+        for (auto c: Value) H = doHashValue(H, (unsigned char)c);
+        return H;
+    }
+
+    /**
+     * Get checkpointed state of the neuron.
+     * @param N Neuron object.
+     * @param Latency Neuron latency, nullptr if the latency is not set.
+     * @return Hash of the neuron structure and hashes of all reference scopes.
+     */
+    indk::NeuronCheckpoint doFingerprintNeuron(indk::Neuron *N, const int *Latency) {
+        indk::NeuronCheckpoint state;
+        auto ndimensions = N -> getDimensionsCount();
+        auto h = doHashValue(HashBasis, Latency ? 1 : 0);
+        if (Latency) h = doHashValue(h, *Latency);
+        h = doHashValue(h, N->getXm());
+        h = doHashValue(h, ndimensions);
+        h = doHashValue(h, N->getProcessingMode());
+        h = doHashValue(h, N->getOutputMode());
+
+        for (int64_t e = 0; e < N->getEntriesCount(); e++) {
+            auto ne = N -> getEntry(e);
+            h = doHashValue(h, ne->getSynapsesCount());
+            for (int64_t s = 0; s < ne->getSynapsesCount(); s++) {
+                auto ns = ne -> getSynapse(s);
+                for (unsigned int d = 0; d < ndimensions; d++) h = doHashFloat(h, ns->getPos()->getPositionValue(d));
+                h = doHashFloat(h, ns->getLambda());
+                h = doHashFloat(h, ns->getk1());
+                h = doHashFloat(h, ns->getk2());
+                h = doHashValue(h, ns->getTl());
+                h = doHashValue(h, ns->getNeurotransmitterType());
+                h = doHashValue(h, ns->getSID());
+            }
+        }
+        for (const auto &e: N->getEntries()) h = doHashString(h, e);
+
+        h = doHashValue(h, N->getReceptorsCount());
+        for (int64_t r = 0; r < N->getReceptorsCount(); r++) {
+            auto nr = N -> getReceptor(r);
+            for (unsigned int d = 0; d < ndimensions; d++) h = doHashFloat(h, nr->getPos0()->getPositionValue(d));
+            h = doHashFloat(h, nr->getk3());
+            const auto &scopes = nr -> getReferencePosScopes();
+            state.ScopesCount.push_back(scopes.size());
+            for (const auto &sc: scopes) {
+                auto hs = HashBasis;
+                for (unsigned int d = 0; d < ndimensions; d++) hs = doHashFloat(hs, sc->getPositionValue(d));
+                state.Scopes.push_back(hs);
+            }
+        }
+        state.Structure = h;
+        return state;
+    }
+}
+
 indk::NeuralNet::NeuralNet() {
     t = 0;
+    TransferEnd = 0;
     StateSyncEnabled = false;
     LastUsedComputeBackend = -1;
     InterlinkService = nullptr;
-
-    if (indk::System::getVerbosityLevel() > 1)
-        std::cout << "Using default compute backend." << std::endl;
-
-    indk::System::setComputeBackend(indk::System::ComputeBackends::Default);
+    TransferCancel = nullptr;
+    OutputTableValid = false;
+    Residency.Image = nullptr;
+    Residency.Limit = 0;
+    Residency.Learned = false;
+    Residency.CullingEpsilon = 0;
+    Residency.CullingSkin = 0;
+    CheckpointLog.Topology = 0;
+    CheckpointLog.Size = 0;
+    CheckpointLog.SnapshotSize = 0;
+    CheckpointLog.Compaction = indk_CHECKPOINT_COMPACTION;
 }
 
 indk::NeuralNet::NeuralNet(const std::string &path) {
     t = 0;
+    TransferEnd = 0;
     StateSyncEnabled = false;
     LastUsedComputeBackend = -1;
     InterlinkService = nullptr;
+    TransferCancel = nullptr;
+    OutputTableValid = false;
+    Residency.Image = nullptr;
+    Residency.Limit = 0;
+    Residency.Learned = false;
+    Residency.CullingEpsilon = 0;
+    Residency.CullingSkin = 0;
+    CheckpointLog.Topology = 0;
+    CheckpointLog.Size = 0;
+    CheckpointLog.SnapshotSize = 0;
+    CheckpointLog.Compaction = indk_CHECKPOINT_COMPACTION;
+    if (indk::Model::isModel(path)) {
+        doLoadModel(path);
+        return;
+    }
     std::ifstream filestream(path);
     setStructure(filestream);
+}
 
-    if (indk::System::getVerbosityLevel() > 1)
-        std::cout << "Using default compute backend." << std::endl;
+/**
+ * Create recognition context of the source neural net. Neurons of the context share learned geometry with the source
+ * neurons (see indk::Neuron::doCreateContext) and are processed by the given runtime.
+ * @param Source Source neural net.
+ * @param ContextRuntime Runtime used by the context.
+ */
+indk::NeuralNet::NeuralNet(const indk::NeuralNet *Source, const std::shared_ptr<indk::Runtime>& ContextRuntime) {
+    t = Source -> t;
+    TransferEnd = 0;
+    Name = Source -> Name;
+    Description = Source -> Description;
+    Version = Source -> Version;
+    Entries = Source -> Entries;
+    Ensembles = Source -> Ensembles;
+    Latencies = Source -> Latencies;
+    Outputs = Source -> Outputs;
+    if (Source->Residency.Image) {
+        // outputs of the lazily attached model are limited to the resident neurons
+        Outputs.erase(std::remove_if(Outputs.begin(), Outputs.end(), [Source] (const std::string& O) {
+            return Source->Neurons.find(O) == Source->Neurons.end();
+        }), Outputs.end());
+    }
+    StateSyncList = Source -> StateSyncList;
+    StateSyncEnabled = Source -> StateSyncEnabled;
+    LastUsedComputeBackend = -1;
+    InterlinkService = nullptr;
+    TransferCancel = nullptr;
+    OutputTableValid = false;
+    Residency.Image = nullptr;
+    Residency.Limit = 0;
+    Residency.Learned = Source -> Residency.Learned;
+    Residency.CullingEpsilon = Source -> Residency.CullingEpsilon;
+    Residency.CullingSkin = Source -> Residency.CullingSkin;
+    CheckpointLog.Topology = 0;
+    CheckpointLog.Size = 0;
+    CheckpointLog.SnapshotSize = 0;
+    CheckpointLog.Compaction = indk_CHECKPOINT_COMPACTION;
+    BoundRuntime = ContextRuntime;
+    for (const auto &N: Source->Neurons) {
+        auto context = N.second -> doCreateContext();
+        context -> setComputeBackend(BoundRuntime->getComputeBackend());
+        Neurons.emplace(N.first, context);
+    }
+}
 
-    indk::System::setComputeBackend(indk::System::ComputeBackends::Default);
+/**
+ * Get compute backend of the runtime used by the current transfer.
+ */
+indk::Computer* indk::NeuralNet::getComputeBackend() {
+    return ActiveRuntime -> getComputeBackend();
+}
+
+int indk::NeuralNet::getComputeBackendKind() {
+    return ActiveRuntime -> getComputeBackendKind();
+}
+
+int indk::NeuralNet::getComputeBackendParameter() {
+    return ActiveRuntime -> getComputeBackendParameter();
 }
 
 void indk::NeuralNet::doInterlinkInit(int port, int timeout) {
@@ -147,11 +839,16 @@ std::vector<float> indk::NeuralNet::doComparePatterns(const std::string& ename,
 std::vector<float> indk::NeuralNet::doComparePatterns(std::vector<std::string> nnames, int CompareFlag, int ProcessingMethod) {
     std::vector<float> PDiffR, PDiff;
 
+    // outputs of the lazily attached model are compared only if they are resident,
+    // explicitly selected neurons are materialised
+    bool resident = nnames.empty() && Residency.Image;
     if (nnames.empty()) nnames = Outputs;
     for (const auto& O: nnames) {
         auto n = Neurons.find(O);
-        if (n == Neurons.end()) break;
-        auto P = n -> second -> doComparePattern(ProcessingMethod);
+        if (n == Neurons.end() && resident) continue;
+        auto N = n != Neurons.end() ? n->second : doMaterialiseNeuron(O);
+        if (!N) break;
+        auto P = N -> doComparePattern(ProcessingMethod);
         PDiffR.push_back(std::get<0>(P));
     }
 
@@ -181,9 +878,11 @@ void indk::NeuralNet::doChangeScope(uint64_t scope) {
 
 void indk::NeuralNet::doAddNewOutput(const std::string& name) {
     Outputs.push_back(name);
+    OutputTableValid = false;
 }
 
 void indk::NeuralNet::doIncludeNeuronToEnsemble(const std::string& name, const std::string& ensemble) {
+    OutputTableValid = false;
     auto en = Ensembles.find(ensemble);
     if (en != Ensembles.end()) {
         en -> second.push_back(name);
@@ -206,88 +905,154 @@ void indk::NeuralNet::doPrepare() {
     for (const auto& N: Neurons) N.second -> doPrepare();
 }
 
-void indk::NeuralNet::doSignalProcessStart(const std::vector<std::vector<float>>& Xx, const EntryList& entries) {
-    float value;
-    int d = 0;
-
+/**
+ * Send rows of input signals to the neurons and process the signals.
+ * @param X Input signals.
+ * @param First First row to send.
+ * @param Count Count of rows to send, 0 - only process links (OpenCL backend).
+ */
+void indk::NeuralNet::doSignalProcessStart(const indk::SignalMatrix& X, uint64_t First, uint64_t Count) {
     int64_t dt = t;
+    auto kind = getComputeBackendKind();
+
+    // dataflow computing: neurons are scheduled by the backend as soon as all their ports are complete,
+    // so only the first tick of links that read the previous tick output has to be sent here. Links with shift
+    // deliver every tick explicitly, so entries are not filled with zeros.
+    if (kind == indk::System::ComputeBackends::Multithread) {
+        TransferEnd = t + Count;
+        for (const auto &l: Plan.Links) {
+            if (!l.Shift) continue;
+            auto nfrom = Plan.Neurons[l.From];
+            float value = 0;
+            if (t && nfrom->getState(t-1) == indk::Neuron::States::Computed) value = nfrom -> doSignalReceive(t-1).second;
+            doDeliver(l.To, l.Port, value, t);
+        }
+        for (auto r = First; r < First+Count; r++) {
+            auto row = X.getRow(r);
+            for (const auto &e: Plan.Entries) doDeliver(e.To, e.Port, row[e.Input], t);
+            t++;
+        }
+        return;
+    }
 
-    for (auto X: Xx) {
-        int xi = 0;
-        for (auto &e: entries) {
-            for (auto &en: e.second) {
-                auto n = Neurons.find(en);
-
-                auto lto = Latencies.find(en);
-                auto latencyto = lto != Latencies.end() ? lto->second : 0;
-                auto waiting = n -> second -> getWaitingEntries();
-                for (auto &we: waiting) {
-                    auto nprev = Latencies.find(we);
-                    if (nprev != Latencies.end() && nprev->second > latencyto) {
-                        n -> second -> doSignalSendEntry(we, 0, 0);
-                    }
-                }
-
-                if (n != Neurons.end())
-                    n -> second -> doSignalSendEntry(e.first, X[xi], t);
+    for (auto r = First; r < First+Count; r++) {
+        auto row = X.getRow(r);
+        for (const auto &e: Plan.Entries) {
+            auto nto = Plan.Neurons[e.To];
+            for (auto ze: e.ZeroEntries) {
+                if (!nto->getEntry(ze)->doCheckState(nto->getTime())) nto -> doSignalSendEntry(ze, 0, 0);
             }
-            xi++;
+            nto -> doSignalSendEntry(e.Entry, row[e.Input], t);
         }
         t++;
     }
 
-    if (indk::System::getComputeBackendKind() == indk::System::ComputeBackends::OpenCL)
-        indk::System::getComputeBackend() -> doWaitTarget();
+    if (kind == indk::System::ComputeBackends::OpenCL)
+        getComputeBackend() -> doWaitTarget();
+
+    // neurons are computed synchronously, so one pass in topological order is enough
+    if (kind == indk::System::ComputeBackends::Default && Plan.Acyclic) {
+        doExecutePlan(Count);
+        return;
+    }
 
     dt = t - dt;
-    if (Xx.empty()) dt = 1;
+    if (!Count) dt = 1;
     int64_t lt = 0;
 
     while (lt != dt) {
-        d = 0;
-
-        for (auto l: Links) {
-            auto from = std::get<0>(l);
-            auto to = std::get<1>(l);
+        if (doExecutePlan(Count) == Plan.Links.size()) {
+            lt++;
+        } else if (!Count) getComputeBackend() -> doWaitTarget();
+    }
+}
 
-            auto nfrom = (indk::Neuron*)std::get<2>(l);
-            auto nto = (indk::Neuron*)std::get<3>(l);
-            auto latency = std::get<4>(l);
-            auto time = nto -> getTime();
+/**
+ * Compute the next tick of the neuron and send its output signal to the linked neurons.
+ * Called by the dataflow compute backends from the worker threads.
+ * @param N Neuron from the execution plan.
+ */
+void indk::NeuralNet::doExecuteTask(indk::Neuron *N) {
+    auto i = Plan.Index.find(N);
+    if (i == Plan.Index.end()) return;
+    auto n = i -> second;
+
+    // ticks of the same neuron are never computed concurrently, so the neuron and its plan counters
+    // are accessed by one thread at a time
+    auto tick = Plan.Next[n]++;
+    auto inbox = Plan.Inbox.data() + Plan.InboxOffset[n]*indk_SIGNAL_WINDOW + tick%indk_SIGNAL_WINDOW;
+    const auto &ports = Plan.Ports[n];
+    for (uint64_t p = 0; p < ports.size(); p++) {
+        N -> getEntry(ports[p]) -> doIn(inbox[p*indk_SIGNAL_WINDOW], tick);
+    }
 
-            if (nto->getTime() == t) {
-                d++;
-                continue;
-            }
+    N -> doProcess();
 
-            value = 0;
-            if (!time && latency >= 0 || time) {
-                auto shift = (bool)latency;
-                if (latency > 0) shift = false;
-                if (nfrom->getState(time-shift) != indk::Neuron::States::Computed) {
-                    if (indk::System::getComputeBackendKind() == indk::System::ComputeBackends::OpenCL)
-                        d++;
-                    continue;
-                }
-                value = nfrom -> doSignalReceive(time-shift).second;
-            }
+    auto time = N -> getTime() - 1;
+    for (auto li: Plan.Outputs[n]) {
+        const auto &l = Plan.Links[li];
+        if (tick+l.Shift >= TransferEnd) continue;
+        doDeliver(l.To, l.Port, N->doSignalReceive(time).second, tick+l.Shift);
+    }
+}
 
+/**
+ * Send signal to the input port of the plan neuron. The neuron is scheduled when the last port for the tick
+ * receives its signal. Thread safe as long as every port receives one signal per tick.
+ * @param To Plan index of the neuron.
+ * @param Port Input port of the neuron.
+ * @param Value Signal value.
+ * @param Tick Tick of the signal.
+ */
+void indk::NeuralNet::doDeliver(uint64_t To, uint64_t Port, float Value, int64_t Tick) {
+    auto slot = Tick % indk_SIGNAL_WINDOW;
+    Plan.Inbox[(Plan.InboxOffset[To]+Port)*indk_SIGNAL_WINDOW+slot] = Value;
+
+    // the counter of the slot is reused only in the next window, after all its ticks are computed
+    auto &ready = Plan.Ready[To*indk_SIGNAL_WINDOW+slot];
+    if (ready.fetch_add(1, std::memory_order_acq_rel)+1 != Plan.Ports[To].size()) return;
+    ready.store(0, std::memory_order_relaxed);
+    getComputeBackend() -> doProcess((void*)Plan.Neurons[To]);
+}
 
-            nto -> doSignalSendEntry(from, value, time);
+/**
+ * Run one pass over the execution plan links: transfer output signals of computed neurons to the linked neurons.
+ * @param input Input signals were sent before the pass.
+ * @return Count of links that are done for the current tick.
+ */
+uint64_t indk::NeuralNet::doExecutePlan(bool input) {
+    auto opencl = getComputeBackendKind() == indk::System::ComputeBackends::OpenCL;
+    uint64_t d = 0;
+
+    for (const auto &l: Plan.Links) {
+        auto nfrom = Plan.Neurons[l.From];
+        auto nto = Plan.Neurons[l.To];
+        auto time = nto -> getTime();
+
+        if (time == t) {
+            d++;
+            continue;
+        }
 
-            if (indk::System::getComputeBackendKind() == indk::System::ComputeBackends::OpenCL) {
-                if (!Xx.empty() || Xx.empty() && time == t) {
-                    d++;
-                }
-            } else if (time == t) {
-                d++;
+        float value = 0;
+        if (time || l.Initial) {
+            if (nfrom->getState(time-l.Shift) != indk::Neuron::States::Computed) {
+                if (opencl) d++;
+                continue;
             }
+            value = nfrom -> doSignalReceive(time-l.Shift).second;
         }
 
-        if (d == Links.size()) {
-            lt++;
-        } else if (Xx.empty()) indk::System::getComputeBackend() -> doWaitTarget();
+        nto -> doSignalSendEntry(l.Entry, value, time);
+
+        if (opencl) {
+            if (input || time == t) d++;
+        } else if (time == t) {
+            d++;
+        }
     }
+
+    return d;
 }
 
 void indk::NeuralNet::doParseLinks(const EntryList& entries, const std::string& id) {
@@ -311,9 +1076,9 @@ void indk::NeuralNet::doParseLinks(const EntryList& entries, const std::string&
         auto to = std::get<1>(i);
         auto latency = std::get<3>(i);
 
-        auto n = Neurons.find(to);
+        auto n = doMaterialiseNeuron(to);
 
-        if (n != Neurons.end()) {
+        if (n) {
             bool skip = false;
             for (auto l: Links) {
                 if (from == std::get<0>(l) && to == std::get<1>(l)) {
@@ -322,11 +1087,11 @@ void indk::NeuralNet::doParseLinks(const EntryList& entries, const std::string&
                 }
             }
             if (skip) continue;
-            auto nprev = Neurons.find(from);
+            auto nprev = doMaterialiseNeuron(from);
             auto type = 0;
-            if (nprev != Neurons.end()) Links.emplace_back(from, to, nprev->second, n->second, latency);
+            if (nprev) Links.emplace_back(from, to, nprev, n, latency);
 
-            auto nlinks = n -> second -> getLinkOutput();
+            auto nlinks = n -> getLinkOutput();
             for (auto &nl: nlinks) {
                 auto shift = 0;
                 auto nlatency = 0;
@@ -350,9 +1115,119 @@ void indk::NeuralNet::doParseLinks(const EntryList& entries, const std::string&
 //        std::cerr << std::get<0>(l) << " -> " << std::get<1>(l) << " " << std::get<4>(l) << std::endl;
 //    }
 
+    doBuildExecutionPlan(entries);
+    doEvictEnsembles();
     PrepareID = id;
 }
 
+/**
+ * Compile parsed links into the integer-indexed execution plan.
+ * @param entries Entries used for the signal transfer.
+ */
+void indk::NeuralNet::doBuildExecutionPlan(const EntryList& entries) {
+    auto getIndex = [this] (indk::Neuron *N) {
+        auto i = Plan.Index.find(N);
+        if (i != Plan.Index.end()) return i->second;
+        Plan.Index.emplace(N, Plan.Neurons.size());
+        Plan.Neurons.push_back(N);
+        return (uint64_t)Plan.Neurons.size()-1;
+    };
+
+    Plan.Neurons.clear();
+    Plan.Index.clear();
+    Plan.Entries.clear();
+    Plan.Links.clear();
+
+    uint64_t xi = 0;
+    for (auto &e: entries) {
+        for (auto &en: e.second) {
+            auto n = Neurons.find(en);
+            if (n == Neurons.end()) continue;
+
+            indk::ExecutionEntry pe;
+            pe.Input = xi;
+            pe.To = getIndex(n->second);
+            pe.Entry = n -> second -> getEntryIndex(e.first);
+
+            auto lto = Latencies.find(en);
+            auto latencyto = lto != Latencies.end() ? lto->second : 0;
+            auto nentries = n -> second -> getEntries();
+            for (uint64_t i = 0; i < nentries.size(); i++) {
+                auto nprev = Latencies.find(nentries[i]);
+                if (nprev != Latencies.end() && nprev->second > latencyto) pe.ZeroEntries.push_back(i);
+            }
+            Plan.Entries.push_back(pe);
+        }
+        xi++;
+    }
+
+    std::vector<indk::ExecutionLink> links;
+    for (const auto &l: Links) {
+        indk::ExecutionLink pl;
+        auto latency = std::get<4>(l);
+        pl.From = getIndex((indk::Neuron*)std::get<2>(l));
+        pl.To = getIndex((indk::Neuron*)std::get<3>(l));
+        pl.Entry = ((indk::Neuron*)std::get<3>(l)) -> getEntryIndex(std::get<0>(l));
+        pl.Shift = latency < 0;
+        pl.Initial = latency >= 0;
+        links.push_back(pl);
+    }
+
+    // Kahn's algorithm over the links of the same tick, links with shift only read the previous tick
+    auto ncount = Plan.Neurons.size();
+    std::vector<std::vector<uint64_t>> outputs(ncount);
+    std::vector<uint64_t> counters(ncount, 0), rank(ncount, ncount);
+    Plan.FanIn.assign(ncount, 0);
+    for (const auto &l: links) {
+        if (l.Shift) continue;
+        outputs[l.From].push_back(l.To);
+        Plan.FanIn[l.To]++;
+    }
+
+    std::queue<uint64_t> ready;
+    for (uint64_t i = 0; i < ncount; i++) {
+        counters[i] = Plan.FanIn[i];
+        if (!counters[i]) ready.push(i);
+    }
+    uint64_t r = 0;
+    while (!ready.empty()) {
+        auto i = ready.front();
+        ready.pop();
+        rank[i] = r++;
+        for (auto o: outputs[i]) {
+            if (!--counters[o]) ready.push(o);
+        }
+    }
+    Plan.Acyclic = r == ncount;
+
+    std::stable_sort(links.begin(), links.end(), [&rank] (const indk::ExecutionLink& l1, const indk::ExecutionLink& l2) {
+        auto r1 = l1.Shift ? 0 : rank[l1.From]+1;
+        auto r2 = l2.Shift ? 0 : rank[l2.From]+1;
+        return r1 < r2;
+    });
+    Plan.Links = std::move(links);
+
+    Plan.Outputs.assign(ncount, {});
+    for (uint64_t li = 0; li < Plan.Links.size(); li++) Plan.Outputs[Plan.Links[li].From].push_back(li);
+
+    Plan.Ports.assign(ncount, {});
+    for (auto &e: Plan.Entries) {
+        e.Port = Plan.Ports[e.To].size();
+        Plan.Ports[e.To].push_back(e.Entry);
+    }
+    for (auto &l: Plan.Links) {
+        l.Port = Plan.Ports[l.To].size();
+        Plan.Ports[l.To].push_back(l.Entry);
+    }
+    // inbox and counters are allocated by the dataflow backends on first use
+    Plan.InboxOffset.assign(ncount, 0);
+    for (uint64_t i = 1; i < ncount; i++) Plan.InboxOffset[i] = Plan.InboxOffset[i-1] + Plan.Ports[i-1].size();
+    Plan.Inbox.clear();
+    Plan.Ready.reset();
+    Plan.Next.assign(ncount, 0);
+
+}
+
 void indk::NeuralNet::doSyncNeuronStates(const std::string &name) {
     auto s = StateSyncList.find(name);
     if (s != StateSyncList.end()) {
@@ -382,6 +1257,25 @@ void indk::NeuralNet::doStructurePrepare() {
  * @return Output signals.
  */
 std::vector<indk::OutputValue> indk::NeuralNet::doSignalTransfer(const std::vector<std::vector<float>>& Xx, const std::vector<std::string>& inputs) {
+    return doSignalTransfer(indk::SignalMatrix(Xx), inputs);
+}
+
+/**
+ * Send signals to neural network and get output signals. Signals are read from the matrix in place.
+ * @param X Input signals matrix, one row per tick, one column per used entry.
+ * @return Output signals.
+ */
+std::vector<indk::OutputValue> indk::NeuralNet::doSignalTransfer(const indk::SignalMatrix& X, const std::vector<std::string>& inputs) {
+    doSignalSend(X, inputs);
+    return doSignalReceive();
+}
+
+/**
+ * Send signals to neural network without collecting output signals. Output signals can be read by doSignalReceive.
+ * @param X Input signals matrix, one row per tick, one column per used entry.
+ * @param inputs Entries used for the signal transfer (all entries by default).
+ */
+void indk::NeuralNet::doSignalSend(const indk::SignalMatrix& X, const std::vector<std::string>& inputs) {
     std::vector<void*> v;
     std::vector<std::string> nsync;
     EntryList eentries;
@@ -406,37 +1300,67 @@ std::vector<indk::OutputValue> indk::NeuralNet::doSignalTransfer(const std::vect
         doParseLinks(eentries, eseq);
     }
 
-    switch (indk::System::getComputeBackendKind()) {
+    if (!X.isEmpty() && X.getColumnsCount() < eentries.size()) {
+        throw indk::Error(indk::Error::EX_NEURALNET_INPUT);
+    }
+
+    ActiveRuntime = getRuntime();
+    for (const auto &n: Neurons) n.second -> setComputeBackend(BoundRuntime ? ActiveRuntime->getComputeBackend() : nullptr);
+    std::unique_lock<std::mutex> rlk(ActiveRuntime->getLock(), std::defer_lock);
+    if (ActiveRuntime->isSynchronizationNeeded()) rlk.lock();
+
+    // asynchronous transfer can be cancelled between the ticks, the multithread and OpenCL backends
+    // process all ticks at once, so they can be cancelled before the start only
+    if (TransferCancel && *TransferCancel) throw indk::Error(indk::Error::EX_NEURALNET_CANCELLED);
+
+    // signal buffers are rings that keep their state between the transfers: the default backend computes
+    // tick by tick, the other backends keep the window of ticks in flight and the previous tick output
+    // for the shifted links
+    const uint64_t window = indk_SIGNAL_WINDOW;
+    switch (getComputeBackendKind()) {
         case indk::System::ComputeBackends::Default:
-            doReserveSignalBuffer(1);
-            for (auto &X: Xx) {
-                doSignalProcessStart({X}, eentries);
+            if (getSignalBufferSize() != 1) doReserveSignalBuffer(1);
+            for (uint64_t r = 0; r < X.getRowsCount(); r++) {
+                if (TransferCancel && *TransferCancel) throw indk::Error(indk::Error::EX_NEURALNET_CANCELLED);
+                doSignalProcessStart(X, r, 1);
                 indk::Profiler::doEmit(this, indk::Profiler::EventFlags::EventTick);
             }
             break;
 
         case indk::System::ComputeBackends::Multithread:
-            if (getSignalBufferSize() != Xx.size()) doReserveSignalBuffer(Xx.size());
-            for (const auto &n: Neurons) v.push_back((void*)n.second);
-            indk::System::getComputeBackend() -> doRegisterHost(v);
-            doSignalProcessStart(Xx, eentries);
-            indk::System::getComputeBackend() -> doWaitTarget();
-            indk::System::getComputeBackend() -> doUnregisterHost();
+            if (getSignalBufferSize() != window+1) doReserveSignalBuffer(window+1);
+            for (const auto &n: Plan.Neurons) v.push_back((void*)n);
+            if (!Plan.Ready) {
+                auto ports = Plan.Neurons.empty() ? 0 : Plan.InboxOffset.back()+Plan.Ports.back().size();
+                Plan.Inbox.assign(ports*window, 0);
+                Plan.Ready.reset(new std::atomic<uint32_t>[Plan.Neurons.size()*window]);
+            }
+            // counters may be left incomplete by the failed transfer
+            for (uint64_t i = 0; i < Plan.Neurons.size()*window; i++) Plan.Ready[i].store(0, std::memory_order_relaxed);
+            std::fill(Plan.Next.begin(), Plan.Next.end(), t);
+            getComputeBackend() -> setTaskHandler([this] (void *N) { doExecuteTask((indk::Neuron*)N); });
+            getComputeBackend() -> doRegisterHost(v);
+            // ticks are sent in windows, so entries never hold more than the window of input signals
+            for (uint64_t r = 0; r < X.getRowsCount(); r += window) {
+                doSignalProcessStart(X, r, std::min<uint64_t>(window, X.getRowsCount()-r));
+                getComputeBackend() -> doWaitTarget();
+            }
+            getComputeBackend() -> doUnregisterHost();
             break;
 
         case indk::System::ComputeBackends::OpenCL:
-            if (getSignalBufferSize() != Xx.size()) doReserveSignalBuffer(Xx.size());
+            if (getSignalBufferSize() != window+1) doReserveSignalBuffer(window+1);
             for (const auto &n: Neurons) v.push_back((void*)n.second);
-            indk::System::getComputeBackend() -> doRegisterHost(v);
-            for (auto &X: Xx) {
-                doSignalProcessStart({X}, eentries);
+            getComputeBackend() -> doRegisterHost(v);
+            for (uint64_t r = 0; r < X.getRowsCount(); r++) {
+                doSignalProcessStart(X, r, 1);
             }
-            doSignalProcessStart({}, eentries);
-            indk::System::getComputeBackend() -> doUnregisterHost();
+            doSignalProcessStart(X, 0, 0);
+            getComputeBackend() -> doUnregisterHost();
             break;
     }
 
-    LastUsedComputeBackend = indk::System::getComputeBackendKind();
+    LastUsedComputeBackend = getComputeBackendKind();
     indk::Profiler::doEmit(this, indk::Profiler::EventFlags::EventProcessed);
 
     if (!inputs.empty() && StateSyncEnabled) {
@@ -444,25 +1368,115 @@ std::vector<indk::OutputValue> indk::NeuralNet::doSignalTransfer(const std::vect
             doSyncNeuronStates(name);
         }
     }
+}
 
-    return doSignalReceive();
+indk::AsyncTransfer::AsyncTransfer(std::shared_future<std::vector<indk::OutputValue>> _Result, std::shared_ptr<std::atomic<bool>> _Cancelled) {
+    Result = std::move(_Result);
+    Cancelled = std::move(_Cancelled);
+}
+
+/**
+ * Cancel the transfer. Queued transfer is not started, running transfer stops between the ticks.
+ * The result of the cancelled transfer is the indk::Error::EX_NEURALNET_CANCELLED exception.
+ */
+void indk::AsyncTransfer::doCancel() {
+    if (Cancelled) *Cancelled = true;
+}
+
+void indk::AsyncTransfer::doWait() const {
+    if (Result.valid()) Result.wait();
+}
+
+/**
+ * Wait for the transfer and get output signals. Exception of the transfer is rethrown.
+ * @return Output signals.
+ */
+std::vector<indk::OutputValue> indk::AsyncTransfer::getResult() const {
+    if (!Result.valid()) return {};
+    return Result.get();
+}
+
+bool indk::AsyncTransfer::isReady() const {
+    return Result.valid() && Result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool indk::AsyncTransfer::isCancelled() const {
+    return Cancelled && *Cancelled;
+}
+
+/**
+ * Submit the job to the asynchronous executor. Jobs of the neural net are executed one at a time in submission order.
+ * @param Job Job function.
+ * @param Callback Callback function for output signals.
+ * @return Handle of the asynchronous transfer.
+ */
+indk::AsyncTransfer indk::NeuralNet::doSubmitAsync(const std::function<std::vector<indk::OutputValue>()>& Job,
+                                                   const std::function<void(std::vector<indk::OutputValue>)>& Callback) {
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    auto task = std::make_shared<std::packaged_task<std::vector<indk::OutputValue>()>>([this, Job, Callback, cancelled] () {
+        if (*cancelled) throw indk::Error(indk::Error::EX_NEURALNET_CANCELLED);
+        TransferCancel = cancelled.get();
+        std::vector<indk::OutputValue> Y;
+        try {
+            Y = Job();
+        } catch (...) {
+            TransferCancel = nullptr;
+            throw;
+        }
+        TransferCancel = nullptr;
+
+        if (Callback) {
+            Callback(Y);
+        }
+        return Y;
+    });
+    auto result = task -> get_future().share();
+
+    auto executor = indk::System::getAsyncExecutor();
+    std::vector<std::shared_ptr<indk::Executor>> previous;
+    {
+        std::lock_guard<std::mutex> lk(AsyncLock);
+        // executors replaced by indk::System::setAsyncExecutor are kept while they have jobs of the neural net
+        // or somebody else still holds them
+        AsyncExecutors.erase(std::remove_if(AsyncExecutors.begin(), AsyncExecutors.end(), [this, &executor] (const std::shared_ptr<indk::Executor>& e) {
+            return e != executor && e.use_count() == 1 && !e->isPending(this);
+        }), AsyncExecutors.end());
+        for (const auto &e: AsyncExecutors) {
+            if (e != executor) previous.push_back(e);
+        }
+        if (std::find(AsyncExecutors.begin(), AsyncExecutors.end(), executor) == AsyncExecutors.end()) AsyncExecutors.push_back(executor);
+    }
+
+    // jobs left on the replaced executors are done first, so the jobs keep the submission order
+    executor -> doSubmit(this, [this, task, previous] () {
+        for (const auto &e: previous) e -> doWait(this);
+        (*task)();
+    });
+    return {result, cancelled};
 }
 
 /**
  * Send signals to neural network asynchronously.
  * @param Xx Input data vector that contain signals.
  * @param callback callback function for output signals.
+ * @return Handle of the asynchronous transfer.
  */
-void indk::NeuralNet::doSignalTransferAsync(const std::vector<std::vector<float>>& Xx, const std::function<void(std::vector<indk::OutputValue>)>& callback, const std::vector<std::string>& inputs) {
-    std::function<void()> tCallback([this, Xx, callback, inputs] () {
-        auto Y = doSignalTransfer(Xx, inputs);
+indk::AsyncTransfer indk::NeuralNet::doSignalTransferAsync(const std::vector<std::vector<float>>& Xx, const std::function<void(std::vector<indk::OutputValue>)>& callback, const std::vector<std::string>& inputs) {
+    return doSubmitAsync([this, Xx, inputs] () {
+        return doSignalTransfer(Xx, inputs);
+    }, callback);
+}
 
-        if (callback) {
-            callback(Y);
-        }
-    });
-    std::thread CallbackThread(tCallback);
-    CallbackThread.detach();
+/**
+ * Wait until all asynchronous transfers of the neural net are done.
+ */
+void indk::NeuralNet::doWaitAsync() {
+    std::vector<std::shared_ptr<indk::Executor>> executors;
+    {
+        std::lock_guard<std::mutex> lk(AsyncLock);
+        executors = AsyncExecutors;
+    }
+    for (const auto &e: executors) e -> doWait(this);
 }
 
 /**
@@ -471,13 +1485,22 @@ void indk::NeuralNet::doSignalTransferAsync(const std::vector<std::vector<float>
  * @return Output signals.
  */
 std::vector<indk::OutputValue> indk::NeuralNet::doLearn(const std::vector<std::vector<float>>& Xx, bool prepare, const std::vector<std::string>& inputs) {
+    return doLearn(indk::SignalMatrix(Xx), prepare, inputs);
+}
+
+/**
+ * Start neural network learning process. Signals are read from the matrix in place.
+ * @param X Input signals matrix for learning.
+ * @return Output signals.
+ */
+std::vector<indk::OutputValue> indk::NeuralNet::doLearn(const indk::SignalMatrix& X, bool prepare, const std::vector<std::string>& inputs) {
     if (InterlinkService && InterlinkService->isInterlinked()) {
         InterlinkService -> doUpdateStructure(getStructure());
     }
     t = 0;
     setLearned(false);
     if (prepare) doPrepare();
-    return doSignalTransfer(Xx, inputs);
+    return doSignalTransfer(X, inputs);
 }
 
 /**
@@ -486,69 +1509,196 @@ std::vector<indk::OutputValue> indk::NeuralNet::doLearn(const std::vector<std::v
  * @return Output signals.
  */
 std::vector<indk::OutputValue> indk::NeuralNet::doRecognise(const std::vector<std::vector<float>>& Xx, bool prepare, const std::vector<std::string>& inputs) {
+    return doRecognise(indk::SignalMatrix(Xx), prepare, inputs);
+}
+
+/**
+ * Recognize data by neural network. Signals are read from the matrix in place.
+ * @param X Input signals matrix for recognizing.
+ * @return Output signals.
+ */
+std::vector<indk::OutputValue> indk::NeuralNet::doRecognise(const indk::SignalMatrix& X, bool prepare, const std::vector<std::string>& inputs) {
     setLearned(true);
     if (prepare) {
         t = 0;
         doPrepare();
     }
-    return doSignalTransfer(Xx, inputs);
+    return doSignalTransfer(X, inputs);
+}
+
+/**
+ * Recognise independent samples in parallel. Every thread gets its own recognition context of the neural net:
+ * learned geometry is shared with the neural net, runtime state (Gamma, phantom receptor positions, sensitivity
+ * values, time) is private. The context is built once per thread and prepared before every sample, as doRecognise
+ * with `prepare` flag does, and the neural net state itself is not changed except the `learned` flag.
+ * @param Samples Input data vectors of the samples.
+ * @param inputs Entries used for the recognition (all entries by default).
+ * @param Threads Count of threads, 0 - hardware concurrency.
+ * @return Output signals and pattern difference values (see doComparePatterns) for every sample.
+ */
+std::vector<indk::RecognitionResult> indk::NeuralNet::doRecogniseBatch(const std::vector<std::vector<std::vector<float>>>& Samples, const std::vector<std::string>& inputs, unsigned int Threads) {
+    std::vector<indk::RecognitionResult> results(Samples.size());
+    if (Samples.empty()) return results;
+
+    setLearned(true);
+    if (Residency.Image) {
+        // neurons of the lazily attached model are materialised before the contexts copy them
+        if (inputs.empty()) {
+            doParseLinks(Entries, "all");
+        } else {
+            EntryList eentries;
+            std::string eseq;
+            for (const auto &e: inputs) {
+                auto ne = doFindEntry(e);
+                if (ne == -1) continue;
+                eentries.emplace_back(Entries[ne]);
+                eseq.append(e);
+            }
+            doParseLinks(eentries, eseq);
+        }
+    }
+    if (!Threads) Threads = std::max(1u, std::thread::hardware_concurrency());
+    if (Threads > Samples.size()) Threads = Samples.size();
+
+    auto runtime = std::make_shared<indk::Runtime>(indk::System::ComputeBackends::Default);
+    std::atomic<uint64_t> next(0);
+    std::mutex errorm;
+    std::exception_ptr error;
+
+    auto worker = [&] () {
+        try {
+            indk::NeuralNet context(this, runtime);
+            while (true) {
+                auto s = next.fetch_add(1);
+                if (s >= Samples.size()) break;
+                results[s].Outputs = context.doRecognise(Samples[s], true, inputs);
+                results[s].Patterns = context.doComparePatterns();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lk(errorm);
+            if (!error) error = std::current_exception();
+            next = Samples.size();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < Threads; i++) threads.emplace_back(worker);
+    worker();
+    for (auto &th: threads) th.join();
+    if (error) std::rethrow_exception(error);
+
+    return results;
 }
 
 /**
  * Start neural network learning process asynchronously.
  * @param Xx Input data vector that contain signals for learning.
  * @param callback Callback function for output signals.
+ * @return Handle of the asynchronous transfer.
  */
-void indk::NeuralNet::doLearnAsync(const std::vector<std::vector<float>>& Xx, const std::function<void(std::vector<indk::OutputValue>)>& callback, bool prepare, const std::vector<std::string>& inputs) {
-    setLearned(false);
-    t = 0;
-    if (prepare) doPrepare();
-    doSignalTransferAsync(Xx, callback, inputs);
+indk::AsyncTransfer indk::NeuralNet::doLearnAsync(const std::vector<std::vector<float>>& Xx, const std::function<void(std::vector<indk::OutputValue>)>& callback, bool prepare, const std::vector<std::string>& inputs) {
+    return doSubmitAsync([this, Xx, prepare, inputs] () {
+        setLearned(false);
+        t = 0;
+        if (prepare) doPrepare();
+        return doSignalTransfer(Xx, inputs);
+    }, callback);
 }
 
 /**
  * Recognize data by neural network asynchronously.
  * @param Xx Input data vector that contain signals for recognizing.
  * @param callback Callback function for output signals.
+ * @return Handle of the asynchronous transfer.
  */
-void indk::NeuralNet::doRecogniseAsync(const std::vector<std::vector<float>>& Xx, const std::function<void(std::vector<indk::OutputValue>)>& callback, bool prepare, const std::vector<std::string>& inputs) {
-    setLearned(true);
-    t = 0;
-    if (prepare) doPrepare();
-    doSignalTransferAsync(Xx, callback, inputs);
+indk::AsyncTransfer indk::NeuralNet::doRecogniseAsync(const std::vector<std::vector<float>>& Xx, const std::function<void(std::vector<indk::OutputValue>)>& callback, bool prepare, const std::vector<std::string>& inputs) {
+    return doSubmitAsync([this, Xx, prepare, inputs] () {
+        setLearned(true);
+        t = 0;
+        if (prepare) doPrepare();
+        return doSignalTransfer(Xx, inputs);
+    }, callback);
+}
+
+/**
+ * Resolve output neurons and output IDs of the ensembles. Output ID is the index of the output in the
+ * neural net output list, so IDs are stable until the structure is changed.
+ */
+void indk::NeuralNet::doBuildOutputTable() {
+    if (OutputTableValid) return;
+    OutputTable.clear();
+    OutputIndex.clear();
+    EnsembleOutputs.clear();
+
+    std::unordered_map<std::string, std::vector<std::string>> membership;
+    for (const auto &e: Ensembles) {
+        for (const auto &nname: e.second) membership[nname].push_back(e.first);
+    }
+
+    for (uint64_t o = 0; o < Outputs.size(); o++) {
+        auto n = Neurons.find(Outputs[o]);
+        OutputTable.push_back(n != Neurons.end() ? n->second : nullptr);
+        OutputIndex.emplace(Outputs[o], o);
+        if (!OutputTable.back()) continue;
+        auto m = membership.find(Outputs[o]);
+        if (m == membership.end()) continue;
+        for (const auto &ename: m->second) {
+            auto &list = EnsembleOutputs[ename];
+            if (list.empty() || list.back() != o) list.push_back(o);
+        }
+    }
+    OutputTableValid = true;
 }
 
 /**
  * Get output signals.
+ * @param ensemble Name of the ensemble to get output signals from (all outputs by default).
  * @return Output signals vector.
  */
 std::vector<indk::OutputValue> indk::NeuralNet::doSignalReceive(const std::string& ensemble) {
     std::vector<indk::OutputValue> ny;
-    std::vector<std::string> elist;
+    doBuildOutputTable();
 
     if (!ensemble.empty()) {
-        auto en = Ensembles.find(ensemble);
-        if (en == Ensembles.end()) return {};
-        elist = en -> second;
-        if (elist.empty()) return {};
-    }
-
-    for (const auto& oname: Outputs) {
-        auto n = Neurons.find(oname);
-        if (n != Neurons.end()) {
-            if (!elist.empty()) {
-                auto item = std::find_if(elist.begin(), elist.end(), [oname](const std::string &value) {
-                    return oname == value;
-                });
-                if (item == elist.end()) continue;
-            }
-
-            ny.emplace_back(n->second->doSignalReceive().second, oname);
+        for (auto o: getEnsembleOutputs(ensemble)) {
+            ny.emplace_back(OutputTable[o]->doSignalReceive().second, Outputs[o]);
         }
+        return ny;
+    }
+
+    for (uint64_t o = 0; o < OutputTable.size(); o++) {
+        if (OutputTable[o]) ny.emplace_back(OutputTable[o]->doSignalReceive().second, Outputs[o]);
     }
     return ny;
 }
 
+/**
+ * Get output signals without allocations. Output signal of every output is written to the buffer
+ * at the position of its output ID (see getOutputID).
+ * @param Y Output buffer, at least getOutputsCount() elements.
+ * @param Tick Tick of the output signals, -1 - the last computed tick. Only ticks kept in the signal buffers are available.
+ */
+void indk::NeuralNet::doSignalReceive(float *Y, int64_t Tick) {
+    doBuildOutputTable();
+    for (uint64_t o = 0; o < OutputTable.size(); o++) {
+        Y[o] = OutputTable[o] ? OutputTable[o]->doSignalReceive(Tick).second : 0;
+    }
+}
+
+/**
+ * Get output signals of the selected outputs without allocations.
+ * @param Y Output buffer, at least OutputIDs.size() elements.
+ * @param OutputIDs IDs of the outputs (see getOutputID and getEnsembleOutputs), signal of the i-th output is written to Y[i].
+ * @param Tick Tick of the output signals, -1 - the last computed tick. Only ticks kept in the signal buffers are available.
+ */
+void indk::NeuralNet::doSignalReceive(float *Y, const std::vector<uint64_t>& OutputIDs, int64_t Tick) {
+    doBuildOutputTable();
+    for (uint64_t i = 0; i < OutputIDs.size(); i++) {
+        auto n = OutputIDs[i] < OutputTable.size() ? OutputTable[OutputIDs[i]] : nullptr;
+        Y[i] = n ? n->doSignalReceive(Tick).second : 0;
+    }
+}
+
 /**
  * Creates full copy of neuron.
  * @param from Source neuron name.
@@ -556,7 +1706,9 @@ std::vector<indk::OutputValue> indk::NeuralNet::doSignalReceive(const std::strin
  * @param integrate Link neuron to the same elements as the source neuron.
  */
 indk::Neuron* indk::NeuralNet::doReplicateNeuron(const std::string& from, const std::string& to, bool integrate) {
+    doMaterialiseModel();
     PrepareID = "";
+    OutputTableValid = false;
 
     auto n = Neurons.find(from);
     if (n == Neurons.end()) {
@@ -610,8 +1762,11 @@ indk::Neuron* indk::NeuralNet::doReplicateNeuron(const std::string& from, const
  * @param name Name of the neuron.
  */
 void indk::NeuralNet::doDeleteNeuron(const std::string& name) {
+    Residency.Records.erase(name);
     auto n = Neurons.find(name);
     if (n == Neurons.end()) return;
+    PrepareID = "";
+    OutputTableValid = false;
     delete n->second;
     Neurons.erase(n);
 }
@@ -626,7 +1781,9 @@ void indk::NeuralNet::doDeleteNeuron(const std::string& name) {
 void indk::NeuralNet::doReplicateEnsemble(const std::string& From, const std::string& To, bool CopyEntries) {
     json j;
 
+    doMaterialiseModel();
     PrepareID = "";
+    OutputTableValid = false;
     std::vector<std::string> enew;
     auto efrom = Ensembles.find(From);
 
@@ -752,12 +1909,122 @@ void indk::NeuralNet::doReserveSignalBuffer(int64_t L) {
     }
 }
 
+/**
+ * Delete all neurons and clear the neural net structure.
+ */
+void indk::NeuralNet::doClearStructure() {
+    for (const auto& N: Neurons) delete N.second;
+    AttachedModel = nullptr;
+    Residency.Image = nullptr;
+    Residency.Records.clear();
+    Residency.Links.clear();
+    Residency.Owners.clear();
+    Residency.Resident.clear();
+    Residency.ResidentIndex.clear();
+    PrepareID = "";
+    OutputTableValid = false;
+    Entries.clear();
+    Outputs.clear();
+    Latencies.clear();
+    Neurons.clear();
+    Ensembles.clear();
+    StateSyncList.clear();
+}
+
+/**
+ * Get the neuron, neurons of the lazily attached model are materialised from the model image on first use.
+ * The ensemble of the neuron becomes the most recently used one.
+ * @param NName Neuron name.
+ * @return indk::Neuron object pointer, nullptr if the neuron is not found.
+ */
+indk::Neuron* indk::NeuralNet::doMaterialiseNeuron(const std::string& NName) {
+    auto n = Neurons.find(NName);
+    if (!Residency.Image) return n != Neurons.end() ? n->second : nullptr;
+
+    indk::Neuron *N;
+    if (n == Neurons.end()) {
+        auto r = Residency.Records.find(NName);
+        if (r == Residency.Records.end()) return nullptr;
+        N = new indk::Neuron(*Residency.Image, r->second);
+        for (const auto &o: Residency.Links[NName]) N -> doLinkOutput(o);
+        N -> setLearned(Residency.Learned);
+        if (Residency.CullingEpsilon > 0) N -> setCulling(Residency.CullingEpsilon, Residency.CullingSkin);
+        Neurons.insert(std::make_pair(NName, N));
+        OutputTableValid = false;
+    } else N = n -> second;
+
+    auto o = Residency.Owners.find(NName);
+    if (o == Residency.Owners.end()) return N;
+    auto e = Residency.ResidentIndex.find(o->second);
+    if (e != Residency.ResidentIndex.end()) {
+        Residency.Resident.splice(Residency.Resident.begin(), Residency.Resident, e->second);
+    } else {
+        Residency.Resident.push_front(o->second);
+        Residency.ResidentIndex.emplace(o->second, Residency.Resident.begin());
+    }
+    return N;
+}
+
+/**
+ * Materialise all neurons of the lazily attached model and stop lazy loading.
+ * Used by the operations that need the whole structure.
+ */
+void indk::NeuralNet::doMaterialiseModel() {
+    if (!Residency.Image) return;
+    for (const auto &r: Residency.Records) doMaterialiseNeuron(r.first);
+    Residency.Image = nullptr;
+    Residency.Records.clear();
+    Residency.Links.clear();
+    Residency.Owners.clear();
+    Residency.Resident.clear();
+    Residency.ResidentIndex.clear();
+}
+
+/**
+ * Release the least recently used ensembles of the lazily attached model while the count of resident ensembles
+ * exceeds the limit. Ensembles used by the execution plan are kept and skipped, so the limit may be exceeded
+ * only by the ensembles of the plan.
+ */
+void indk::NeuralNet::doEvictEnsembles() {
+    if (!Residency.Image || !Residency.Limit) return;
+
+    std::unordered_set<std::string> used;
+    for (const auto &N: Plan.Neurons) {
+        auto o = Residency.Owners.find(N->getName());
+        if (o != Residency.Owners.end()) used.insert(o->second);
+    }
+
+    auto r = Residency.Resident.end();
+    while (Residency.Resident.size() > Residency.Limit && r != Residency.Resident.begin()) {
+        auto ename = *--r;
+        if (used.find(ename) != used.end()) continue;
+        r = Residency.Resident.erase(r);
+        Residency.ResidentIndex.erase(ename);
+
+        auto e = Ensembles.find(ename);
+        if (e == Ensembles.end()) continue;
+        for (const auto &nname: e->second) {
+            auto o = Residency.Owners.find(nname);
+            if (o == Residency.Owners.end() || o->second != ename) continue;
+            auto n = Neurons.find(nname);
+            if (n == Neurons.end()) continue;
+            delete n->second;
+            Neurons.erase(n);
+        }
+        OutputTableValid = false;
+    }
+}
+
 void indk::NeuralNet::doClearCache() {
     PrepareID = "";
+    OutputTableValid = false;
 }
 
 /**
- * Load neural network structure.
+ * Load neural network structure from the stream. The structure is parsed while it is read: neurons are kept
+ * in compact form only until a batch of indk_STRUCTURE_BATCH neurons is built, so the whole document is never
+ * kept in memory. If the document is not valid (parse error, missing required key or a neuron that cannot be built),
+ * the neural net is left without structure.
  * @param Stream Input stream of file that contains neural network structure in JSON format.
  */
 void indk::NeuralNet::setStructure(std::ifstream &Stream) {
@@ -765,13 +2032,83 @@ void indk::NeuralNet::setStructure(std::ifstream &Stream) {
         if (indk::System::getVerbosityLevel() > 0) std::cerr << "Error opening file" << std::endl;
         return;
     }
-    std::string jstr;
-    while (!Stream.eof()) {
-        std::string rstr;
-        getline(Stream, rstr);
-        jstr.append(rstr);
+    doClearStructure();
+
+    std::multimap<std::string, std::string> links;
+    std::vector<NeuronDefinition> batch;
+
+    auto flush = [this, &links, &batch] () {
+        std::vector<std::string> errors(batch.size());
+        std::vector<std::exception_ptr> exceptions(batch.size());
+        auto neurons = doBuildNeurons(batch.size(), [&batch] (uint64_t i, std::string &error) {
+            return doBuildNeuron(batch[i], error);
+        }, errors, exceptions);
+
+        for (uint64_t i = 0; i < batch.size(); i++) {
+            if (!neurons[i]) {
+                for (auto k = i; k < batch.size(); k++) delete neurons[k];
+                batch.clear();
+                if (exceptions[i]) std::rethrow_exception(exceptions[i]);
+                std::cout << errors[i] << std::endl;
+                return false;
+            }
+            const auto &D = batch[i];
+            for (const auto &iname: D.Inputs) links.insert(std::make_pair(iname, D.Name));
+            if (D.LatencySet) {
+                if (indk::System::getVerbosityLevel() > 1) std::cout << D.Name << " with latency " << D.Latency << std::endl;
+                Latencies.insert(std::make_pair(D.Name, D.Latency));
+            }
+            if (D.EnsembleSet) Ensembles[D.Ensemble].push_back(D.Name);
+            Neurons.insert(std::make_pair(D.Name, neurons[i]));
+        }
+        batch.clear();
+        return true;
+    };
+
+    StructureReader reader([&flush, &batch] (NeuronDefinition &D) {
+        batch.push_back(std::move(D));
+        return batch.size() < indk_STRUCTURE_BATCH || flush();
+    });
+
+    bool parsed = false;
+    try {
+        parsed = json::sax_parse(Stream, &reader) && flush();
+        if (!parsed && !reader.Error.empty() && indk::System::getVerbosityLevel() > 0) std::cerr << reader.Error << std::endl;
+    } catch (std::exception &e) {
+        if (indk::System::getVerbosityLevel() > 0) std::cerr << "Error parsing structure: " << e.what() << std::endl;
+    }
+    if (!parsed) {
+        doClearStructure();
+        return;
+    }
+
+    Name = reader.Name;
+    Description = reader.Description;
+    Version = reader.Version;
+    for (const auto &ename: reader.Entries) {
+        std::vector<std::string> elinks;
+        auto l = links.equal_range(ename);
+        for (auto it = l.first; it != l.second; it++) {
+            elinks.push_back(it->second);
+            if (indk::System::getVerbosityLevel() > 1) std::cout << ename << " -> " << it->second << std::endl;
+        }
+        Entries.emplace_back(ename, elinks);
+    }
+    for (const auto &oname: reader.Outputs) {
+        if (indk::System::getVerbosityLevel() > 1) std::cout <<  "Output " << oname << std::endl;
+        Outputs.push_back(oname);
+    }
+    for (const auto &N: Neurons) {
+        auto l = links.equal_range(N.first);
+        for (auto it = l.first; it != l.second; it++) {
+            N.second -> doLinkOutput(it->second);
+            if (indk::System::getVerbosityLevel() > 1) std::cout << N.first << " -> " << it->second << std::endl;
+        }
+    }
+
+    if (InterlinkService && InterlinkService->isInterlinked()) {
+        InterlinkService -> setStructure(getStructure());
     }
-    setStructure(jstr);
 }
 
 /** \example samples/test/structure.json
@@ -779,7 +2116,8 @@ void indk::NeuralNet::setStructure(std::ifstream &Stream) {
  */
 
 /**
- * Load neural network structure.
+ * Load neural network structure. Neurons are built in parallel (see indk::System::setStructureThreads)
+ * and inserted to the neural net in the order of the structure.
  * @param Str JSON string that contains neural network structure.
  *
  * Format of neural network structure:
@@ -820,14 +2158,7 @@ void indk::NeuralNet::setStructure(std::ifstream &Stream) {
  *
  */
 void indk::NeuralNet::setStructure(const std::string &Str) {
-    for (const auto& N: Neurons) delete N.second;
-    PrepareID = "";
-    Entries.clear();
-    Outputs.clear();
-    Latencies.clear();
-    Neurons.clear();
-    Ensembles.clear();
-    StateSyncList.clear();
+    doClearStructure();
 
     try {
         auto j = json::parse(Str);
@@ -866,115 +2197,40 @@ void indk::NeuralNet::setStructure(const std::string &Str) {
 //            std::cout << l.first << " - " << l.second << std::endl;
 //        }
 
-        for (auto &jneuron: j["neurons"].items()) {
-            auto nname = jneuron.value()["name"].get<std::string>();
-            auto nsize = jneuron.value()["size"].get<unsigned int>();
-            auto ndimensions = jneuron.value()["dimensions"].get<unsigned int>();
-            if (jneuron.value()["latency"] != nullptr) {
-                auto nlatency = jneuron.value()["latency"].get<int>();
-                if (indk::System::getVerbosityLevel() > 1) std::cout << nname << " with latency " << nlatency << std::endl;
-                Latencies.insert(std::make_pair(nname, nlatency));
-            }
-            std::vector<std::string> nentries;
-            for (auto &jent: jneuron.value()["input_signals"].items()) {
-                nentries.push_back(jent.value().get<std::string>());
-            }
-            auto *N = new indk::Neuron(nsize, ndimensions, 0, nentries);
-
-            if (jneuron.value()["ensemble"] != nullptr) {
-                auto ename = jneuron.value()["ensemble"].get<std::string>();
-                auto e = Ensembles.find(ename);
-                if (e == Ensembles.end()) {
-                    std::vector<std::string> en;
-                    en.push_back(nname);
-                    Ensembles.insert(std::make_pair(ename, en));
-                } else {
-                    e->second.push_back(nname);
-                }
+        std::vector<const json*> jneurons;
+        for (const auto &jneuron: j["neurons"]) jneurons.push_back(&jneuron);
+        std::vector<std::string> errors(jneurons.size());
+        std::vector<std::exception_ptr> exceptions(jneurons.size());
+        auto neurons = doBuildNeurons(jneurons.size(), [&jneurons] (uint64_t i, std::string &error) {
+            return doBuildNeuron(doReadNeuron(*jneurons[i]), error);
+        }, errors, exceptions);
+
+        for (uint64_t i = 0; i < jneurons.size(); i++) {
+            if (!neurons[i]) {
+                for (auto k = i; k < jneurons.size(); k++) delete neurons[k];
+                if (exceptions[i]) std::rethrow_exception(exceptions[i]);
+                std::cout << errors[i] << std::endl;
+                return;
             }
 
-            for (auto &jsynapse: jneuron.value()["synapses"].items()) {
-                std::vector<float> pos;
-                if (ndimensions != jsynapse.value()["position"].size()) {
-                    std::cout << "Error: position vector size not equal dimension count" << std::endl;
-                    return;
-                }
-                for (auto &jposition: jsynapse.value()["position"].items()) {
-                    pos.push_back(jposition.value().get<float>());
-                }
-                float k1 = 1.2;
-                if (jsynapse.value()["k1"] != nullptr) k1 = jsynapse.value()["k1"].get<float>();
-                unsigned int tl = 0;
-                if (jsynapse.value()["tl"] != nullptr) tl = jsynapse.value()["tl"].get<unsigned int>();
-                int nt = 0;
-                if (jsynapse.value()["neurotransmitter"] != nullptr) {
-                    if (jsynapse.value()["neurotransmitter"].get<std::string>() == "deactivation")
-                        nt = 1;
-                }
-                if (jsynapse.value()["type"] != nullptr && jsynapse.value()["type"].get<std::string>() == "cluster") {
-                    auto sradius = jsynapse.value()["radius"].get<unsigned int>();
-                    N -> doCreateNewSynapseCluster(pos, sradius, k1, tl, nt);
-                } else {
-                    auto sentryid = -1;
-                    if (jsynapse.value()["entry"] != nullptr) {
-                        sentryid = jsynapse.value()["entry"].get<unsigned int>();
-                    } else {
-                        std::cout << "Error: entry number must be set" << std::endl;
-                        return;
-                    }
-                    auto sentry = jneuron.value()["input_signals"][sentryid];
-                    N -> doCreateNewSynapse(sentry, pos, k1, tl, nt);
-                }
-
-
+            auto &jneuron = *jneurons[i];
+            auto nname = neurons[i] -> getName();
+            auto jlatency = jneuron.find("latency");
+            if (jlatency != jneuron.end() && !jlatency->is_null()) {
+                auto nlatency = jlatency->get<int>();
+                if (indk::System::getVerbosityLevel() > 1) std::cout << nname << " with latency " << nlatency << std::endl;
+                Latencies.insert(std::make_pair(nname, nlatency));
             }
-            for (auto &jreceptor: jneuron.value()["receptors"].items()) {
-                std::vector<float> pos;
-                if (ndimensions != jreceptor.value()["position"].size()) {
-                    std::cout << "Error: position vector size not equal dimension count" << std::endl;
-                    return;
-                }
-                for (auto &jposition: jreceptor.value()["position"].items()) {
-                    pos.push_back(jposition.value().get<float>());
-                }
-                if (jreceptor.value()["type"] != nullptr && jreceptor.value()["type"].get<std::string>() == "cluster") {
-                    auto rcount = jreceptor.value()["count"].get<unsigned int>();
-                    auto rradius = jreceptor.value()["radius"].get<unsigned int>();
-                    N -> doCreateNewReceptorCluster(pos, rradius, rcount);
-
-                    for (auto i = N->getReceptorsCount()-rcount; i < N ->getReceptorsCount(); i++) {
-                        auto r = N -> getReceptor(i);
-                        for (auto &jscope: jreceptor.value()["scopes"].items()) {
-                            pos.clear();
-                            for (auto &jposition: jscope.value().items()) {
-                                pos.push_back(jposition.value().get<float>());
-                            }
-                            N -> doCreateNewScope();
-                            r -> setPos(new indk::Position(nsize, pos));
-                        }
-                    }
-                } else {
-                    N -> doCreateNewReceptor(pos);
-                    for (auto &jscope: jreceptor.value()["scopes"].items()) {
-                        pos.clear();
-                        for (auto &jposition: jscope.value().items()) {
-                            pos.push_back(jposition.value().get<float>());
-                        }
-                        auto r = N -> getReceptor(N->getReceptorsCount()-1);
-                        r -> doCreateNewScope();
-                        r -> setPos(new indk::Position(nsize, pos));
-                    }
-                }
+            auto jensemble = jneuron.find("ensemble");
+            if (jensemble != jneuron.end() && !jensemble->is_null()) {
+                Ensembles[jensemble->get<std::string>()].push_back(nname);
             }
-
             auto l = links.equal_range(nname);
             for (auto it = l.first; it != l.second; it++) {
-                N -> doLinkOutput(it->second);
+                neurons[i] -> doLinkOutput(it->second);
                 if (indk::System::getVerbosityLevel() > 1) std::cout << nname << " -> " << it->second << std::endl;
             }
-
-            N -> setName(nname);
-            Neurons.insert(std::make_pair(nname, N));
+            Neurons.insert(std::make_pair(nname, neurons[i]));
         }
 
         if (indk::System::getVerbosityLevel() > 1) {
@@ -995,11 +2251,513 @@ void indk::NeuralNet::setStructure(const std::string &Str) {
     }
 }
 
+/**
+ * Build neural network structure from the binary model image.
+ * @param Image Opened binary model image.
+ * @param Attach Build neurons over the learned geometry of the image instead of copying it.
+ */
+void indk::NeuralNet::doBuildModel(const indk::Model &Image, bool Attach, bool Lazy) {
+    doClearStructure();
+    if (Lazy) Residency.Image = &Image;
+
+    auto header = Image.getHeader();
+    Name = Image.getString(header->Name);
+    Description = Image.getString(header->Description);
+    Version = Image.getString(header->ModelVersion);
+
+    std::multimap<std::string, std::string> links;
+    for (uint64_t i = 0; i < header->NeuronsCount; i++) {
+        auto nrecord = Image.getNeuron(i);
+        auto nname = Image.getString(nrecord->Name);
+        for (const auto &iname: Image.getStrings(nrecord->Entries, nrecord->EntriesCount)) links.insert(std::make_pair(iname, nname));
+    }
+
+    for (const auto &ename: Image.getStrings(header->Entries, header->EntriesCount)) {
+        std::vector<std::string> elinks;
+        auto l = links.equal_range(ename);
+        for (auto it = l.first; it != l.second; it++) elinks.push_back(it->second);
+        Entries.emplace_back(ename, elinks);
+    }
+    Outputs = Image.getStrings(header->Outputs, header->OutputsCount);
+
+    for (uint64_t i = 0; i < header->EnsemblesCount; i++) {
+        auto erecord = Image.getEnsemble(i);
+        auto ename = Image.getString(erecord->Name);
+        Ensembles[ename] = Image.getStrings(erecord->Members, erecord->MembersCount);
+        if (Lazy) for (const auto &nname: Ensembles[ename]) Residency.Owners.emplace(nname, ename);
+    }
+
+    for (uint64_t i = 0; i < header->NeuronsCount; i++) {
+        auto nrecord = Image.getNeuron(i);
+        auto nname = Image.getString(nrecord->Name);
+        if (nrecord->Flags & indk::Model::NeuronFlags::LatencyFlag) Latencies.insert(std::make_pair(nname, nrecord->Latency));
+        indk::Neuron *N;
+        if (Lazy) {
+            // only the index is built, neurons are materialised by doMaterialiseNeuron
+            Residency.Records.emplace(nname, i);
+            auto &nlinks = Residency.Links[nname];
+            auto l = links.equal_range(nname);
+            for (auto it = l.first; it != l.second; it++) nlinks.push_back(it->second);
+            continue;
+        } else if (Attach) {
+            N = new indk::Neuron(Image, i);
+            Neurons.insert(std::make_pair(nname, N));
+        } else {
+            N = doCopyNeuron(Image, i);
+            Neurons.insert(std::make_pair(nname, N));
+        }
+
+        auto l = links.equal_range(nname);
+        for (auto it = l.first; it != l.second; it++) N -> doLinkOutput(it->second);
+    }
+
+    if (InterlinkService && InterlinkService->isInterlinked()) {
+        InterlinkService -> setStructure(getStructure());
+    }
+}
+
+/**
+ * Load neural network structure from the binary model image. Unlike the JSON structure, the image keeps
+ * the exact list of receptor reference scopes, synapse Lambda and k2 values and receptor k3 values.
+ * @param Image Opened binary model image.
+ */
+void indk::NeuralNet::setStructure(const indk::Model &Image) {
+    doBuildModel(Image, false, false);
+}
+
+/**
+ * Load neural network structure from the binary model file (see indk::Model).
+ * @param Path Path to the binary model file.
+ */
+void indk::NeuralNet::doLoadModel(const std::string& Path) {
+    indk::Model image(Path);
+    setStructure(image);
+}
+
+/**
+ * Attach neural network to the binary model file (see indk::Model). The file is mapped to memory and the learned
+ * geometry (synapse positions, Lambda values, default receptor positions and reference scopes) is used in place,
+ * only the runtime state (Gamma values, phantom receptor positions, sensitivity values and signal buffers) is allocated
+ * by the neural net. Pages of the image are shared by all processes that attach the same file, so the memory used by
+ * the learned model does not grow with the count of worker processes. Attached neural net is set to `learned` state.
+ * The image is mapped read-only: changing the geometry (for example, learning after setLearned(false) or setLambda)
+ * copies the changed arrays of the neuron to its store, the image itself is never written.
+ *
+ * In lazy mode only the index of neurons and ensembles is built: a neuron is materialised from the image when the
+ * execution plan (or getNeuron, getEnsemble, doComparePatterns with the given names) touches it first, so the working
+ * set is selected by the `inputs` argument of the signal transfer. Residency is tracked per ensemble, the least
+ * recently used ensembles are released when the limit is exceeded (see setResidentEnsemblesLimit). Neuron pointers
+ * of the lazily attached model are valid until their ensemble is released. Operations over the whole network
+ * (doReset, doPrepare, getNeurons, doComparePatterns for all outputs, output signals) see only the resident neurons,
+ * operations that need the whole structure (getStructure, doSaveModel, neuron and ensemble replication) materialise
+ * all neurons and stop lazy loading.
+ * @param Path Path to the binary model file.
+ * @param Lazy Materialise neurons on first use.
+ */
+void indk::NeuralNet::doAttachModel(const std::string& Path, bool Lazy) {
+    auto image = std::make_shared<indk::Model>(Path);
+    doBuildModel(*image, true, Lazy);
+    AttachedModel = image;
+    setLearned(true);
+}
+
+/**
+ * Save neural network structure with all learned reference scopes to the binary model file (see indk::Model).
+ * @param Path Path to the binary model file.
+ */
+void indk::NeuralNet::doSaveModel(const std::string& Path) {
+    doMaterialiseModel();
+    indk::Model::Builder builder;
+    std::vector<std::string> nnames;
+    for (const auto& n: Neurons) nnames.push_back(n.first);
+    doBuildImage(builder, nnames, true);
+    builder.doWrite(Path);
+}
+
+/**
+ * Add neurons to the binary model image.
+ * @param Builder Model image builder.
+ * @param NNames Names of the neurons.
+ * @param Topology Add name, entries, outputs and ensembles of the neural network.
+ */
+void indk::NeuralNet::doBuildImage(indk::Model::Builder& Builder, const std::vector<std::string>& NNames, bool Topology) {
+    if (Topology) {
+        Builder.setName(Name, Description, Version);
+        for (const auto& e: Entries) Builder.doAddEntry(e.first);
+        for (const auto& o: Outputs) Builder.doAddOutput(o);
+        for (const auto& e: Ensembles) Builder.doAddEnsemble(e.first, e.second);
+    }
+
+    for (const auto& nname: NNames) {
+        auto n = Neurons.find(nname);
+        if (n == Neurons.end()) continue;
+        auto N = n->second;
+        auto ndimensions = N -> getDimensionsCount();
+        indk::Model::NeuronRecord nrecord{};
+        nrecord.Name = Builder.doAddString(nname);
+        auto l = Latencies.find(nname);
+        if (l != Latencies.end()) {
+            nrecord.Latency = l->second;
+            nrecord.Flags |= indk::Model::NeuronFlags::LatencyFlag;
+        }
+        nrecord.Xm = N -> getXm();
+        nrecord.DimensionsCount = ndimensions;
+        nrecord.ProcessingMode = N -> getProcessingMode();
+        nrecord.OutputMode = N -> getOutputMode();
+
+        std::vector<uint64_t> entries;
+        for (const auto &e: N->getEntries()) entries.push_back(Builder.doAddString(e));
+        nrecord.EntriesCount = entries.size();
+        nrecord.Entries = Builder.doAddSection(entries.data(), entries.size()*sizeof(uint64_t));
+
+        std::vector<std::pair<uint64_t, std::pair<uint32_t, uint64_t>>> synapses;
+        for (int64_t e = 0; e < N->getEntriesCount(); e++) {
+            auto ne = N -> getEntry(e);
+            for (int64_t s = 0; s < ne->getSynapsesCount(); s++) {
+                synapses.push_back(std::make_pair(ne->getSynapse(s)->getSID(), std::make_pair(e, s)));
+            }
+        }
+        std::sort(synapses.begin(), synapses.end());
+
+        auto stride = (synapses.size()+indk_MODEL_STRIDE_STEP-1) / indk_MODEL_STRIDE_STEP * indk_MODEL_STRIDE_STEP;
+        std::vector<float> spos(stride*ndimensions), slambda(stride), sk1, sk2;
+        std::vector<uint32_t> sentry;
+        std::vector<int32_t> stype;
+        std::vector<int64_t> stl;
+        for (uint64_t s = 0; s < synapses.size(); s++) {
+            auto ns = N -> getEntry(synapses[s].second.first) -> getSynapse(synapses[s].second.second);
+            for (unsigned int d = 0; d < ndimensions; d++) spos[d*stride+s] = ns->getPos()->getPositionValue(d);
+            slambda[s] = ns -> getLambda();
+            sentry.push_back(synapses[s].second.first);
+            stype.push_back(ns->getNeurotransmitterType());
+            sk1.push_back(ns->getk1());
+            sk2.push_back(ns->getk2());
+            stl.push_back(ns->getTl());
+        }
+        nrecord.SynapsesCount = synapses.size();
+        nrecord.SynapsesStride = stride;
+        nrecord.SynapsePos = Builder.doAddSection(spos.data(), spos.size()*sizeof(float));
+        nrecord.SynapseLambda = Builder.doAddSection(slambda.data(), slambda.size()*sizeof(float));
+        nrecord.SynapseEntry = Builder.doAddSection(sentry.data(), sentry.size()*sizeof(uint32_t));
+        nrecord.SynapseType = Builder.doAddSection(stype.data(), stype.size()*sizeof(int32_t));
+        nrecord.SynapseK1 = Builder.doAddSection(sk1.data(), sk1.size()*sizeof(float));
+        nrecord.SynapseK2 = Builder.doAddSection(sk2.data(), sk2.size()*sizeof(float));
+        nrecord.SynapseTl = Builder.doAddSection(stl.data(), stl.size()*sizeof(int64_t));
+
+        std::vector<float> rpos, rk3;
+        std::vector<uint64_t> rscopes;
+        uint64_t sstride = 0;
+        for (int64_t r = 0; r < N->getReceptorsCount(); r++) {
+            auto nr = N -> getReceptor(r);
+            for (unsigned int d = 0; d < ndimensions; d++) rpos.push_back(nr->getPos0()->getPositionValue(d));
+            rk3.push_back(nr->getk3());
+            rscopes.push_back(nr->getScopesCount());
+            sstride = std::max(sstride, rscopes.back());
+        }
+        std::vector<float> scopes(rscopes.size()*ndimensions*sstride);
+        for (uint64_t r = 0; r < rscopes.size(); r++) {
+            const auto &nscopes = N -> getReceptor(r) -> getReferencePosScopes();
+            for (uint64_t sc = 0; sc < nscopes.size(); sc++) {
+                for (unsigned int d = 0; d < ndimensions; d++) scopes[(r*ndimensions+d)*sstride+sc] = nscopes[sc]->getPositionValue(d);
+            }
+        }
+        nrecord.ReceptorsCount = rk3.size();
+        nrecord.ReceptorPos0 = Builder.doAddSection(rpos.data(), rpos.size()*sizeof(float));
+        nrecord.ReceptorK3 = Builder.doAddSection(rk3.data(), rk3.size()*sizeof(float));
+        nrecord.ScopesStride = sstride;
+        nrecord.ReceptorScopes = Builder.doAddSection(rscopes.data(), rscopes.size()*sizeof(uint64_t));
+        nrecord.ScopePos = Builder.doAddSection(scopes.data(), scopes.size()*sizeof(float));
+        Builder.doAddNeuron(nrecord);
+    }
+}
+
+/**
+ * Write checkpoint of the neural network to the append-only log (see indk::Checkpoint). The first checkpoint to the path
+ * writes the snapshot of the whole network, next checkpoints append only the changes made after the previous checkpoint:
+ * new or changed neurons, new or changed reference scopes of the receptors and deleted neurons. The log is compacted to
+ * a new snapshot when the appended records exceed the snapshot size multiplied by the compaction ratio
+ * (see setCheckpointCompaction).
+ * @param Path Path to the checkpoint log.
+ */
+void indk::NeuralNet::doCheckpoint(const std::string& Path) {
+    doMaterialiseModel();
+    if (Path != CheckpointLog.Path) {
+        doCompactCheckpoint(Path);
+        return;
+    }
+
+    std::vector<std::string> nchanged, ndeleted;
+    std::vector<char> scopes, deleted;
+    std::unordered_map<std::string, indk::NeuronCheckpoint> states;
+    auto doAppendData = [] (std::vector<char>& Data, const void *Value, uint64_t Size) {
+        Data.insert(Data.end(), (const char*)Value, (const char*)Value+Size);
+    };
+
+    for (const auto &n: Neurons) {
+        auto l = Latencies.find(n.first);
+        auto state = doFingerprintNeuron(n.second, l != Latencies.end() ? &l->second : nullptr);
+        auto last = CheckpointLog.Neurons.find(n.first);
+        bool changed = last == CheckpointLog.Neurons.end() || last->second.Structure != state.Structure;
+        for (uint64_t r = 0; !changed && r < state.ScopesCount.size(); r++) {
+            if (state.ScopesCount[r] < last->second.ScopesCount[r]) changed = true;
+        }
+
+        if (changed) {
+            nchanged.push_back(n.first);
+        } else {
+            std::vector<indk::Checkpoint::ScopeHeader> nscopes;
+            uint64_t first = 0, lfirst = 0;
+            for (uint64_t r = 0; r < state.ScopesCount.size(); r++) {
+                for (uint64_t sc = 0; sc < state.ScopesCount[r]; sc++) {
+                    if (sc < last->second.ScopesCount[r] && state.Scopes[first+sc] == last->second.Scopes[lfirst+sc]) continue;
+                    nscopes.push_back({(uint32_t)r, (uint32_t)sc});
+                }
+                first += state.ScopesCount[r];
+                lfirst += last->second.ScopesCount[r];
+            }
+
+            if (!nscopes.empty()) {
+                auto ndimensions = n.second -> getDimensionsCount();
+                indk::Checkpoint::ScopesHeader sheader{};
+                sheader.NameSize = n.first.size();
+                sheader.ScopesCount = nscopes.size();
+                sheader.DimensionsCount = ndimensions;
+                doAppendData(scopes, &sheader, sizeof(sheader));
+                doAppendData(scopes, n.first.data(), n.first.size());
+                scopes.resize((scopes.size()+3)/4*4, 0);
+                std::vector<float> pos(ndimensions);
+                for (const auto &sc: nscopes) {
+                    auto scope = n.second -> getReceptor(sc.Receptor) -> getReferencePosScopes()[sc.Scope];
+                    for (unsigned int d = 0; d < ndimensions; d++) pos[d] = scope->getPositionValue(d);
+                    doAppendData(scopes, &sc, sizeof(sc));
+                    doAppendData(scopes, pos.data(), pos.size()*sizeof(float));
+                }
+            }
+        }
+        states.emplace(n.first, std::move(state));
+    }
+
+    for (const auto &n: CheckpointLog.Neurons) {
+        if (Neurons.find(n.first) != Neurons.end()) continue;
+        uint32_t size = n.first.size();
+        doAppendData(deleted, &size, sizeof(size));
+        doAppendData(deleted, n.first.data(), n.first.size());
+    }
+
+    auto topology = doHashTopology();
+    auto size = CheckpointLog.Size;
+    if (!deleted.empty()) {
+        size = indk::Checkpoint::doAppend(Path, size, indk::Checkpoint::RecordTypes::DeleteRecord, 0, deleted.data(), deleted.size());
+    }
+    if (!nchanged.empty() || topology != CheckpointLog.Topology) {
+        indk::Model::Builder builder;
+        doBuildImage(builder, nchanged, topology != CheckpointLog.Topology);
+        const auto &image = builder.doBuild();
+        size = indk::Checkpoint::doAppend(Path, size, indk::Checkpoint::RecordTypes::NeuronsRecord,
+                                          topology != CheckpointLog.Topology ? indk::Checkpoint::RecordFlags::TopologyFlag : 0,
+                                          image.data(), image.size());
+    }
+    if (!scopes.empty()) {
+        size = indk::Checkpoint::doAppend(Path, size, indk::Checkpoint::RecordTypes::ScopesRecord, 0, scopes.data(), scopes.size());
+    }
+
+    CheckpointLog.Neurons = std::move(states);
+    CheckpointLog.Topology = topology;
+    CheckpointLog.Size = size;
+
+    auto appended = size - indk::Checkpoint::getRecordSize(0) - indk::Checkpoint::getRecordSize(CheckpointLog.SnapshotSize);
+    if (CheckpointLog.Compaction > 0 && appended > CheckpointLog.Compaction*CheckpointLog.SnapshotSize) doCompactCheckpoint(Path);
+}
+
+/**
+ * Replace the checkpoint log with the snapshot of the whole neural network. The new log is written to the temporary
+ * file first, so the previous log stays valid until the snapshot is completely written.
+ * @param Path Path to the checkpoint log.
+ */
+void indk::NeuralNet::doCompactCheckpoint(const std::string& Path) {
+    doMaterialiseModel();
+    indk::Model::Builder builder;
+    std::vector<std::string> nnames;
+    for (const auto& n: Neurons) nnames.push_back(n.first);
+    doBuildImage(builder, nnames, true);
+    const auto &image = builder.doBuild();
+
+    auto temp = Path + ".tmp";
+    indk::Checkpoint::doCreate(temp);
+    auto size = indk::Checkpoint::doAppend(temp, indk::Checkpoint::getRecordSize(0), indk::Checkpoint::RecordTypes::SnapshotRecord,
+                                           indk::Checkpoint::RecordFlags::TopologyFlag, image.data(), image.size());
+#ifdef _WIN32
+    std::remove(Path.c_str());
+#endif
+    if (std::rename(temp.c_str(), Path.c_str()) != 0) throw indk::Error(indk::Error::EX_CHECKPOINT_IO);
+
+    CheckpointLog.Path = Path;
+    CheckpointLog.Size = size;
+    CheckpointLog.SnapshotSize = image.size();
+    doUpdateCheckpointState();
+}
+
+/**
+ * Load neural network from the checkpoint log. The snapshot and all records appended after it are replayed,
+ * model images of the records are read in place. Next checkpoints to the same path are appended to the log.
+ * @param Path Path to the checkpoint log.
+ */
+void indk::NeuralNet::doLoadCheckpoint(const std::string& Path) {
+    indk::Checkpoint log(Path);
+    const auto &records = log.getRecords();
+    if (records.empty() || records[0].Type != indk::Checkpoint::RecordTypes::SnapshotRecord)
+        throw indk::Error(indk::Error::EX_CHECKPOINT_FORMAT);
+
+    uint64_t snapshot = 0;
+    for (const auto &record: records) {
+        indk::Model image;
+        switch (record.Type) {
+            case indk::Checkpoint::RecordTypes::SnapshotRecord:
+                image.doOpen(record.Data, record.Size);
+                doBuildModel(image, false, false);
+                snapshot = record.Size;
+                break;
+
+            case indk::Checkpoint::RecordTypes::NeuronsRecord: {
+                image.doOpen(record.Data, record.Size);
+                auto header = image.getHeader();
+                if (record.Flags & indk::Checkpoint::RecordFlags::TopologyFlag) {
+                    Name = image.getString(header->Name);
+                    Description = image.getString(header->Description);
+                    Version = image.getString(header->ModelVersion);
+                    Entries.clear();
+                    for (const auto &ename: image.getStrings(header->Entries, header->EntriesCount)) Entries.emplace_back(ename, std::vector<std::string>());
+                    Outputs = image.getStrings(header->Outputs, header->OutputsCount);
+                    Ensembles.clear();
+                    for (uint64_t i = 0; i < header->EnsemblesCount; i++) {
+                        auto erecord = image.getEnsemble(i);
+                        Ensembles[image.getString(erecord->Name)] = image.getStrings(erecord->Members, erecord->MembersCount);
+                    }
+                }
+                for (uint64_t i = 0; i < header->NeuronsCount; i++) {
+                    auto nrecord = image.getNeuron(i);
+                    auto nname = image.getString(nrecord->Name);
+                    auto N = doCopyNeuron(image, i);
+                    doDeleteNeuron(nname);
+                    Neurons.insert(std::make_pair(nname, N));
+                    Latencies.erase(nname);
+                    if (nrecord->Flags & indk::Model::NeuronFlags::LatencyFlag) Latencies.insert(std::make_pair(nname, nrecord->Latency));
+                }
+                break;
+            }
+
+            case indk::Checkpoint::RecordTypes::ScopesRecord: {
+                uint64_t p = 0;
+                while (p < record.Size) {
+                    indk::Checkpoint::ScopesHeader sheader{};
+                    if (p+sizeof(sheader) > record.Size) throw indk::Error(indk::Error::EX_CHECKPOINT_FORMAT);
+                    memcpy(&sheader, record.Data+p, sizeof(sheader));
+                    p += sizeof(sheader);
+                    uint64_t item = sizeof(indk::Checkpoint::ScopeHeader) + (uint64_t)sheader.DimensionsCount*sizeof(float);
+                    uint64_t name = ((uint64_t)sheader.NameSize+3) / 4 * 4;
+                    if (name > record.Size-p || sheader.ScopesCount > (record.Size-p-name)/item) throw indk::Error(indk::Error::EX_CHECKPOINT_FORMAT);
+                    auto n = Neurons.find(std::string(record.Data+p, sheader.NameSize));
+                    p += name;
+                    if (n == Neurons.end() || n->second->getDimensionsCount() != sheader.DimensionsCount) throw indk::Error(indk::Error::EX_CHECKPOINT_FORMAT);
+
+                    for (uint32_t i = 0; i < sheader.ScopesCount; i++, p += item) {
+                        indk::Checkpoint::ScopeHeader scope{};
+                        memcpy(&scope, record.Data+p, sizeof(scope));
+                        if (scope.Receptor >= n->second->getReceptorsCount()) throw indk::Error(indk::Error::EX_CHECKPOINT_FORMAT);
+                        auto nr = n -> second -> getReceptor(scope.Receptor);
+                        while (nr->getReferencePosScopes().size() <= scope.Scope) nr -> doCreateNewScope();
+                        auto pos = (const float*)(record.Data+p+sizeof(scope));
+                        nr -> setReferencePos(scope.Scope, pos);
+                    }
+                }
+                break;
+            }
+
+            case indk::Checkpoint::RecordTypes::DeleteRecord: {
+                uint64_t p = 0;
+                while (p < record.Size) {
+                    uint32_t size;
+                    if (p+sizeof(size) > record.Size) throw indk::Error(indk::Error::EX_CHECKPOINT_FORMAT);
+                    memcpy(&size, record.Data+p, sizeof(size));
+                    p += sizeof(size);
+                    if (p+size > record.Size) throw indk::Error(indk::Error::EX_CHECKPOINT_FORMAT);
+                    std::string nname(record.Data+p, size);
+                    p += size;
+                    doDeleteNeuron(nname);
+                    Latencies.erase(nname);
+                }
+                break;
+            }
+        }
+    }
+
+    doLinkStructure();
+    CheckpointLog.Path = Path;
+    CheckpointLog.Size = log.getSize();
+    CheckpointLog.SnapshotSize = snapshot;
+    doUpdateCheckpointState();
+}
+
+/**
+ * Rebuild entry links and output links of all neurons from the neuron entries.
+ */
+void indk::NeuralNet::doLinkStructure() {
+    std::multimap<std::string, std::string> links;
+    for (const auto &n: Neurons) {
+        n.second -> doClearOutputLinks();
+        for (const auto &iname: n.second->getEntries()) links.insert(std::make_pair(iname, n.first));
+    }
+    for (auto &e: Entries) {
+        e.second.clear();
+        auto l = links.equal_range(e.first);
+        for (auto it = l.first; it != l.second; it++) e.second.push_back(it->second);
+    }
+    for (const auto &n: Neurons) {
+        auto l = links.equal_range(n.first);
+        for (auto it = l.first; it != l.second; it++) n.second -> doLinkOutput(it->second);
+    }
+    PrepareID = "";
+    OutputTableValid = false;
+}
+
+/**
+ * Save the state of all neurons as the state of the last checkpoint.
+ */
+void indk::NeuralNet::doUpdateCheckpointState() {
+    CheckpointLog.Neurons.clear();
+    for (const auto &n: Neurons) {
+        auto l = Latencies.find(n.first);
+        CheckpointLog.Neurons.emplace(n.first, doFingerprintNeuron(n.second, l != Latencies.end() ? &l->second : nullptr));
+    }
+    CheckpointLog.Topology = doHashTopology();
+}
+
+/**
+ * Get hash of the neural network name, entries, outputs and ensembles.
+ */
+uint64_t indk::NeuralNet::doHashTopology() {
+    auto h = doHashString(HashBasis, Name);
+    h = doHashString(h, Description);
+    h = doHashString(h, Version);
+    h = doHashValue(h, Entries.size());
+    for (const auto &e: Entries) h = doHashString(h, e.first);
+    h = doHashValue(h, Outputs.size());
+    for (const auto &o: Outputs) h = doHashString(h, o);
+    h = doHashValue(h, Ensembles.size());
+    for (const auto &e: Ensembles) {
+        h = doHashString(h, e.first);
+        h = doHashValue(h, e.second.size());
+        for (const auto &en: e.second) h = doHashString(h, en);
+    }
+    return h;
+}
+
 /**
  * Set neural network to `learned` state.
  * @param LearnedFlag
  */
 void indk::NeuralNet::setLearned(bool LearnedFlag) {
+    Residency.Learned = LearnedFlag;
     for (const auto& N: Neurons) {
         N.second -> setLearned(LearnedFlag);
     }
@@ -1013,6 +2771,47 @@ void indk::NeuralNet::setStateSyncEnabled(bool enabled) {
     StateSyncEnabled = enabled;
 }
 
+/**
+ * Enable culling of negligible synapse-receptor pairs for all neurons. Disabled by default.
+ * @param Epsilon Relative cutoff value: synapses with exp(-Lambda*D) below it are not visited by receptors. Zero value disables culling.
+ * @param Skin Skin radius. Receptor neighbour lists are rebuilt only after the receptor has moved further than this distance.
+ */
+void indk::NeuralNet::setCulling(float Epsilon, float Skin) {
+    Residency.CullingEpsilon = Epsilon;
+    Residency.CullingSkin = Skin;
+    for (const auto& N: Neurons) {
+        N.second -> setCulling(Epsilon, Skin);
+    }
+}
+
+/**
+ * Bind the neural net to the runtime. Neural nets bound to the same runtime share its compute backend,
+ * transfers of the backends that need synchronization are executed one at a time.
+ * @param NetRuntime Runtime object, nullptr - use the global runtime (see indk::System::setComputeBackend).
+ */
+void indk::NeuralNet::setRuntime(const std::shared_ptr<indk::Runtime>& NetRuntime) {
+    BoundRuntime = NetRuntime;
+}
+
+/**
+ * Set the compaction ratio of the checkpoint log (see doCheckpoint).
+ * @param Ratio Log is compacted when the records appended after the snapshot exceed the snapshot size multiplied
+ * by the ratio, 0 - compact only by doCompactCheckpoint. Default value is indk_CHECKPOINT_COMPACTION.
+ */
+void indk::NeuralNet::setCheckpointCompaction(float Ratio) {
+    CheckpointLog.Compaction = Ratio;
+}
+
+/**
+ * Set the limit of resident ensembles of the lazily attached model (see doAttachModel). The least recently used
+ * ensembles are released when the execution plan is built, ensembles used by the plan are never released,
+ * so the limit can be exceeded by a plan that uses more ensembles.
+ * @param Limit Maximum count of resident ensembles, 0 - no limit (default).
+ */
+void indk::NeuralNet::setResidentEnsemblesLimit(uint64_t Limit) {
+    Residency.Limit = Limit;
+}
+
 /**
  * Check if neural network is in learned state.
  * @return
@@ -1030,9 +2829,7 @@ bool indk::NeuralNet::isLearned() {
  * @return indk::Neuron object pointer.
  */
 indk::Neuron* indk::NeuralNet::getNeuron(const std::string& NName) {
-    auto N = Neurons.find(NName);
-    if (N != Neurons.end()) return N->second;
-    return nullptr;
+    return doMaterialiseNeuron(NName);
 }
 
 /**
@@ -1055,6 +2852,14 @@ uint64_t indk::NeuralNet::getNeuronCount() {
     return Neurons.size();
 }
 
+/**
+ * Check if neural network is attached to the binary model image (see doAttachModel).
+ * @return True if neurons use the learned geometry of the mapped image.
+ */
+bool indk::NeuralNet::isAttached() const {
+    return AttachedModel != nullptr;
+}
+
 /**
  * Get neural network structure in JSON format.
  * @return JSON string that contains neural network structure.
@@ -1062,6 +2867,8 @@ uint64_t indk::NeuralNet::getNeuronCount() {
 std::string indk::NeuralNet::getStructure(bool minimized) {
     json j;
 
+    doMaterialiseModel();
+
     for (const auto& e: Entries) {
         j["entries"].push_back(e.first);
     }
@@ -1196,6 +3003,62 @@ std::vector<indk::Neuron*> indk::NeuralNet::getEnsemble(const std::string& ename
     return {};
 }
 
+/**
+ * Get output ID by the output neuron name.
+ * @param name Name of the output neuron.
+ * @return Output ID or -1 if the neuron is not an output of the neural net.
+ */
+int64_t indk::NeuralNet::getOutputID(const std::string& name) {
+    doBuildOutputTable();
+    auto o = OutputIndex.find(name);
+    if (o == OutputIndex.end()) return -1;
+    return o->second;
+}
+
+/**
+ * Get runtime used by the neural net.
+ * @return Bound runtime or the global runtime if the neural net is not bound.
+ */
+std::shared_ptr<indk::Runtime> indk::NeuralNet::getRuntime() {
+    return BoundRuntime ? BoundRuntime : indk::System::getRuntime();
+}
+
+uint64_t indk::NeuralNet::getOutputsCount() const {
+    return Outputs.size();
+}
+
+/**
+ * Get latency of the output neuron.
+ * @param OutputID Output ID (see getOutputID).
+ * @return Latency value from the structure, 0 if the neuron has no latency.
+ */
+int indk::NeuralNet::getOutputLatency(uint64_t OutputID) const {
+    if (OutputID >= Outputs.size()) return 0;
+    auto l = Latencies.find(Outputs[OutputID]);
+    return l != Latencies.end() ? l->second : 0;
+}
+
+/**
+ * Get IDs of the outputs that belong to the ensemble.
+ * @param ename Name of the ensemble.
+ * @return Output IDs in the order of the neural net output list.
+ */
+const std::vector<uint64_t>& indk::NeuralNet::getEnsembleOutputs(const std::string& ename) {
+    static const std::vector<uint64_t> empty;
+    doBuildOutputTable();
+    auto e = EnsembleOutputs.find(ename);
+    if (e == EnsembleOutputs.end()) return empty;
+    return e->second;
+}
+
+/**
+ * Get count of resident ensembles of the lazily attached model.
+ * @return Count of ensembles that have materialised neurons, 0 if the model is not attached lazily.
+ */
+uint64_t indk::NeuralNet::getResidentEnsemblesCount() const {
+    return Residency.Resident.size();
+}
+
 int64_t indk::NeuralNet::getSignalBufferSize() {
     int64_t size = -1;
     for (auto &n: Neurons) {
@@ -1207,5 +3070,6 @@ int64_t indk::NeuralNet::getSignalBufferSize() {
 }
 
 indk::NeuralNet::~NeuralNet() {
+    doWaitAsync();
     for (const auto& N: Neurons) delete N.second;
 }
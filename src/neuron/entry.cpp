@@ -14,18 +14,18 @@ indk::Neuron::Entry::Entry() {
     t = 0;
     tm = -1;
     SignalPointer = 0;
-    Signal = new float;
+    Signal = new float[1];
     SignalSize = 1;
 }
 
-indk::Neuron::Entry::Entry(const Entry &E) {
+indk::Neuron::Entry::Entry(const Entry &E, indk::Neuron::Store *Storage, bool ShareGeometry) {
     for (int64_t i = 0; i < E.getSynapsesCount(); i++) {
-        auto *S = new Synapse(*E.getSynapse(i));
+        auto *S = Storage->getArena()->doCreate<Synapse>(*E.getSynapse(i), Storage, ShareGeometry);
         Synapses.push_back(S);
     }
     t = 0;
     tm = -1;
-    Signal = new float;
+    Signal = new float[1];
     SignalSize = 1;
     SignalPointer = 0;
 }
@@ -35,14 +35,29 @@ bool indk::Neuron::Entry::doCheckState(int64_t tn) const {
     return tm >= tn;
 }
 
-void indk::Neuron::Entry::doAddSynapse(indk::Position *SPos, unsigned int Xm, float k1, int64_t Tl, int NT) {
-	auto *S = new Synapse(SPos, k1, indk::Computer::getLambdaValue(Xm), Tl, NT);
+void indk::Neuron::Entry::doAddSynapse(indk::Neuron::Store *Storage, const indk::Position *SPos, float k1, int64_t Tl, int NT) {
+    auto SID = Storage -> doAddSynapse(SPos, indk::Computer::getLambdaValue(Storage->getXm()));
+	auto *S = Storage->getArena()->doCreate<Synapse>(Storage, SID, k1, Tl, NT);
     Synapses.push_back(S);
 }
 
+/**
+ * Add synapse over the existing storage slot.
+ * @param Storage Neuron storage.
+ * @param SID Index of the synapse in the storage.
+ */
+void indk::Neuron::Entry::doAttachSynapse(indk::Neuron::Store *Storage, uint64_t SID, float k1, float k2, int64_t Tl, int NT) {
+    auto *S = Storage->getArena()->doCreate<Synapse>(Storage, SID, k1, Tl, NT);
+    S -> setk2(k2);
+    Synapses.push_back(S);
+}
+
+void indk::Neuron::Entry::doBindStore() {
+    for (auto S: Synapses) S -> doBindStore();
+}
+
 void indk::Neuron::Entry::doIn(float Xt, int64_t tn) {
-    if (SignalPointer >= SignalSize) SignalPointer = 0;
-    Signal[SignalPointer] = Xt;
+    Signal[SignalPointer%SignalSize] = Xt;
     SignalPointer++;
     tm = tn;
 //    std::cout << "In entry " << tm << " " << t << " " << SignalPointer << " " << Signal[SignalPointer-1] << " " << Xt << std::endl;
@@ -51,10 +66,11 @@ void indk::Neuron::Entry::doIn(float Xt, int64_t tn) {
 void indk::Neuron::Entry::doProcess() {
     auto d = tm - t + 1;
 //    std::cout << "Entry " << tm << " " << t << " " << d << " " << SignalPointer-d << " " << Signal[SignalPointer-d] << std::endl;
-    if (d > 0 && SignalPointer-d >= 0) {
+    if (d > 0 && d <= SignalSize && SignalPointer-d >= 0) {
 //        std::cout << SignalPointer-d << std::endl;
+        auto x = Signal[(SignalPointer-d)%SignalSize];
         for (auto S: Synapses) {
-            if (t >= S->getTl()) S -> doIn(Signal[SignalPointer-d]);
+            if (t >= S->getTl()) S -> doIn(x);
             else S -> doIn(0);
         }
         t++;
@@ -64,6 +80,7 @@ void indk::Neuron::Entry::doProcess() {
 void indk::Neuron::Entry::doPrepare() {
     t = 0;
     tm = -1;
+    SignalPointer = 0;
     for (auto S: Synapses) S -> doReset();
     //for (auto S: Synapses) S -> doPrepare();
 }
@@ -75,10 +92,17 @@ void indk::Neuron::Entry::doFinalize() {
     //Signal.clear();
 }
 
+/**
+ * Reserve ring buffer for the input signals and reset it. The buffer is reallocated only if its size is changed.
+ * @param L Count of ticks kept in the buffer.
+ */
 void indk::Neuron::Entry::doReserveSignalBuffer(uint64_t L) {
-    delete [] Signal;
-    Signal = new float[L];
-    SignalSize = L;
+    if (!L) L = 1;
+    if (L != (uint64_t)SignalSize) {
+        delete [] Signal;
+        Signal = new float[L];
+        SignalSize = L;
+    }
     SignalPointer = 0;
 }
 
@@ -108,13 +132,14 @@ int64_t indk::Neuron::Entry::getSynapsesCount() const {
 
 float indk::Neuron::Entry::getIn() {
     auto d = tm - t + 1;
-    if (d > 0 && SignalPointer-d >= 0) {
+    if (d > 0 && d <= SignalSize && SignalPointer-d >= 0) {
         t++;
-        return Signal[SignalPointer-d];
+        return Signal[(SignalPointer-d)%SignalSize];
     }
     return 0;
 }
 
 indk::Neuron::Entry::~Entry() {
-    for (auto S: Synapses) delete S;
+    for (auto S: Synapses) indk::Arena::doDestroy(S);
+    delete [] Signal;
 }
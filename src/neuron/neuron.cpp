@@ -10,6 +10,7 @@
 #include <indk/neuron.h>
 #include <indk/error.h>
 #include <indk/system.h>
+#include <indk/kernel.h>
 #include <algorithm>
 
 indk::Neuron::Neuron() {
@@ -17,32 +18,47 @@ indk::Neuron::Neuron() {
     Tlo = 0;
     Xm = 0;
     DimensionsCount = 0;
-    OutputSignal = new float;
+    Storage = new indk::Neuron::Store(Xm, DimensionsCount);
+    OutputSignal = new float[1];
     OutputSignalSize = 1;
     OutputSignalPointer = 0;
+    TrajectoryCapacity = 0;
+    TrajectoryPointer = 0;
     NID = 0;
     ProcessingMode = indk::Neuron::ProcessingModes::ProcessingModeDefault;
     OutputMode = indk::Neuron::OutputModes::OutputModeStream;
     Learned = false;
-//    ReceptorPositionComputer = nullptr;
+    PendingTick = -1;
+    PendingCount = 0;
+    Backend = nullptr;
+    doSelectKernel();
 }
 
 indk::Neuron::Neuron(const indk::Neuron &N) {
     t = 0;
     Tlo = N.getTlo();
     Xm = N.getXm();
-    OutputSignal = new float;
+    OutputSignal = new float[1];
     OutputSignalSize = 1;
     OutputSignalPointer = 0;
+    TrajectoryCapacity = 0;
+    TrajectoryPointer = 0;
     DimensionsCount = N.getDimensionsCount();
+    Storage = new indk::Neuron::Store(Xm, DimensionsCount);
     NID = 0;
     ProcessingMode = N.getProcessingMode();
     OutputMode = N.getOutputMode();
     Learned = false;
+    PendingTick = -1;
+    PendingCount = 0;
+    Backend = nullptr;
     auto elabels = N.getEntries();
-    for (int64_t i = 0; i < N.getEntriesCount(); i++) Entries.emplace_back(elabels[i], new Entry(*N.getEntry(i)));
-    for (int64_t i = 0; i < N.getReceptorsCount(); i++) Receptors.push_back(new Receptor(*N.getReceptor(i)));
+    for (int64_t i = 0; i < N.getEntriesCount(); i++) Entries.emplace_back(elabels[i], Storage->getArena()->doCreate<Entry>(*N.getEntry(i), Storage));
+    for (int64_t i = 0; i < N.getReceptorsCount(); i++) Receptors.push_back(Storage->getArena()->doCreate<Receptor>(*N.getReceptor(i), Storage));
     Links = N.getLinkOutput();
+    Storage -> setCulling(N.getStore()->getCullingEpsilon(), N.getStore()->getCullingSkin());
+    doBindStore();
+    doSelectKernel();
 }
 
 indk::Neuron::Neuron(unsigned int XSize, unsigned int DC, int64_t Tl, const std::vector<std::string>& InputNames) {
@@ -50,17 +66,108 @@ indk::Neuron::Neuron(unsigned int XSize, unsigned int DC, int64_t Tl, const std:
     Tlo = Tl;
     Xm = XSize;
     DimensionsCount = DC;
-    OutputSignal = new float;
+    Storage = new indk::Neuron::Store(Xm, DimensionsCount);
+    OutputSignal = new float[1];
     OutputSignalSize = 1;
     OutputSignalPointer = 0;
+    TrajectoryCapacity = 0;
+    TrajectoryPointer = 0;
     NID = 0;
     ProcessingMode = indk::Neuron::ProcessingModes::ProcessingModeDefault;
     OutputMode = indk::Neuron::OutputModes::OutputModeStream;
     Learned = false;
+    PendingTick = -1;
+    PendingCount = 0;
+    Backend = nullptr;
     for (auto &i: InputNames) {
-        auto *E = new Entry();
+        auto *E = Storage->getArena()->doCreate<Entry>();
         Entries.emplace_back(i, E);
     }
+    doSelectKernel();
+}
+
+/**
+ * Create neuron over the learned geometry of the binary model image. Synapse positions, Lambda values,
+ * default receptor positions and reference scopes are read in place from the image and are not copied
+ * until they are changed. The image must outlive the neuron.
+ * @param Image Opened binary model image.
+ * @param NID Index of the neuron record in the image.
+ */
+indk::Neuron::Neuron(const indk::Model &Image, uint64_t NID) {
+    auto nrecord = Image.getNeuron(NID);
+    if (nrecord->SynapsesStride < nrecord->SynapsesCount || nrecord->SynapsesStride%indk_MODEL_STRIDE_STEP) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+    t = 0;
+    Tlo = 0;
+    Xm = nrecord->Xm;
+    DimensionsCount = nrecord->DimensionsCount;
+
+    auto spos = Image.getArray<float>(nrecord->SynapsePos, indk::Model::getCount(nrecord->SynapsesStride, DimensionsCount));
+    auto slambda = Image.getArray<float>(nrecord->SynapseLambda, nrecord->SynapsesStride);
+    auto rpos = Image.getArray<float>(nrecord->ReceptorPos0, indk::Model::getCount(nrecord->ReceptorsCount, DimensionsCount));
+    auto scopes = Image.getArray<float>(nrecord->ScopePos, indk::Model::getCount(indk::Model::getCount(nrecord->ReceptorsCount, DimensionsCount), nrecord->ScopesStride));
+    Storage = new indk::Neuron::Store(Xm, DimensionsCount, nrecord->SynapsesCount, nrecord->SynapsesStride, spos, slambda,
+                                      nrecord->ReceptorsCount, rpos, nrecord->ScopesStride, scopes);
+    OutputSignal = new float[1];
+    OutputSignalSize = 1;
+    OutputSignalPointer = 0;
+    TrajectoryCapacity = 0;
+    TrajectoryPointer = 0;
+    NID = 0;
+    ProcessingMode = nrecord->ProcessingMode;
+    OutputMode = nrecord->OutputMode;
+    Learned = false;
+    PendingTick = -1;
+    PendingCount = 0;
+    Backend = nullptr;
+    Name = Image.getString(nrecord->Name);
+    for (const auto &i: Image.getStrings(nrecord->Entries, nrecord->EntriesCount)) Entries.emplace_back(i, Storage->getArena()->doCreate<Entry>());
+
+    auto sentry = Image.getArray<uint32_t>(nrecord->SynapseEntry, nrecord->SynapsesCount);
+    auto stype = Image.getArray<int32_t>(nrecord->SynapseType, nrecord->SynapsesCount);
+    auto sk1 = Image.getArray<float>(nrecord->SynapseK1, nrecord->SynapsesCount);
+    auto sk2 = Image.getArray<float>(nrecord->SynapseK2, nrecord->SynapsesCount);
+    auto stl = Image.getArray<int64_t>(nrecord->SynapseTl, nrecord->SynapsesCount);
+    for (uint64_t s = 0; s < nrecord->SynapsesCount; s++) {
+        if (sentry[s] >= Entries.size()) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+        Entries[sentry[s]].second -> doAttachSynapse(Storage, s, sk1[s], sk2[s], stl[s], stype[s]);
+    }
+
+    auto rk3 = Image.getArray<float>(nrecord->ReceptorK3, nrecord->ReceptorsCount);
+    auto rscopes = Image.getArray<uint64_t>(nrecord->ReceptorScopes, nrecord->ReceptorsCount);
+    for (uint64_t r = 0; r < nrecord->ReceptorsCount; r++) {
+        if (rscopes[r] > nrecord->ScopesStride) throw indk::Error(indk::Error::EX_MODEL_FORMAT);
+        Receptors.push_back(Storage->getArena()->doCreate<Receptor>(Storage, r, rk3[r], (int64_t)rscopes[r]));
+    }
+    doSelectKernel();
+}
+
+/**
+ * Create recognition context of the neuron. The context shares learned geometry (synapse positions, Lambda values,
+ * default receptor positions and reference scopes) with this neuron and has its own copy of the runtime state.
+ * The shared geometry is reference-counted (see indk::Neuron::Store): the neuron can be changed or deleted while
+ * the context exists, the context keeps the geometry it was created with. Geometry attached from a model image
+ * is read from the image, so the image must outlive the context.
+ * @return New neuron context.
+ */
+indk::Neuron* indk::Neuron::doCreateContext() const {
+    auto N = new indk::Neuron();
+    delete N -> Storage;
+    N -> Storage = new indk::Neuron::Store(Storage);
+    N -> t = t.load();
+    N -> Tlo = Tlo;
+    N -> Xm = Xm;
+    N -> DimensionsCount = DimensionsCount;
+    N -> NID = NID;
+    N -> ProcessingMode = ProcessingMode;
+    N -> OutputMode = OutputMode;
+    N -> Learned = Learned;
+    N -> OutputsPredefined = OutputsPredefined;
+    N -> Name = Name;
+    N -> Links = Links;
+    for (const auto &E: Entries) N -> Entries.emplace_back(E.first, N->Storage->getArena()->doCreate<Entry>(*E.second, N->Storage, true));
+    for (const auto R: Receptors) N -> Receptors.push_back(N->Storage->getArena()->doCreate<Receptor>(*R, N->Storage, true));
+    N -> doSelectKernel();
+    return N;
 }
 
 /**
@@ -77,7 +184,9 @@ void indk::Neuron::doCreateNewSynapse(const std::string& EName, std::vector<floa
 	}
     for (const auto &e: Entries) {
         if (e.first == EName) {
-            e.second -> doAddSynapse(new indk::Position(Xm, std::move(PosVector)), Xm, k1, Tl, NT);
+            auto SPos = indk::Position(Xm, std::move(PosVector));
+            e.second -> doAddSynapse(Storage, &SPos, k1, Tl, NT);
+            doBindStore();
             break;
         }
     }
@@ -112,8 +221,10 @@ void indk::Neuron::doCreateNewReceptor(std::vector<float> PosVector) {
     if (PosVector.size() != DimensionsCount) {
         throw indk::Error(indk::Error::EX_POSITION_DIMENSIONS);
     }
-    auto *R = new Receptor(new indk::Position(Xm, std::move(PosVector)), 1);
+    auto RPos = indk::Position(Xm, std::move(PosVector));
+    auto *R = Storage->getArena()->doCreate<Receptor>(Storage, Storage->doAddReceptor(&RPos), 1);
     Receptors.push_back(R);
+    doBindStore();
 }
 
 /**
@@ -148,21 +259,36 @@ void indk::Neuron::doCreateNewReceptorCluster(const std::vector<float>& PosVecto
 }
 
 bool indk::Neuron::doSignalSendEntry(const std::string& From, float X, int64_t tn) {
-    for (const auto &e: Entries) {
-        if (e.first == From) {
-            e.second -> doIn(X, tn);
-            break;
-        }
-    }
+    return doSignalSendEntry(getEntryIndex(From), X, tn);
+}
 
-    for (auto &e: Entries) {
-        if (!e.second->doCheckState(tn)) {
-//            std::cout << "In to entry of " << Name << " from " << From << " value " << X << " (" << tn << ") - not ready" << std::endl;
-            return false;
+/**
+ * Send signal to the neuron entry by entry index. The neuron is computed when the last entry for the tick receives its signal.
+ * @param EID Entry index (see getEntryIndex).
+ * @param X Signal value.
+ * @param tn Tick of the signal.
+ * @return True if all entries have received signals for the tick.
+ */
+bool indk::Neuron::doSignalSendEntry(int64_t EID, float X, int64_t tn) {
+    if (EID < 0 || (uint64_t)EID >= Entries.size()) return false;
+    auto E = Entries[EID].second;
+
+    // count of entries that are still waiting for the tick, recounted only when the tick changes
+    if (tn != PendingTick) {
+        PendingTick = tn;
+        PendingCount = 0;
+        for (const auto &e: Entries) {
+            if (!e.second->doCheckState(tn)) PendingCount++;
         }
     }
-//    std::cout << "In to entry of " << Name << " from " << From << " value " << X <<  " (" << tn << ") - ready" << std::endl;
-    indk::System::getComputeBackend() -> doProcess((void*)this);
+
+    auto waiting = !E->doCheckState(tn);
+    E -> doIn(X, tn);
+
+    if (!waiting) return !PendingCount;
+    if (--PendingCount) return false;
+
+    (Backend ? Backend : indk::System::getComputeBackend()) -> doProcess((void*)this);
     return true;
 }
 
@@ -176,13 +302,14 @@ std::pair<int64_t, float> indk::Neuron::doSignalReceive(int64_t tT) {
     if (tT == -1) tT = tlocal - 1;
     auto d = tlocal - tT;
 
-    if (d > 0 && OutputSignalPointer-d >= 0) {
+    if (d > 0 && d <= OutputSignalSize && OutputSignalPointer-d >= 0) {
+        auto value = OutputSignal[(OutputSignalPointer-d)%OutputSignalSize];
         if (OutputMode != indk::Neuron::OutputModes::OutputModeStream && Learned) {
             auto patterns = doComparePattern();
             if (std::get<0>(patterns) < 10e-4) {
                 switch (OutputMode) {
                     case indk::Neuron::OutputModes::OutputModeLatch:
-                        return std::make_pair(tT, OutputSignal[OutputSignalPointer-d]);
+                        return std::make_pair(tT, value);
 
                     case indk::Neuron::OutputModes::OutputModePredefined:
                         if (std::get<1>(patterns) >= OutputsPredefined.size())
@@ -193,7 +320,7 @@ std::pair<int64_t, float> indk::Neuron::doSignalReceive(int64_t tT) {
             } else
                 return std::make_pair(tT, 0);
         }
-        return std::make_pair(tT, OutputSignal[OutputSignalPointer-d]);
+        return std::make_pair(tT, value);
     } else {
         if (indk::System::getVerbosityLevel() > 1)
             std::cerr << "[" << Name << "] Output for time " << tT << " is not ready yet" << std::endl;
@@ -202,18 +329,50 @@ std::pair<int64_t, float> indk::Neuron::doSignalReceive(int64_t tT) {
 }
 
 void indk::Neuron::doFinalizeInput(float P) {
-    if (OutputSignalPointer >= OutputSignalSize) OutputSignalPointer = 0;
-    OutputSignal[OutputSignalPointer] = P;
+    if (TrajectoryCapacity) doCaptureTrajectory();
+    OutputSignal[OutputSignalPointer%OutputSignalSize] = P;
     OutputSignalPointer++;
     t.store(t.load()+1);
 //    std::cout << "Object processed " << Name << std::endl;
 }
 
 /**
- * Prepare synapses for new signal.
+ * Write positions of all receptors at the current tick to the trajectory ring buffer. The buffer is cleared
+ * if the receptors count has changed since the capture was enabled.
  */
+void indk::Neuron::doCaptureTrajectory() {
+    auto stride = Receptors.size() * DimensionsCount;
+    if (TrajectoryPos.size() != TrajectoryCapacity*stride) {
+        TrajectoryPos.assign(TrajectoryCapacity*stride, 0);
+        TrajectoryPointer = 0;
+    }
+    auto slot = TrajectoryPointer % TrajectoryCapacity;
+    auto record = TrajectoryPos.data() + slot*stride;
+    for (auto R: Receptors) {
+        auto pos = R->isLocked() ? R->getPosf() : R->getPos();
+        for (unsigned int d = 0; d < DimensionsCount; d++) record[d] = pos -> getPositionValue(d);
+        record += DimensionsCount;
+    }
+    TrajectoryTicks[slot] = t.load();
+    TrajectoryPointer++;
+}
+
+/**
+ * Process one tick of the neuron with the kernel selected for its dimensions count and processing mode.
+ */
+void indk::Neuron::doProcess() {
+    ProcessKernel(this);
+}
+
+void indk::Neuron::doSelectKernel() {
+    ProcessKernel = indk::Kernel::getProcessFunction(DimensionsCount, ProcessingMode, Storage->isCullingEnabled());
+}
+
 void indk::Neuron::doPrepare() {
+    PendingTick = -1;
+    OutputSignalPointer = 0;
     t.store(0);
+    doSelectKernel();
     for (auto E: Entries) E.second -> doPrepare();
     for (auto R: Receptors) R -> doPrepare();
 }
@@ -234,39 +393,51 @@ void indk::Neuron::doChangeScope(uint64_t scope) {
 }
 
 /**
- * Reset neuron state. During the reset, the neuron parameters (time, receptors, synapses) will be reset to the default state.
+ * Reset neuron state. During the reset, the neuron parameters (time, receptors, synapses) will be reset to the default state,
+ * the reference scopes are released at once and every receptor gets one new scope at its default position.
+ * Captured trajectory records are dropped, the capture stays enabled.
  */
 void indk::Neuron::doReset() {
+    PendingTick = -1;
+    OutputSignalPointer = 0;
     t.store(0);
     Learned = false;
     for (auto E: Entries) E.second -> doPrepare();
     for (auto R: Receptors) R -> doReset();
+    Storage -> getScopeArena() -> doRelease();
+    for (auto R: Receptors) R -> doCreateNewScope();
+    TrajectoryPointer = 0;
     OutputsPredefined.clear();
 }
 
+/**
+ * Compare the phantom positions of the receptors (recognition pattern) with every reference scope (learning patterns)
+ * in one pass over the scope matrix.
+ * @return Pattern difference value for every scope.
+ */
+std::vector<float> indk::Neuron::doCompareScopes() const {
+    auto ssize = Receptors.empty() ? 0 : Receptors[0]->getScopesCount();
+    std::vector<float> results(ssize, 0), distances(ssize);
+
+    for (auto R: Receptors) {
+        auto count = std::min(R->getScopesCount(), ssize);
+        Storage -> doCompareScopes(R->getRID(), count, distances.data());
+        for (uint64_t i = 0; i < count; i++) results[i] += distances[i] / Receptors.size();
+    }
+    return results;
+}
+
 /**
  * Compare neuron patterns (learning and recognition patterns).
  * @return Pattern difference value.
  */
 indk::Neuron::PatternDefinition indk::Neuron::doComparePattern(int ProcessingMethod) const {
-    indk::Position *RPosf;
-    auto ssize = Receptors[0]->getReferencePosScopes().size();
-    std::vector<float> results;
+    auto results = doCompareScopes();
+    auto ssize = results.size();
     float value = 0;
     int num = -1;
     float rmin = -1;
 
-    for (uint64_t i = 0; i < ssize; i++) results.push_back(0);
-
-    for (auto R: Receptors) {
-        auto scopes = R -> getReferencePosScopes();
-        RPosf = R -> getPosf();
-
-        for (uint64_t i = 0; i < scopes.size(); i++) {
-            results[i] += indk::Computer::doCompareFunction(scopes[i], RPosf) / Receptors.size();
-        }
-    }
-
     switch (ProcessingMethod) {
         default:
         case indk::ScopeProcessingMethods::ProcessMin:
@@ -290,6 +461,27 @@ indk::Neuron::PatternDefinition indk::Neuron::doComparePattern(int ProcessingMet
     return {value, num};
 }
 
+/**
+ * Compare neuron patterns (learning and recognition patterns) and select the closest scopes.
+ * @param K Count of the scopes to select.
+ * @return Pattern difference values and indexes of the K closest scopes, from the closest one.
+ */
+std::vector<indk::Neuron::PatternDefinition> indk::Neuron::doComparePatternTop(uint64_t K) const {
+    auto results = doCompareScopes();
+    std::vector<int> order(results.size());
+    for (uint64_t i = 0; i < order.size(); i++) order[i] = i;
+
+    K = std::min<uint64_t>(K, order.size());
+    std::partial_sort(order.begin(), order.begin()+K, order.end(), [&results](int a, int b) {
+        return results[a] < results[b] || (results[a] == results[b] && a < b);
+    });
+
+    std::vector<indk::Neuron::PatternDefinition> top;
+    top.reserve(K);
+    for (uint64_t i = 0; i < K; i++) top.emplace_back(results[order[i]], order[i]);
+    return top;
+}
+
 void indk::Neuron::doLinkOutput(const std::string& NName) {
     Links.push_back(NName);
 }
@@ -299,19 +491,25 @@ void indk::Neuron::doClearOutputLinks() {
 }
 
 void indk::Neuron::doClearEntries() {
+    PendingTick = -1;
+    for (const auto& e: Entries)
+        indk::Arena::doDestroy(e.second);
     Entries.clear();
 }
 
 void indk::Neuron::doAddEntryName(const std::string& name) {
-    auto *E = new Entry();
+    PendingTick = -1;
+    auto *E = Storage->getArena()->doCreate<Entry>();
     Entries.emplace_back(name, E);
 }
 
 void indk::Neuron::doCopyEntry(const std::string& from, const std::string& to) {
+    PendingTick = -1;
     for (auto &e: Entries) {
         if (e.first == from) {
-            auto *E = new Entry(*e.second);
+            auto *E = Storage->getArena()->doCreate<Entry>(*e.second, Storage);
             Entries.emplace_back(to, E);
+            doBindStore();
             break;
         }
     }
@@ -331,10 +529,19 @@ void indk::Neuron::doReplaceEntryName(const std::string& Original, const std::st
     }
 }
 
+/**
+ * Reserve ring buffers for the output signals and the entry signals and reset them. Buffers are reallocated only if
+ * their size is changed.
+ * @param L Count of ticks kept in the buffers.
+ */
 void indk::Neuron::doReserveSignalBuffer(int64_t L) {
-    delete [] OutputSignal;
-    OutputSignal = new float[L];
-    OutputSignalSize = L;
+    if (L < 1) L = 1;
+    PendingTick = -1;
+    if (L != OutputSignalSize) {
+        delete [] OutputSignal;
+        OutputSignal = new float[L];
+        OutputSignalSize = L;
+    }
     OutputSignalPointer = 0;
     for (auto &E: Entries) {
         E.second -> doReserveSignalBuffer(L);
@@ -349,18 +556,46 @@ void indk::Neuron::setTime(int64_t ts) {
     t.store(ts);
 }
 
+/**
+ * Enable capture of the receptor trajectory. After every processed tick the positions of all receptors
+ * (phantom positions of the locked receptors, current reference positions otherwise) are written to the ring buffer
+ * of Capacity records, the oldest records are overwritten. The buffer is allocated once here, disabled capture
+ * costs nothing. Contexts of the neuron (see doCreateContext) do not capture the trajectory.
+ * @param Capacity Count of records kept in the buffer, 0 - disable capture and release the buffer.
+ */
+void indk::Neuron::setTrajectoryCapture(uint64_t Capacity) {
+    TrajectoryCapacity = Capacity;
+    TrajectoryPointer = 0;
+    std::vector<float>(Capacity*Receptors.size()*DimensionsCount).swap(TrajectoryPos);
+    std::vector<int64_t>(Capacity).swap(TrajectoryTicks);
+}
+
 void indk::Neuron::setEntries(const std::vector<std::string>& inputs) {
+    PendingTick = -1;
     for (const auto& e: Entries)
-        delete e.second;
+        indk::Arena::doDestroy(e.second);
+    Entries.clear();
 
     for (const auto &i: inputs) {
-        auto *E = new Entry();
+        auto *E = Storage->getArena()->doCreate<Entry>();
         Entries.emplace_back(i, E);
     }
 }
 
 void indk::Neuron::setLambda(float _l) {
     for (auto E: Entries) E.second -> setLambda(_l);
+    Storage -> doInvalidateIndex();
+    doBindStore();
+}
+
+/**
+ * Enable culling of negligible synapse-receptor pairs. A synapse is skipped for the receptor when exp(-Lambda*D) is below the relative epsilon.
+ * @param Epsilon Relative cutoff value. Zero value disables culling.
+ * @param Skin Skin radius. Receptor neighbour lists are rebuilt only after the receptor has moved further than this distance.
+ */
+void indk::Neuron::setCulling(float Epsilon, float Skin) {
+    Storage -> setCulling(Epsilon, Skin);
+    doSelectKernel();
 }
 
 /**
@@ -379,12 +614,21 @@ void indk::Neuron::setk3(float _k3) {
     for (auto R: Receptors) R -> setk3(_k3);
 }
 
+/**
+ * Set compute backend that processes the neuron. By default (nullptr) the global compute backend is used.
+ * @param ComputeBackend Compute backend object.
+ */
+void indk::Neuron::setComputeBackend(indk::Computer *ComputeBackend) {
+    Backend = ComputeBackend;
+}
+
 void indk::Neuron::setNID(int _NID) {
     NID = _NID;
 }
 
 void indk::Neuron::setProcessingMode(int mode) {
     ProcessingMode = mode;
+    doSelectKernel();
 }
 
 void indk::Neuron::setOutputMode(int mode) {
@@ -416,6 +660,18 @@ bool indk::Neuron::isLearned() const {
     return Learned;
 }
 
+/**
+ * Get index of the entry by name. Use the index to route signals without name lookups.
+ * @param EName Entry name.
+ * @return Entry index or -1 if there is no entry with such name.
+ */
+int64_t indk::Neuron::getEntryIndex(const std::string& EName) const {
+    for (uint64_t i = 0; i < Entries.size(); i++) {
+        if (Entries[i].first == EName) return i;
+    }
+    return -1;
+}
+
 std::vector<std::string> indk::Neuron::getWaitingEntries() {
     std::vector<std::string> waiting;
     for (auto &e: Entries) {
@@ -457,6 +713,14 @@ indk::Neuron::Receptor* indk::Neuron::getReceptor(int64_t RID) const {
     return Receptors[RID];
 }
 
+/**
+ * Get packed neuron storage.
+ * @return indk::Neuron::Store object pointer.
+ */
+indk::Neuron::Store* indk::Neuron::getStore() const {
+    return Storage;
+}
+
 /**
  * Get count of neuron entries.
  * @return Entry count.
@@ -527,6 +791,35 @@ int64_t indk::Neuron::getSignalBufferSize() const {
     return OutputSignalSize;
 }
 
+/**
+ * Get capacity of the receptor trajectory buffer.
+ * @return Count of records, 0 if the capture is disabled.
+ */
+uint64_t indk::Neuron::getTrajectoryCapture() const {
+    return TrajectoryCapacity;
+}
+
+/**
+ * Export captured receptor trajectory.
+ * @return Trajectory records from the oldest to the newest.
+ */
+indk::Neuron::Trajectory indk::Neuron::getTrajectory() const {
+    indk::Neuron::Trajectory trajectory;
+    trajectory.Stride = Receptors.size() * DimensionsCount;
+    if (!TrajectoryCapacity || TrajectoryPos.size() != TrajectoryCapacity*trajectory.Stride) return trajectory;
+
+    auto count = std::min(TrajectoryPointer, TrajectoryCapacity);
+    trajectory.Ticks.reserve(count);
+    trajectory.Positions.reserve(count*trajectory.Stride);
+    for (auto i = TrajectoryPointer-count; i < TrajectoryPointer; i++) {
+        auto slot = i % TrajectoryCapacity;
+        auto record = TrajectoryPos.begin() + slot*trajectory.Stride;
+        trajectory.Ticks.push_back(TrajectoryTicks[slot]);
+        trajectory.Positions.insert(trajectory.Positions.end(), record, record+trajectory.Stride);
+    }
+    return trajectory;
+}
+
 /**
  * Get current state of neuron.
  * @return Neuron state.
@@ -549,7 +842,20 @@ int indk::Neuron::getOutputMode() const {
     return OutputMode;
 }
 
+/**
+ * Rebind synapse and receptor position views if the packed storage was relocated.
+ */
+void indk::Neuron::doBindStore() {
+    if (!Storage->isRelocated()) return;
+    for (const auto& E: Entries) E.second -> doBindStore();
+    for (auto R: Receptors) R -> doBindStore();
+    Storage -> doClearRelocated();
+}
+
 indk::Neuron::~Neuron() {
-    for (const auto& E: Entries) delete E.second;
-    for (auto R: Receptors) delete R;
+    Storage -> doReleaseSynapses();
+    for (const auto& E: Entries) indk::Arena::doDestroy(E.second);
+    for (auto R: Receptors) indk::Arena::doDestroy(R);
+    delete Storage;
+    delete [] OutputSignal;
 }
@@ -7,27 +7,23 @@
 // Licence:     MIT licence
 /////////////////////////////////////////////////////////////////////////////
 
+#include <cmath>
 #include <indk/neuron.h>
 #include <indk/system.h>
 
-indk::Neuron::Receptor::Receptor() {
-	DefaultPos = new indk::Position();
-	PhantomPos = new indk::Position();
-    k3 = 0;
-    Rs = 0.01;
-    Locked = false;
-    L = 0;
-    Lf = 0;
-    Fi = 0;
-    dFi = 0;
-    doCreateNewScope();
-}
-
-indk::Neuron::Receptor::Receptor(const Receptor &R) {
-    CP = R.getCP();
-    CPf = R.getCPf();
-	DefaultPos = new indk::Position(*R.getPos0());
-	PhantomPos = new indk::Position(*R.getPosf());
+/**
+ * Copy receptor.
+ * @param R Source receptor.
+ * @param _Storage Storage of the new receptor.
+ * @param ShareGeometry The storage is a context store of the source receptor storage: the receptor keeps its index,
+ * views the reference scopes in the scope matrix of the storage and copies the runtime state.
+ */
+indk::Neuron::Receptor::Receptor(const Receptor &R, indk::Neuron::Store *_Storage, bool ShareGeometry) {
+    Storage = _Storage;
+    RID = ShareGeometry ? R.getRID() : Storage->doAddReceptor(R.getPos0());
+	DefaultPos = Storage->getArena()->doCreate<indk::Position>(Storage->getXm(), Storage->getDimensionsCount(), Storage->getReceptorPos0(RID));
+	PhantomPos = Storage->getArena()->doCreate<indk::Position>(Storage->getXm(), Storage->getDimensionsCount(), Storage->getReceptorPosf(RID));
+    PhantomPos -> setPosition(R.getPosf());
     k3 = R.getk3();
     Rs = R.getSensitivityValue();
     Locked = R.isLocked();
@@ -35,20 +31,64 @@ indk::Neuron::Receptor::Receptor(const Receptor &R) {
     Lf = R.getLf();
     Fi = 0;
     dFi = 0;
-    doCreateNewScope();
+    ScopesGeneration = Storage -> getScopesGeneration();
+    if (ShareGeometry) {
+        Fi = R.Fi;
+        dFi = R.dFi;
+        doAttachScopes(R.getScopesCount());
+        Scope = R.Scope;
+    } else doCreateNewScope();
 }
 
-indk::Neuron::Receptor::Receptor(indk::Position *_RPos, float _k3) {
-	DefaultPos = new indk::Position(*_RPos);
-	PhantomPos = new indk::Position(*_RPos);
+/**
+ * Create receptor over the position kept in the storage.
+ * @param _Storage Storage of the receptor.
+ * @param _RID Index of the receptor in the storage.
+ * @param _k3 Sensitivity coefficient.
+ * @param ScopesCount Count of the reference scopes already kept in the scope matrix of the storage (see doAttachScopes),
+ * or -1 to create one new scope at the default position.
+ */
+indk::Neuron::Receptor::Receptor(indk::Neuron::Store *_Storage, uint64_t _RID, float _k3, int64_t ScopesCount) {
+    Storage = _Storage;
+    RID = _RID;
+	DefaultPos = Storage->getArena()->doCreate<indk::Position>(Storage->getXm(), Storage->getDimensionsCount(), Storage->getReceptorPos0(RID));
+	PhantomPos = Storage->getArena()->doCreate<indk::Position>(Storage->getXm(), Storage->getDimensionsCount(), Storage->getReceptorPosf(RID));
     k3 = _k3;
     Rs = 0.01;
     Locked = false;
+    ScopesGeneration = Storage -> getScopesGeneration();
     L = 0;
     Lf = 0;
     Fi = 0;
     dFi = 0;
-    doCreateNewScope();
+    if (ScopesCount < 0) doCreateNewScope();
+    else doAttachScopes(ScopesCount);
+}
+
+/**
+ * Rebind receptor position views after the storage relocation.
+ */
+void indk::Neuron::Receptor::doBindStore() {
+    DefaultPos -> setData(Storage->getReceptorPos0(RID));
+    PhantomPos -> setData(Storage->getReceptorPosf(RID));
+    doBindScopes();
+}
+
+/**
+ * Rebind reference scope views after the scope matrix relocation.
+ */
+void indk::Neuron::Receptor::doBindScopes() const {
+    for (uint64_t s = 0; s < ReferencePos.size(); s++) ReferencePos[s] -> setData(Storage->getScopePos(RID, s), Storage->getScopesCapacity());
+    ScopesGeneration = Storage -> getScopesGeneration();
+}
+
+/**
+ * Make the scope matrix writable before the reference scopes are changed: the matrix shared with another store
+ * or with the model image is copied to the storage.
+ */
+void indk::Neuron::Receptor::doDetachScopes() {
+    Storage -> doReserveScopes(ReferencePos.size());
+    if (ScopesGeneration != Storage->getScopesGeneration()) doBindScopes();
 }
 
 bool indk::Neuron::Receptor::doCheckActive() const {
@@ -64,8 +104,13 @@ void indk::Neuron::Receptor::doUnlock() {
 }
 
 void indk::Neuron::Receptor::doCreateNewScope() {
-    auto pos = new indk::Position(*DefaultPos);
-    Scope = ReferencePos.size();
+    auto scope = ReferencePos.size();
+    Storage -> doReserveScopes(scope+1);
+    if (ScopesGeneration != Storage->getScopesGeneration()) doBindScopes();
+    auto pos = Storage->getScopeArena()->doCreate<indk::Position>(Storage->getXm(), Storage->getDimensionsCount(),
+                                                                  Storage->getScopePos(RID, scope), Storage->getScopesCapacity());
+    pos -> setPosition(DefaultPos);
+    Scope = scope;
     ReferencePos.push_back(pos);
 }
 
@@ -78,29 +123,26 @@ void indk::Neuron::Receptor::doChangeScope(uint64_t scope) {
 }
 
 void indk::Neuron::Receptor::doReset() {
-    CPf.clear();
     Rs = 0.01;
     Lf = 0;
     Fi = 0;
     dFi = 0;
+    for (auto P: ReferencePos) indk::Arena::doDestroy(P);
     ReferencePos.clear();
     PhantomPos -> setPosition(DefaultPos);
     Locked = false;
 }
 
 void indk::Neuron::Receptor::doPrepare() {
-    CPf.clear();
     Rs = 0.01;
     Lf = 0;
     Fi = 0;
     dFi = 0;
     if (Locked) PhantomPos -> setPosition(DefaultPos);
-    else ReferencePos[Scope] -> setPosition(DefaultPos);
-}
-
-void indk::Neuron::Receptor::doSavePos() {
-    if (Locked) CPf.push_back(new indk::Position(*PhantomPos));
-    else CP.push_back(new indk::Position(*ReferencePos[Scope]));
+    else {
+        doDetachScopes();
+        getPos() -> setPosition(DefaultPos);
+    }
 }
 
 void indk::Neuron::Receptor::doUpdateSensitivityValue() {
@@ -112,17 +154,79 @@ void indk::Neuron::Receptor::doUpdatePos(indk::Position *_RPos) {
         Lf += indk::Position::getDistance(PhantomPos, _RPos);
         PhantomPos -> doAdd(_RPos);
     } else {
-        L += indk::Position::getDistance(ReferencePos[Scope], _RPos);
-        ReferencePos[Scope] -> doAdd(_RPos);
+        doDetachScopes();
+        auto pos = getPos();
+        L += indk::Position::getDistance(pos, _RPos);
+        pos -> doAdd(_RPos);
+    }
+}
+
+/**
+ * Apply one interaction step to the receptor: set the new field value, move the receptor (or its phantom
+ * when locked) by the offset and update the sensitivity. Equivalent to setFi, doUpdatePos, doCheckActive and
+ * doUpdateSensitivityValue in sequence, but works on raw coordinates.
+ * @param dRPos Offset coordinates, `DimensionsCount` values.
+ * @param _Fi New field value.
+ * @return Length of the offset if the receptor is active, otherwise 0.
+ */
+float indk::Neuron::Receptor::doMove(const float *dRPos, float _Fi) {
+    setFi(_Fi);
+    if (!Locked) doDetachScopes();
+    auto pos = Locked ? PhantomPos : getPos();
+    auto D = pos -> getDistanceFrom(dRPos);
+    if (Locked) Lf += D;
+    else L += D;
+    pos -> doAdd(dRPos);
+
+    float P = 0;
+    if (doCheckActive()) {
+        float S = 0;
+        auto DimensionsCount = pos -> getDimensionsCount();
+        for (unsigned int d = 0; d < DimensionsCount; d++) S += dRPos[d] * dRPos[d];
+        P = std::sqrt(S);
     }
+    doUpdateSensitivityValue();
+    return P;
 }
 
 void indk::Neuron::Receptor::setPos(indk::Position *_RPos) {
     if (Locked) {
         PhantomPos -> setPosition(_RPos);
     } else {
-        ReferencePos[Scope] -> setPosition(_RPos);
+        doDetachScopes();
+        getPos() -> setPosition(_RPos);
+    }
+}
+
+/**
+ * Replace reference scopes of the receptor with the first scopes already kept in the scope matrix of the storage
+ * (for example, the matrix of the model image or of the source store). The positions are not copied.
+ * The last scope becomes current.
+ * @param Count Count of the scopes (not greater than the scopes capacity of the storage).
+ */
+void indk::Neuron::Receptor::doAttachScopes(uint64_t Count) {
+    for (auto P: ReferencePos) indk::Arena::doDestroy(P);
+    ReferencePos.clear();
+
+    for (uint64_t s = 0; s < Count; s++) {
+        ReferencePos.push_back(Storage->getScopeArena()->doCreate<indk::Position>(Storage->getXm(), Storage->getDimensionsCount(),
+                                                                                 Storage->getScopePos(RID, s), Storage->getScopesCapacity()));
     }
+    ScopesGeneration = Storage -> getScopesGeneration();
+    Scope = Count ? Count - 1 : 0;
+}
+
+/**
+ * Set position of the reference scope.
+ * @param _Scope Index of the scope.
+ * @param Pos Scope position, DimensionsCount values.
+ */
+void indk::Neuron::Receptor::setReferencePos(uint64_t _Scope, const float *Pos) {
+    if (_Scope >= ReferencePos.size()) return;
+    doDetachScopes();
+    auto dimensions = Storage -> getDimensionsCount();
+    auto pos = Storage -> getScopePos(RID, _Scope);
+    for (unsigned int d = 0; d < dimensions; d++) pos[d*Storage->getScopesCapacity()] = Pos[d];
 }
 
 void indk::Neuron::Receptor::setRs(float _Rs) {
@@ -138,15 +242,8 @@ void indk::Neuron::Receptor::setFi(float _Fi) {
     Fi = _Fi;
 }
 
-std::vector<indk::Position*> indk::Neuron::Receptor::getCP() const {
-    return CP;
-}
-
-std::vector<indk::Position*> indk::Neuron::Receptor::getCPf() const {
-    return CPf;
-}
-
 indk::Position* indk::Neuron::Receptor::getPos() const {
+    if (ScopesGeneration != Storage->getScopesGeneration()) doBindScopes();
     return ReferencePos[Scope];
 }
 
@@ -158,10 +255,15 @@ indk::Position* indk::Neuron::Receptor::getPosf() const {
     return PhantomPos;
 }
 
-std::vector<indk::Position*> indk::Neuron::Receptor::getReferencePosScopes() {
+const std::vector<indk::Position*>& indk::Neuron::Receptor::getReferencePosScopes() const {
+    if (ScopesGeneration != Storage->getScopesGeneration()) doBindScopes();
     return ReferencePos;
 }
 
+uint64_t indk::Neuron::Receptor::getScopesCount() const {
+    return ReferencePos.size();
+}
+
 float indk::Neuron::Receptor::getRs() const {
     return Rs;
 }
@@ -193,3 +295,13 @@ float indk::Neuron::Receptor::getL() const {
 float indk::Neuron::Receptor::getLf() const {
     return Lf;
 }
+
+uint64_t indk::Neuron::Receptor::getRID() const {
+    return RID;
+}
+
+indk::Neuron::Receptor::~Receptor() {
+    for (auto P: ReferencePos) indk::Arena::doDestroy(P);
+    indk::Arena::doDestroy(DefaultPos);
+    indk::Arena::doDestroy(PhantomPos);
+}
@@ -0,0 +1,628 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        neuron/store.cpp
+// Purpose:     Neuron packed geometry storage class
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <indk/neuron.h>
+
+#define indk_STORE_ALIGNMENT 64
+#define indk_STORE_CAPACITY_STEP 16
+
+namespace {
+    float* doAllocateAligned(uint64_t size) {
+        void *data = nullptr;
+        if (!size) return nullptr;
+#ifdef _WIN32
+        data = _aligned_malloc(size*sizeof(float), indk_STORE_ALIGNMENT);
+#else
+        if (posix_memalign(&data, indk_STORE_ALIGNMENT, size*sizeof(float))) data = nullptr;
+#endif
+        if (!data) throw std::bad_alloc();
+        memset(data, 0, size*sizeof(float));
+        return (float*)data;
+    }
+
+    void doFreeAligned(float *data) {
+#ifdef _WIN32
+        _aligned_free(data);
+#else
+        free(data);
+#endif
+    }
+
+    std::shared_ptr<float> doAllocateShared(uint64_t size) {
+        return std::shared_ptr<float>(doAllocateAligned(size), doFreeAligned);
+    }
+
+    std::shared_ptr<float> doWrapExternal(const float *data) {
+        // external arrays are only read, every write path copies them first
+        return std::shared_ptr<float>(const_cast<float*>(data), [](float*) {});
+    }
+
+    uint64_t getNextCapacity(uint64_t current, uint64_t required) {
+        auto capacity = current ? current : indk_STORE_CAPACITY_STEP;
+        while (capacity < required) capacity *= 2;
+        return capacity;
+    }
+}
+
+indk::Neuron::Store::Store(unsigned int _Xm, unsigned int _DimensionsCount) {
+    Xm = _Xm;
+    DimensionsCount = _DimensionsCount;
+    SynapsesCount = 0;
+    SynapsesCapacity = 0;
+    ReceptorsCount = 0;
+    ReceptorsCapacity = 0;
+    SynapsePos = nullptr;
+    Lambda = nullptr;
+    Gamma = nullptr;
+    dGamma = nullptr;
+    ReceptorPos0 = nullptr;
+    ReceptorPosf = nullptr;
+    ScopePos = nullptr;
+    ScopesCapacity = 0;
+    ScopesGeneration = 0;
+    Relocated = false;
+    ExternalSynapses = false;
+    ExternalReceptors = false;
+    ExternalScopes = false;
+    CullingEpsilon = 0;
+    CullingSkin = 0;
+    CullingRadius = 0;
+    IndexValid = false;
+}
+
+/**
+ * Create context store over the geometry of the source store. Synapse positions, Lambda values, default receptor
+ * positions and the scope matrix are shared by reference: the source and the context copy a shared array before
+ * changing it, so the context does not depend on the lifetime and the later changes of the source store.
+ * External arrays of the source (see the attach constructor) must outlive the context store.
+ * @param Source Source store.
+ */
+indk::Neuron::Store::Store(const indk::Neuron::Store *Source) {
+    Xm = Source -> Xm;
+    DimensionsCount = Source -> DimensionsCount;
+    SynapsesCount = Source -> SynapsesCount;
+    SynapsesCapacity = Source -> SynapsesCapacity;
+    ReceptorsCount = Source -> ReceptorsCount;
+    ReceptorsCapacity = Source -> ReceptorsCapacity;
+    SynapsePos = Source -> SynapsePos;
+    Lambda = Source -> Lambda;
+    ReceptorPos0 = Source -> ReceptorPos0;
+    ScopePos = Source -> ScopePos;
+    SynapsePosBuffer = Source -> SynapsePosBuffer;
+    LambdaBuffer = Source -> LambdaBuffer;
+    ReceptorPos0Buffer = Source -> ReceptorPos0Buffer;
+    ScopePosBuffer = Source -> ScopePosBuffer;
+    FreeSynapses = Source -> FreeSynapses;
+    ScopesCapacity = Source -> ScopesCapacity;
+    ScopesGeneration = Source -> ScopesGeneration;
+    Gamma = doAllocateAligned(SynapsesCapacity);
+    dGamma = doAllocateAligned(SynapsesCapacity);
+    ReceptorPosf = doAllocateAligned(ReceptorsCapacity*DimensionsCount);
+    if (SynapsesCount) {
+        memcpy(Gamma, Source->Gamma, SynapsesCount*sizeof(float));
+        memcpy(dGamma, Source->dGamma, SynapsesCount*sizeof(float));
+    }
+    if (ReceptorsCount) memcpy(ReceptorPosf, Source->ReceptorPosf, ReceptorsCount*DimensionsCount*sizeof(float));
+    Relocated = false;
+    ExternalSynapses = Source -> ExternalSynapses;
+    ExternalReceptors = Source -> ExternalReceptors;
+    ExternalScopes = Source -> ExternalScopes;
+    CullingEpsilon = Source -> CullingEpsilon;
+    CullingSkin = Source -> CullingSkin;
+    CullingRadius = 0;
+    IndexValid = false;
+}
+
+/**
+ * Create store over external learned geometry, for example over the arrays of the mapped binary model image
+ * (see indk::Model). Synapse positions, Lambda values, default receptor positions and the scope matrix are not copied,
+ * the arrays must outlive the store. The arrays are never written: they are copied to the store on the first change
+ * (new synapse, receptor or scope, Lambda value change, learning). Gamma, dGamma and phantom receptor positions
+ * are allocated by the store.
+ * @param _Xm Maximal coordinate value.
+ * @param _DimensionsCount Count of space dimensions.
+ * @param _SynapsesCount Count of synapses.
+ * @param Stride Row length of the synapse position array, must be a multiple of 16 (not less than synapse count).
+ * @param _SynapsePos Synapse positions, one row per dimension.
+ * @param _Lambda Synapse Lambda values.
+ * @param _ReceptorsCount Count of receptors.
+ * @param _ReceptorPos0 Default receptor positions, receptor-major.
+ * @param ScopesStride Row length of the scope matrix (not less than the scopes count of every receptor).
+ * @param _ScopePos Scope matrix, one row per receptor and dimension (receptor-major).
+ */
+indk::Neuron::Store::Store(unsigned int _Xm, unsigned int _DimensionsCount, uint64_t _SynapsesCount, uint64_t Stride,
+                           const float *_SynapsePos, const float *_Lambda, uint64_t _ReceptorsCount, const float *_ReceptorPos0,
+                           uint64_t ScopesStride, const float *_ScopePos) {
+    Xm = _Xm;
+    DimensionsCount = _DimensionsCount;
+    SynapsesCount = _SynapsesCount;
+    SynapsesCapacity = Stride;
+    ReceptorsCount = _ReceptorsCount;
+    ReceptorsCapacity = _ReceptorsCount;
+    SynapsePosBuffer = doWrapExternal(_SynapsePos);
+    LambdaBuffer = doWrapExternal(_Lambda);
+    ReceptorPos0Buffer = doWrapExternal(_ReceptorPos0);
+    ScopePosBuffer = doWrapExternal(ScopesStride ? _ScopePos : nullptr);
+    SynapsePos = SynapsePosBuffer.get();
+    Lambda = LambdaBuffer.get();
+    ReceptorPos0 = ReceptorPos0Buffer.get();
+    ScopePos = ScopePosBuffer.get();
+    ScopesCapacity = ScopesStride;
+    ScopesGeneration = 0;
+    Gamma = doAllocateAligned(SynapsesCapacity);
+    dGamma = doAllocateAligned(SynapsesCapacity);
+    ReceptorPosf = doAllocateAligned(ReceptorsCapacity*DimensionsCount);
+    if (ReceptorsCount) memcpy(ReceptorPosf, ReceptorPos0, ReceptorsCount*DimensionsCount*sizeof(float));
+    Relocated = false;
+    ExternalSynapses = true;
+    ExternalReceptors = true;
+    ExternalScopes = ScopesStride != 0;
+    CullingEpsilon = 0;
+    CullingSkin = 0;
+    CullingRadius = 0;
+    IndexValid = false;
+}
+
+/**
+ * Reserve synapse slots. The arrays are reallocated if the capacity is not enough or the learned geometry
+ * is shared with another store or with the model image (the values are copied), in this case the storage
+ * is marked as relocated.
+ * @param size Count of synapses.
+ */
+void indk::Neuron::Store::doReserveSynapses(uint64_t size) {
+    if (size <= SynapsesCapacity && !isSynapsesShared()) return;
+    auto capacity = getNextCapacity(SynapsesCapacity, size);
+
+    auto nSynapsePosBuffer = doAllocateShared(capacity*DimensionsCount);
+    auto nLambdaBuffer = doAllocateShared(capacity);
+    auto nSynapsePos = nSynapsePosBuffer.get();
+    auto nLambda = nLambdaBuffer.get();
+    auto nGamma = doAllocateAligned(capacity);
+    auto ndGamma = doAllocateAligned(capacity);
+
+    for (unsigned int d = 0; d < DimensionsCount; d++) {
+        if (SynapsesCount) memcpy(nSynapsePos+d*capacity, SynapsePos+d*SynapsesCapacity, SynapsesCount*sizeof(float));
+    }
+    if (SynapsesCount) {
+        memcpy(nLambda, Lambda, SynapsesCount*sizeof(float));
+        memcpy(nGamma, Gamma, SynapsesCount*sizeof(float));
+        memcpy(ndGamma, dGamma, SynapsesCount*sizeof(float));
+    }
+
+    doFreeAligned(Gamma);
+    doFreeAligned(dGamma);
+
+    SynapsePosBuffer = std::move(nSynapsePosBuffer);
+    LambdaBuffer = std::move(nLambdaBuffer);
+    SynapsePos = nSynapsePos;
+    Lambda = nLambda;
+    Gamma = nGamma;
+    dGamma = ndGamma;
+    SynapsesCapacity = capacity;
+    ExternalSynapses = false;
+    Relocated = true;
+}
+
+/**
+ * Reserve receptor slots. The arrays are reallocated if the capacity is not enough or the default positions
+ * are shared with another store or with the model image (the values are copied), in this case the storage
+ * is marked as relocated.
+ * @param size Count of receptors.
+ */
+void indk::Neuron::Store::doReserveReceptors(uint64_t size) {
+    if (size <= ReceptorsCapacity && !isReceptorsShared()) return;
+    auto capacity = getNextCapacity(ReceptorsCapacity, size);
+
+    auto nReceptorPos0Buffer = doAllocateShared(capacity*DimensionsCount);
+    auto nReceptorPos0 = nReceptorPos0Buffer.get();
+    auto nReceptorPosf = doAllocateAligned(capacity*DimensionsCount);
+
+    if (ReceptorsCount) {
+        memcpy(nReceptorPos0, ReceptorPos0, ReceptorsCount*DimensionsCount*sizeof(float));
+        memcpy(nReceptorPosf, ReceptorPosf, ReceptorsCount*DimensionsCount*sizeof(float));
+    }
+
+    doFreeAligned(ReceptorPosf);
+
+    if (ScopesCapacity && capacity != ReceptorsCapacity) {
+        auto nScopePosBuffer = doAllocateShared(capacity*DimensionsCount*ScopesCapacity);
+        if (ReceptorsCount) memcpy(nScopePosBuffer.get(), ScopePos, ReceptorsCount*DimensionsCount*ScopesCapacity*sizeof(float));
+        ScopePosBuffer = std::move(nScopePosBuffer);
+        ScopePos = ScopePosBuffer.get();
+        ExternalScopes = false;
+        ScopesGeneration++;
+    }
+
+    ReceptorPos0Buffer = std::move(nReceptorPos0Buffer);
+    ReceptorPos0 = nReceptorPos0;
+    ReceptorPosf = nReceptorPosf;
+    ReceptorsCapacity = capacity;
+    ExternalReceptors = false;
+    Relocated = true;
+}
+
+/**
+ * Reserve scope slots for every receptor. The scope matrix is reallocated if the capacity is not enough
+ * or the matrix is shared with another store or with the model image (the values are copied), in this case
+ * the scope positions of the receptors must be rebound (see getScopesGeneration). Scope positions must not
+ * be changed without this call.
+ * @param size Count of scopes.
+ */
+void indk::Neuron::Store::doReserveScopes(uint64_t size) {
+    if (size <= ScopesCapacity && !isScopesShared()) return;
+    auto capacity = ScopesCapacity ? ScopesCapacity : 1;
+    while (capacity < size) capacity *= 2;
+
+    auto nScopePosBuffer = doAllocateShared(ReceptorsCapacity*DimensionsCount*capacity);
+    auto nScopePos = nScopePosBuffer.get();
+    if (ScopesCapacity) {
+        for (uint64_t r = 0; r < ReceptorsCount*DimensionsCount; r++) {
+            memcpy(nScopePos+r*capacity, ScopePos+r*ScopesCapacity, ScopesCapacity*sizeof(float));
+        }
+    }
+
+    ScopePosBuffer = std::move(nScopePosBuffer);
+    ScopePos = nScopePos;
+    ScopesCapacity = capacity;
+    ExternalScopes = false;
+    ScopesGeneration++;
+    Relocated = true;
+}
+
+/**
+ * Compute distances between the phantom position of the receptor and its reference scopes.
+ * @param RID Index of the receptor.
+ * @param Count Count of the scopes to compare (not greater than the scopes capacity).
+ * @param Distances Output array of Count distances.
+ */
+void indk::Neuron::Store::doCompareScopes(uint64_t RID, uint64_t Count, float *Distances) const {
+    auto posf = ReceptorPosf + RID*DimensionsCount;
+    auto row = ScopePos + RID*DimensionsCount*ScopesCapacity;
+    std::fill(Distances, Distances+Count, 0.f);
+    for (unsigned int d = 0; d < DimensionsCount; d++, row += ScopesCapacity) {
+        auto p = posf[d];
+        for (uint64_t s = 0; s < Count; s++) {
+            auto v = row[s] - p;
+            Distances[s] += v * v;
+        }
+    }
+    for (uint64_t s = 0; s < Count; s++) Distances[s] = std::sqrt(Distances[s]);
+}
+
+/**
+ * Add synapse to the storage. Released slots are reused before the storage grows.
+ * @param SPos Synapse position.
+ * @param _Lambda Synapse lambda value.
+ * @return Index of the synapse in the storage.
+ */
+uint64_t indk::Neuron::Store::doAddSynapse(const indk::Position *SPos, float _Lambda) {
+    uint64_t SID;
+    if (!FreeSynapses.empty()) {
+        doReserveSynapses(SynapsesCount);
+        SID = FreeSynapses.back();
+        FreeSynapses.pop_back();
+    } else {
+        doReserveSynapses(SynapsesCount+1);
+        SID = SynapsesCount++;
+    }
+    for (unsigned int d = 0; d < DimensionsCount; d++) {
+        SynapsePos[d*SynapsesCapacity+SID] = SPos->getPositionValue(d);
+    }
+    Lambda[SID] = _Lambda;
+    Gamma[SID] = 0;
+    dGamma[SID] = 0;
+    IndexValid = false;
+    return SID;
+}
+
+/**
+ * Add receptor to the storage. Both default and phantom positions are set to the given position.
+ * @param RPos Receptor position.
+ * @return Index of the receptor in the storage.
+ */
+uint64_t indk::Neuron::Store::doAddReceptor(const indk::Position *RPos) {
+    doReserveReceptors(ReceptorsCount+1);
+    auto RID = ReceptorsCount;
+    for (unsigned int d = 0; d < DimensionsCount; d++) {
+        ReceptorPos0[RID*DimensionsCount+d] = RPos->getPositionValue(d);
+        ReceptorPosf[RID*DimensionsCount+d] = RPos->getPositionValue(d);
+    }
+    ReceptorsCount++;
+    IndexValid = false;
+    return RID;
+}
+
+/**
+ * Release synapse slot. Released slot stays in the storage with zero neurotransmitter levels, so it has
+ * no influence on receptors, and is reused by the next doAddSynapse call. Gamma and dGamma belong to the store,
+ * so the shared learned geometry is not copied.
+ * @param SID Index of the synapse.
+ */
+void indk::Neuron::Store::doReleaseSynapse(uint64_t SID) {
+    if (SID >= SynapsesCount) return;
+    Gamma[SID] = 0;
+    dGamma[SID] = 0;
+    FreeSynapses.push_back(SID);
+}
+
+/**
+ * Release all synapse slots before the synapse objects are destroyed with the neuron. The arrays are not
+ * changed, so the shared learned geometry is not copied just to be freed.
+ */
+void indk::Neuron::Store::doReleaseSynapses() {
+    SynapsesCount = 0;
+    FreeSynapses.clear();
+    IndexValid = false;
+}
+
+/**
+ * Set Lambda value of the synapse. Shared synapse arrays are copied to the store before the change.
+ * @param SID Index of the synapse.
+ * @param _Lambda New Lambda value.
+ */
+void indk::Neuron::Store::setLambda(uint64_t SID, float _Lambda) {
+    if (SID >= SynapsesCount) return;
+    doReserveSynapses(SynapsesCount);
+    Lambda[SID] = _Lambda;
+    IndexValid = false;
+}
+
+bool indk::Neuron::Store::isSynapsesShared() const {
+    return ExternalSynapses || SynapsePosBuffer.use_count() > 1;
+}
+
+bool indk::Neuron::Store::isReceptorsShared() const {
+    return ExternalReceptors || ReceptorPos0Buffer.use_count() > 1;
+}
+
+bool indk::Neuron::Store::isScopesShared() const {
+    return ExternalScopes || ScopePosBuffer.use_count() > 1;
+}
+
+void indk::Neuron::Store::doClearRelocated() {
+    Relocated = false;
+}
+
+/**
+ * Invalidate synapse grid and receptor neighbour lists. They will be rebuilt on the next getNeighbours() call.
+ */
+void indk::Neuron::Store::doInvalidateIndex() {
+    IndexValid = false;
+}
+
+/**
+ * Rebuild synapse grid if it was invalidated. After this call neighbour lists of different receptors can be built concurrently.
+ */
+void indk::Neuron::Store::doUpdateIndex() {
+    if (!IndexValid) doBuildIndex();
+}
+
+std::vector<int64_t> indk::Neuron::Store::getCell(const float *Pos) const {
+    std::vector<int64_t> cell(DimensionsCount);
+    for (unsigned int d = 0; d < DimensionsCount; d++) cell[d] = (int64_t)std::floor(Pos[d]/(CullingRadius+CullingSkin));
+    return cell;
+}
+
+void indk::Neuron::Store::doBuildIndex() {
+    float lmin = 0;
+    for (uint64_t k = 0; k < SynapsesCount; k++) {
+        if (Lambda[k] > 0 && (lmin == 0 || Lambda[k] < lmin)) lmin = Lambda[k];
+    }
+
+    // exp(-Lambda*D) drops below the relative epsilon beyond this distance for every synapse
+    CullingRadius = lmin > 0 ? std::log(1/CullingEpsilon) / lmin : 0;
+
+    Grid.clear();
+    std::vector<float> pos(DimensionsCount);
+    if (CullingRadius+CullingSkin > 0) {
+        for (uint64_t k = 0; k < SynapsesCount; k++) {
+            for (unsigned int d = 0; d < DimensionsCount; d++) pos[d] = SynapsePos[d*SynapsesCapacity+k];
+            Grid[getCell(pos.data())].push_back(k);
+        }
+    }
+
+    Neighbours.assign(ReceptorsCount, {});
+    NeighboursAnchor.assign(ReceptorsCount*DimensionsCount, 0);
+    NeighboursValid.assign(ReceptorsCount, 0);
+    IndexValid = true;
+}
+
+void indk::Neuron::Store::doBuildNeighbours(uint64_t RID, const float *RPos) {
+    auto &list = Neighbours[RID];
+    auto radius = CullingRadius + CullingSkin;
+    list.clear();
+
+    auto check = [this, &list, RPos, radius](uint32_t k) {
+        float D = 0;
+        for (unsigned int d = 0; d < DimensionsCount; d++) {
+            auto v = SynapsePos[d*SynapsesCapacity+k] - RPos[d];
+            D += v * v;
+        }
+        if (std::sqrt(D) <= radius) list.push_back(k);
+    };
+
+    // visiting 3^D cells is not worth it when there are fewer synapses than cells
+    if (Grid.empty() || std::pow(3., DimensionsCount) > SynapsesCount) {
+        for (uint64_t k = 0; k < SynapsesCount; k++) check(k);
+    } else {
+        auto center = getCell(RPos);
+        std::vector<int> offset(DimensionsCount, -1);
+        std::vector<int64_t> cell(DimensionsCount);
+        while (true) {
+            for (unsigned int d = 0; d < DimensionsCount; d++) cell[d] = center[d] + offset[d];
+            auto c = Grid.find(cell);
+            if (c != Grid.end()) {
+                for (auto k: c->second) check(k);
+            }
+
+            unsigned int d = 0;
+            while (d < DimensionsCount && offset[d] == 1) offset[d++] = -1;
+            if (d == DimensionsCount) break;
+            offset[d]++;
+        }
+        std::sort(list.begin(), list.end());
+    }
+
+    for (unsigned int d = 0; d < DimensionsCount; d++) NeighboursAnchor[RID*DimensionsCount+d] = RPos[d];
+    NeighboursValid[RID] = 1;
+}
+
+/**
+ * Enable synapse culling. Synapse-receptor pairs where exp(-Lambda*D) is below the relative epsilon are skipped.
+ * @param Epsilon Relative cutoff value. Zero value disables culling.
+ * @param Skin Verlet skin radius: neighbour lists include synapses up to cutoff radius plus skin and are rebuilt only when the receptor has moved further than skin.
+ */
+void indk::Neuron::Store::setCulling(float Epsilon, float Skin) {
+    CullingEpsilon = Epsilon > 0 && Epsilon < 1 ? Epsilon : 0;
+    CullingSkin = Skin > 0 ? Skin : 0;
+    IndexValid = false;
+}
+
+/**
+ * Check if storage arrays were reallocated since the last doClearRelocated() call.
+ * Positions that view the storage must be rebound in this case.
+ * @return Relocation flag.
+ */
+bool indk::Neuron::Store::isRelocated() const {
+    return Relocated;
+}
+
+bool indk::Neuron::Store::isCullingEnabled() const {
+    return CullingEpsilon > 0;
+}
+
+/**
+ * Get indices of synapses that can influence the receptor. The list is rebuilt when the receptor has moved further than the skin radius since the last build.
+ * @param RID Index of the receptor.
+ * @param RPos Current receptor coordinates.
+ * @return Sorted synapse indices.
+ */
+const std::vector<uint32_t>& indk::Neuron::Store::getNeighbours(uint64_t RID, const float *RPos) {
+    doUpdateIndex();
+    if (NeighboursValid[RID]) {
+        float D = 0;
+        for (unsigned int d = 0; d < DimensionsCount; d++) {
+            auto v = NeighboursAnchor[RID*DimensionsCount+d] - RPos[d];
+            D += v * v;
+        }
+        if (std::sqrt(D) <= CullingSkin) return Neighbours[RID];
+    }
+    doBuildNeighbours(RID, RPos);
+    return Neighbours[RID];
+}
+
+float indk::Neuron::Store::getCullingEpsilon() const {
+    return CullingEpsilon;
+}
+
+float indk::Neuron::Store::getCullingSkin() const {
+    return CullingSkin;
+}
+
+/**
+ * Get synapse coordinates row.
+ * @param d Dimension index.
+ * @return Pointer to the aligned row of synapse coordinates for the dimension.
+ */
+float* indk::Neuron::Store::getSynapsePos(unsigned int d) const {
+    return SynapsePos + d*SynapsesCapacity;
+}
+
+float* indk::Neuron::Store::getLambda() const {
+    return Lambda;
+}
+
+float* indk::Neuron::Store::getGamma() const {
+    return Gamma;
+}
+
+float* indk::Neuron::Store::getdGamma() const {
+    return dGamma;
+}
+
+float* indk::Neuron::Store::getReceptorPos0(uint64_t RID) const {
+    return ReceptorPos0 + RID*DimensionsCount;
+}
+
+float* indk::Neuron::Store::getReceptorPosf(uint64_t RID) const {
+    return ReceptorPosf + RID*DimensionsCount;
+}
+
+/**
+ * Get reference scope position of the receptor. Values of the position are read with the getScopesCapacity() stride.
+ * @param RID Index of the receptor.
+ * @param Scope Index of the scope.
+ * @return Pointer to the first value of the scope position.
+ */
+float* indk::Neuron::Store::getScopePos(uint64_t RID, uint64_t Scope) const {
+    return ScopePos + RID*DimensionsCount*ScopesCapacity + Scope;
+}
+
+uint64_t indk::Neuron::Store::getScopesCapacity() const {
+    return ScopesCapacity;
+}
+
+/**
+ * Get generation of the scope matrix. The generation is changed every time the matrix is reallocated.
+ * @return Generation number.
+ */
+uint64_t indk::Neuron::Store::getScopesGeneration() const {
+    return ScopesGeneration;
+}
+
+uint64_t indk::Neuron::Store::getSynapsesCount() const {
+    return SynapsesCount;
+}
+
+/**
+ * Get synapse rows capacity. The capacity is always a multiple of 16, so the tail of every row
+ * can be safely processed by vector instructions (unused slots have zero lambda).
+ * @return Synapse rows capacity.
+ */
+uint64_t indk::Neuron::Store::getSynapsesCapacity() const {
+    return SynapsesCapacity;
+}
+
+uint64_t indk::Neuron::Store::getReceptorsCount() const {
+    return ReceptorsCount;
+}
+
+unsigned int indk::Neuron::Store::getXm() const {
+    return Xm;
+}
+
+unsigned int indk::Neuron::Store::getDimensionsCount() const {
+    return DimensionsCount;
+}
+
+/**
+ * Get arena of the neuron structure objects (entries, synapses, receptors and their position views).
+ * @return Pointer to the arena.
+ */
+indk::Arena* indk::Neuron::Store::getArena() {
+    return &Objects;
+}
+
+/**
+ * Get arena of the receptor reference scopes.
+ * @return Pointer to the arena.
+ */
+indk::Arena* indk::Neuron::Store::getScopeArena() {
+    return &Scopes;
+}
+
+indk::Neuron::Store::~Store() {
+    doFreeAligned(Gamma);
+    doFreeAligned(dGamma);
+    doFreeAligned(ReceptorPosf);
+}
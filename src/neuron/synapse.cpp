@@ -10,50 +10,71 @@
 #include <indk/neuron.h>
 #include <indk/system.h>
 
-indk::Neuron::Synapse::Synapse() {
-    SPos = new indk::Position();
-    ok1 = 0;
-    ok2 = 0;
-    k1 = 0;
-    k2 = 0;
-    Lambda = 0;
-    Tl = 0;
-    Gamma = 0;
-    dGamma = 0;
-    QCounter = -1;
-    QSize = 0;
-}
-
-indk::Neuron::Synapse::Synapse(const Synapse &S) {
-    SPos = S.getPos();
+/**
+ * Copy synapse.
+ * @param S Source synapse.
+ * @param _Storage Storage of the new synapse.
+ * @param ShareGeometry The storage is a context store of the source synapse storage: the synapse keeps its index and the runtime state is copied.
+ */
+indk::Neuron::Synapse::Synapse(const Synapse &S, indk::Neuron::Store *_Storage, bool ShareGeometry) {
+    Storage = _Storage;
+    if (ShareGeometry) {
+        SID = S.getSID();
+    } else {
+        SID = Storage -> doAddSynapse(S.getPos(), S.getLambda());
+        Storage -> getGamma()[SID] = S.getGamma();
+        Storage -> getdGamma()[SID] = S.getdGamma();
+    }
+    SPos = Storage->getArena()->doCreate<indk::Position>(Storage->getXm(), Storage->getDimensionsCount(), Storage->getSynapsePos(0)+SID, Storage->getSynapsesCapacity());
     ok1 = S.getk1();
     ok2 = S.getk2();
     k1 = ok1;
     k2 = ok2;
-    Lambda = S.getLambda();
     Tl = S.getTl();
-    Gamma = S.getGamma();
-    dGamma = S.getdGamma();
+    lGamma = 0;
+    ldGamma = 0;
     QCounter = -1;
     QSize = 0;
-}
-
-indk::Neuron::Synapse::Synapse(indk::Position *_SPos, float _k1, float _Lambda, int64_t _Tl, int NT) {
-    SPos = _SPos;
+    NeurotransmitterType = S.getNeurotransmitterType();
+    if (ShareGeometry) {
+        ok1 = S.ok1;
+        ok2 = S.ok2;
+        k1 = S.k1;
+        k2 = S.k2;
+        lGamma = S.lGamma;
+        ldGamma = S.ldGamma;
+        QCounter = S.QCounter;
+        GammaQ = S.GammaQ;
+        QSize = S.QSize.load();
+    }
+}
+
+indk::Neuron::Synapse::Synapse(indk::Neuron::Store *_Storage, uint64_t _SID, float _k1, int64_t _Tl, int NT) {
+    Storage = _Storage;
+    SID = _SID;
+    SPos = Storage->getArena()->doCreate<indk::Position>(Storage->getXm(), Storage->getDimensionsCount(), Storage->getSynapsePos(0)+SID, Storage->getSynapsesCapacity());
     ok1 = _k1;
     ok2 = ok1 * 1000;
     k1 = ok1;
 	k2 = ok2;
-    Lambda = _Lambda;
     Tl = _Tl;
-    Gamma = 0;
-    dGamma = 0;
+    lGamma = 0;
+    ldGamma = 0;
     QCounter = -1;
     QSize = 0;
     NeurotransmitterType = NT;
 }
 
+/**
+ * Rebind synapse position view after the storage relocation.
+ */
+void indk::Neuron::Synapse::doBindStore() {
+    SPos -> setData(Storage->getSynapsePos(0)+SID, Storage->getSynapsesCapacity());
+}
+
 void indk::Neuron::Synapse::doIn(float X) {
+    auto &Gamma = Storage -> getGamma()[SID];
+    auto &dGamma = Storage -> getdGamma()[SID];
     float nGamma = indk::Computer::getGammaFunctionValue(Gamma, k1, k2, X);
     lGamma = Gamma;
     ldGamma = dGamma;
@@ -72,8 +93,7 @@ bool indk::Neuron::Synapse::doInFromQueue(int64_t tT) {
     if (tT >= QSize) return false;
     if (tT == QCounter) return true;
     float nGamma = GammaQ[tT];
-    dGamma = nGamma - Gamma;
-    Gamma = nGamma;
+    setGamma(nGamma);
     QCounter = tT;
     return true;
 }
@@ -84,8 +104,8 @@ void indk::Neuron::Synapse::doPrepare() {
 }
 
 void indk::Neuron::Synapse::doReset() {
-    Gamma = 0;
-    dGamma = 0;
+    Storage -> getGamma()[SID] = 0;
+    Storage -> getdGamma()[SID] = 0;
     QCounter = 0;
     QSize = 0;
     GammaQ.clear();
@@ -94,12 +114,13 @@ void indk::Neuron::Synapse::doReset() {
 }
 
 void indk::Neuron::Synapse::doRollback() {
-    dGamma = ldGamma;
-    Gamma = lGamma;
+    Storage -> getdGamma()[SID] = ldGamma;
+    Storage -> getGamma()[SID] = lGamma;
 }
 
 void indk::Neuron::Synapse::setGamma(float gamma) {
-    dGamma = gamma - Gamma;
+    auto &Gamma = Storage -> getGamma()[SID];
+    Storage -> getdGamma()[SID] = gamma - Gamma;
     Gamma = gamma;
 }
 
@@ -112,7 +133,7 @@ void indk::Neuron::Synapse::setk2(float _k2) {
 }
 
 void indk::Neuron::Synapse::setLambda(float L) {
-    Lambda = L;
+    Storage -> setLambda(SID, L);
 }
 
 indk::Position* indk::Neuron::Synapse::getPos() const {
@@ -128,7 +149,7 @@ float indk::Neuron::Synapse::getk2() const {
 }
 
 float indk::Neuron::Synapse::getLambda() const {
-    return Lambda;
+    return Storage -> getLambda()[SID];
 }
 
 int64_t indk::Neuron::Synapse::getTl() const {
@@ -136,11 +157,11 @@ int64_t indk::Neuron::Synapse::getTl() const {
 }
 
 float indk::Neuron::Synapse::getGamma() const {
-    return Gamma;
+    return Storage -> getGamma()[SID];
 }
 
 float indk::Neuron::Synapse::getdGamma() const {
-    return dGamma;
+    return Storage -> getdGamma()[SID];
 }
 
 int64_t indk::Neuron::Synapse::getQSize() {
@@ -150,3 +171,12 @@ int64_t indk::Neuron::Synapse::getQSize() {
 int indk::Neuron::Synapse::getNeurotransmitterType() const {
     return NeurotransmitterType;
 }
+
+uint64_t indk::Neuron::Synapse::getSID() const {
+    return SID;
+}
+
+indk::Neuron::Synapse::~Synapse() {
+    Storage -> doReleaseSynapse(SID);
+    indk::Arena::doDestroy(SPos);
+}
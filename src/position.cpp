@@ -15,12 +15,16 @@
 indk::Position::Position() {
     Xm = 0;
     DimensionsCount = 0;
+    Stride = 1;
     X = nullptr;
+    View = false;
 }
 
 indk::Position::Position(const indk::Position &P) {
     Xm = P.getXm();
     DimensionsCount = P.getDimensionsCount();
+    Stride = 1;
+    View = false;
     X = new float[DimensionsCount];
     for (unsigned int i = 0; i < DimensionsCount; i++) X[i] = P.getPositionValue(i);
 }
@@ -28,6 +32,8 @@ indk::Position::Position(const indk::Position &P) {
 indk::Position::Position(unsigned int _Xm, unsigned int _DimensionsCount) {
     Xm = _Xm;
     DimensionsCount = _DimensionsCount;
+    Stride = 1;
+    View = false;
     X = new float[DimensionsCount];
     for (unsigned int i = 0; i < DimensionsCount; i++) X[i] = 0;
 }
@@ -35,6 +41,8 @@ indk::Position::Position(unsigned int _Xm, unsigned int _DimensionsCount) {
 indk::Position::Position(unsigned int _Xm, std::vector<float> _X) {
     Xm = _Xm;
     DimensionsCount = (unsigned)_X.size();
+    Stride = 1;
+    View = false;
     X = new float[DimensionsCount];
     for (int i = 0; i < DimensionsCount; i++) {
         if (_X[i] < 0 || _X[i] > Xm) {
@@ -44,6 +52,21 @@ indk::Position::Position(unsigned int _Xm, std::vector<float> _X) {
     }
 }
 
+/**
+ * Create position view over external coordinates. The view does not own the data.
+ * @param _Xm Space size.
+ * @param _DimensionsCount Count of dimensions.
+ * @param _X Pointer to the first coordinate.
+ * @param _Stride Distance (in elements) between two neighbouring coordinates.
+ */
+indk::Position::Position(unsigned int _Xm, unsigned int _DimensionsCount, float *_X, unsigned int _Stride) {
+    Xm = _Xm;
+    DimensionsCount = _DimensionsCount;
+    Stride = _Stride;
+    X = _X;
+    View = true;
+}
+
 void indk::Position::doAdd(const indk::Position *P) {
     if (DimensionsCount != P->getDimensionsCount()) {
         throw indk::Error(indk::Error::EX_POSITION_DIMENSIONS);
@@ -52,9 +75,22 @@ void indk::Position::doAdd(const indk::Position *P) {
         throw indk::Error(indk::Error::EX_POSITION_RANGES);
     }
     for (unsigned int i = 0; i < DimensionsCount; i++) {
-        X[i] += P->getPositionValue(i);
-        if (X[i] > Xm) {
-            throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {X[i], (float)Xm});
+        X[i*Stride] += P->getPositionValue(i);
+        if (X[i*Stride] > Xm) {
+            throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {X[i*Stride], (float)Xm});
+        }
+    }
+}
+
+/**
+ * Add raw coordinates to the position.
+ * @param P Array of `DimensionsCount` coordinate values.
+ */
+void indk::Position::doAdd(const float *P) {
+    for (unsigned int i = 0; i < DimensionsCount; i++) {
+        X[i*Stride] += P[i];
+        if (X[i*Stride] > Xm) {
+            throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {X[i*Stride], (float)Xm});
         }
     }
 }
@@ -67,44 +103,44 @@ void indk::Position::doSubtract(const indk::Position *P) {
         throw indk::Error(indk::Error::EX_POSITION_RANGES);
     }
     for (unsigned int i = 0; i < DimensionsCount; i++) {
-        X[i] = (X[i]-P->getPositionValue(i));
-        if (X[i] > Xm) {
-            throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {X[i], (float)Xm});
+        X[i*Stride] = (X[i*Stride]-P->getPositionValue(i));
+        if (X[i*Stride] > Xm) {
+            throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {X[i*Stride], (float)Xm});
         }
     }
 }
 
 void indk::Position::doDivide(float D) {
     for (unsigned int i = 0; i < DimensionsCount; i++) {
-        X[i] /= D;
+        X[i*Stride] /= D;
     }
 }
 
 void indk::Position::doMultiply(float M) {
     for (unsigned int i = 0; i < DimensionsCount; i++) {
-        X[i] *= M;
-        if (X[i] > Xm) {
-            throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {X[i], (float)Xm});
+        X[i*Stride] *= M;
+        if (X[i*Stride] > Xm) {
+            throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {X[i*Stride], (float)Xm});
         }
     }
 }
 
 void indk::Position::doZeroPosition() {
-    for (unsigned int i = 0; i < DimensionsCount; i++) X[i] = 0;
+    for (unsigned int i = 0; i < DimensionsCount; i++) X[i*Stride] = 0;
 }
 
 void indk::Position::setPosition(const indk::Position &P) {
     if (P.getDimensionsCount() < DimensionsCount) {
         throw indk::Error(indk::Error::EX_POSITION_DIMENSIONS);
     }
-    for (unsigned int i = 0; i < DimensionsCount; i++) X[i] = P.getPositionValue(i);
+    for (unsigned int i = 0; i < DimensionsCount; i++) X[i*Stride] = P.getPositionValue(i);
 }
 
 void indk::Position::setPosition(const indk::Position *P) {
     if (P->getDimensionsCount() < DimensionsCount) {
         throw indk::Error(indk::Error::EX_POSITION_DIMENSIONS);
     }
-    for (unsigned int i = 0; i < DimensionsCount; i++) X[i] = P -> getPositionValue(i);
+    for (unsigned int i = 0; i < DimensionsCount; i++) X[i*Stride] = P -> getPositionValue(i);
 }
 
 void indk::Position::setPosition(std::vector<float> _X) {
@@ -115,7 +151,7 @@ void indk::Position::setPosition(std::vector<float> _X) {
         if (_X[i] < 0 || _X[i] > Xm) {
             throw indk::Error(indk::Error::EX_POSITION_OUT_RANGES, {_X[i], (float)Xm});
         }
-        X[i] = _X[i];
+        X[i*Stride] = _X[i];
     }
 }
 
@@ -123,6 +159,18 @@ void indk::Position::setXm(unsigned int _Xm) {
     Xm = _Xm;
 }
 
+/**
+ * Rebind position view to new coordinates location.
+ * @param _X Pointer to the first coordinate.
+ * @param _Stride Distance (in elements) between two neighbouring coordinates.
+ */
+void indk::Position::setData(float *_X, unsigned int _Stride) {
+    if (!View) delete [] X;
+    X = _X;
+    Stride = _Stride;
+    View = true;
+}
+
 void indk::Position::setDimensionsCount(unsigned int _DimensionsCount) {
     DimensionsCount = _DimensionsCount;
 }
@@ -137,7 +185,7 @@ unsigned int indk::Position::getXm() const {
 
 float indk::Position::getPositionValue(unsigned int DNum) const {
     if (DNum >= DimensionsCount) return -1;
-    return X[DNum];
+    return X[DNum*Stride];
 }
 
 float indk::Position::getDistanceFrom(const indk::Position *P) {
@@ -146,19 +194,49 @@ float indk::Position::getDistanceFrom(const indk::Position *P) {
     }
     float D = 0, CValue;
     for (unsigned int i = 0; i < DimensionsCount; i++) {
-        CValue = X[i] - P -> getPositionValue(i);
+        CValue = X[i*Stride] - P -> getPositionValue(i);
         D += CValue * CValue;
     }
     return sqrt(D);
 }
 
+/**
+ * Copy all coordinates of the position into a contiguous array.
+ * @param P Array of at least `DimensionsCount` values.
+ */
+void indk::Position::getPositionValues(float *P) const {
+    for (unsigned int i = 0; i < DimensionsCount; i++) P[i] = X[i*Stride];
+}
+
+/**
+ * Get distance to raw coordinates.
+ * @param P Array of `DimensionsCount` coordinate values.
+ * @return Euclidean distance.
+ */
+float indk::Position::getDistanceFrom(const float *P) const {
+    float D = 0, CValue;
+    for (unsigned int i = 0; i < DimensionsCount; i++) {
+        CValue = X[i*Stride] - P[i];
+        D += CValue * CValue;
+    }
+    return std::sqrt(D);
+}
+
+bool indk::Position::isView() const {
+    return View;
+}
+
 indk::Position::~Position() {
-    delete [] X;
+    if (!View) delete [] X;
 }
 
 indk::Position& indk::Position::operator=(const indk::Position &P) {
 	if (this == &P) return *this;
-	delete X;
+    if (View) {
+        setPosition(P);
+        return *this;
+    }
+	delete [] X;
     Xm = P.getXm();
     DimensionsCount = P.getDimensionsCount();
 	X = new float[DimensionsCount];
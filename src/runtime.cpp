@@ -0,0 +1,73 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        runtime.cpp
+// Purpose:     Compute runtime class
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <indk/runtime.h>
+#include <indk/system.h>
+#include <indk/backends/default.h>
+#include <indk/backends/multithread.h>
+#include <indk/backends/opencl.h>
+
+/**
+ * Create runtime with its own compute backend object.
+ * @param Backend Compute backend value (see indk::System::ComputeBackends). If the backend is not supported by the build, the default backend is used.
+ * @param Parameter Custom parameter (threads count for the multithread backend).
+ */
+indk::Runtime::Runtime(int Backend, int Parameter) {
+    switch (Backend) {
+        case indk::System::ComputeBackends::Multithread:
+            if (Parameter < 2) Parameter = indk_MULTITHREAD_DEFAULT_NUM;
+            this -> Backend = new indk::ComputeBackendMultithread(Parameter);
+            break;
+        case indk::System::ComputeBackends::OpenCL:
+#ifdef INDK_OPENCL_SUPPORT
+            this -> Backend = new indk::ComputeBackendOpenCL();
+            Parameter = 1;
+            break;
+#else
+            std::cerr << std::endl;
+            std::cerr << "The OpenCL compute backend is not supported by the current build. Rebuild interfernce library with the INDK_OPENCL_SUPPORT=ON flag." << std::endl;
+#endif
+            // fall through
+        default:
+            Backend = indk::System::ComputeBackends::Default;
+            this -> Backend = new indk::ComputeBackendDefault();
+            Parameter = 1;
+    }
+    BackendKind = Backend;
+    BackendParameter = Parameter;
+}
+
+/**
+ * Get runtime lock. Neural nets hold the lock during the transfer if the backend needs synchronization.
+ * @return Mutex object.
+ */
+std::mutex& indk::Runtime::getLock() {
+    return Lock;
+}
+
+indk::Computer* indk::Runtime::getComputeBackend() const {
+    return Backend;
+}
+
+int indk::Runtime::getComputeBackendKind() const {
+    return BackendKind;
+}
+
+int indk::Runtime::getComputeBackendParameter() const {
+    return BackendParameter;
+}
+
+bool indk::Runtime::isSynchronizationNeeded() const {
+    return BackendKind != indk::System::ComputeBackends::Default;
+}
+
+indk::Runtime::~Runtime() {
+    delete Backend;
+}
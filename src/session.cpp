@@ -0,0 +1,149 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        session.cpp
+// Purpose:     Streaming session class
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <indk/session.h>
+
+/**
+ * Start streaming session. The neural net is prepared, so the session starts from the tick 0.
+ * @param NN Neural net object.
+ * @param Learning Learning mode of the session, recognition by default.
+ * @param inputs Entries used for the signal transfer (all entries by default).
+ * @param _Capacity Maximal count of ready frames kept until they are pulled.
+ */
+indk::Session::Session(indk::NeuralNet *NN, bool Learning, const std::vector<std::string>& inputs, uint64_t _Capacity) {
+    Net = NN;
+    Inputs = inputs;
+    Capacity = _Capacity ? _Capacity : 1;
+    Columns = 0;
+    Time = 0;
+    ReadyFirst = 0;
+    ReadyCount = 0;
+    Dropped = 0;
+
+    Net -> setLearned(!Learning);
+    Net -> doPrepare();
+
+    OutputsCount = Net -> getOutputsCount();
+    MaxLatency = 0;
+    for (uint64_t o = 0; o < OutputsCount; o++) {
+        Latencies.push_back(std::max(Net->getOutputLatency(o), 0));
+        MaxLatency = std::max(MaxLatency, Latencies.back());
+    }
+    History.assign((MaxLatency+1)*OutputsCount, 0);
+    Ready.assign(Capacity*OutputsCount, 0);
+    ReadyFrames.assign(Capacity, 0);
+    Frame.assign(OutputsCount, 0);
+}
+
+/**
+ * Read outputs of the computed tick and complete the frame that becomes ready.
+ * @param tick Computed tick.
+ */
+void indk::Session::doCollect(int64_t tick) {
+    auto H = MaxLatency + 1;
+    Net -> doSignalReceive(History.data()+(tick%H)*OutputsCount, tick);
+
+    auto frame = tick - MaxLatency;
+    if (frame < 0) return;
+    for (uint64_t o = 0; o < OutputsCount; o++) {
+        Frame[o] = History[((frame+Latencies[o])%H)*OutputsCount+o];
+    }
+
+    if (Callback) {
+        Callback(frame, Frame.data());
+        return;
+    }
+    if (ReadyCount == Capacity) {
+        ReadyFirst = (ReadyFirst+1) % Capacity;
+        ReadyCount--;
+        Dropped++;
+    }
+    auto slot = (ReadyFirst+ReadyCount) % Capacity;
+    std::copy(Frame.begin(), Frame.end(), Ready.begin()+slot*OutputsCount);
+    ReadyFrames[slot] = frame;
+    ReadyCount++;
+}
+
+/**
+ * Push input frames to the neural net.
+ * @param X Input signals matrix, one row per frame.
+ */
+void indk::Session::doPush(const indk::SignalMatrix& X) {
+    if (X.isEmpty()) return;
+    Columns = X.getColumnsCount();
+
+    // the default backend keeps only the last tick in the signal buffers
+    uint64_t chunk = Net->getRuntime()->getComputeBackendKind() == indk::System::ComputeBackends::Default ? 1 : indk_SIGNAL_WINDOW;
+    for (uint64_t r = 0; r < X.getRowsCount(); r += chunk) {
+        auto rows = X.getRows(r, chunk);
+        Net -> doSignalSend(rows, Inputs);
+        for (uint64_t i = 0; i < rows.getRowsCount(); i++) doCollect(Time++);
+    }
+}
+
+/**
+ * Push one input frame to the neural net.
+ * @param X Input signals of the frame.
+ */
+void indk::Session::doPush(const std::vector<float>& X) {
+    doPush(indk::SignalMatrix(X.data(), 1, X.size()));
+}
+
+/**
+ * Get the oldest ready output frame.
+ * @param FrameID Index of the input frame the outputs belong to.
+ * @param Y Output buffer, at least getOutputsCount() elements, signals are placed by output ID.
+ * @return False if there are no ready frames.
+ */
+bool indk::Session::doPull(int64_t &FrameID, float *Y) {
+    if (!ReadyCount) return false;
+    FrameID = ReadyFrames[ReadyFirst];
+    std::copy(Ready.begin()+ReadyFirst*OutputsCount, Ready.begin()+(ReadyFirst+1)*OutputsCount, Y);
+    ReadyFirst = (ReadyFirst+1) % Capacity;
+    ReadyCount--;
+    return true;
+}
+
+/**
+ * Complete the frames that wait for the outputs of the neurons with latency by pushing zero frames.
+ */
+void indk::Session::doFlush() {
+    if (!MaxLatency || !Columns) return;
+    std::vector<float> zeros(MaxLatency*Columns, 0);
+    doPush(indk::SignalMatrix(zeros.data(), MaxLatency, Columns));
+}
+
+/**
+ * Set callback for the ready frames. Frames are passed to the callback instead of the queue.
+ * @param _Callback Callback function, the buffer is valid only during the call.
+ */
+void indk::Session::setCallback(const FrameCallback& _Callback) {
+    Callback = _Callback;
+}
+
+uint64_t indk::Session::getReadyCount() const {
+    return ReadyCount;
+}
+
+uint64_t indk::Session::getDroppedCount() const {
+    return Dropped;
+}
+
+uint64_t indk::Session::getOutputsCount() const {
+    return OutputsCount;
+}
+
+/**
+ * Get count of the pushed frames.
+ * @return Current tick of the session.
+ */
+int64_t indk::Session::getTime() const {
+    return Time;
+}
@@ -0,0 +1,82 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        signal.cpp
+// Purpose:     Input signal matrix view class
+// Author:      Nickolay Babbysh
+// Created:     17.10.26
+// Copyright:   (c) NickWare Group
+// Licence:     MIT licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include <indk/signal.h>
+
+indk::SignalMatrix::SignalMatrix() {
+    Data = nullptr;
+    Rows = 0;
+    Columns = 0;
+    Stride = 0;
+}
+
+/**
+ * Create view over the row-major matrix.
+ * @param _Data Pointer to the first signal of the first row.
+ * @param _Rows Rows (ticks) count.
+ * @param _Columns Columns (inputs) count.
+ * @param _Stride Distance between the rows in floats, 0 - rows are packed (stride is equal to the columns count).
+ */
+indk::SignalMatrix::SignalMatrix(const float *_Data, uint64_t _Rows, uint64_t _Columns, uint64_t _Stride) {
+    Data = _Data;
+    Rows = _Rows;
+    Columns = _Columns;
+    Stride = _Stride ? _Stride : _Columns;
+}
+
+/**
+ * Create view over the nested vectors. Only row pointers are collected, signals are not copied.
+ * @param X Input signals, one vector per tick.
+ */
+indk::SignalMatrix::SignalMatrix(const std::vector<std::vector<float>>& X) {
+    Data = nullptr;
+    Rows = X.size();
+    Columns = X.empty() ? 0 : X[0].size();
+    Stride = 0;
+    RowTable.reserve(X.size());
+    for (const auto &row: X) RowTable.push_back(row.data());
+}
+
+/**
+ * Get view over the rows of the matrix.
+ * @param First First row.
+ * @param Count Count of rows.
+ * @return Signal matrix view.
+ */
+indk::SignalMatrix indk::SignalMatrix::getRows(uint64_t First, uint64_t Count) const {
+    if (First >= Rows) return {};
+    if (Count > Rows-First) Count = Rows-First;
+    if (RowTable.empty()) return {Data+First*Stride, Count, Columns, Stride};
+
+    indk::SignalMatrix view;
+    view.Rows = Count;
+    view.Columns = Columns;
+    view.RowTable.assign(RowTable.begin()+First, RowTable.begin()+First+Count);
+    return view;
+}
+
+const float* indk::SignalMatrix::getRow(uint64_t Row) const {
+    return RowTable.empty() ? Data+Row*Stride : RowTable[Row];
+}
+
+uint64_t indk::SignalMatrix::getRowsCount() const {
+    return Rows;
+}
+
+uint64_t indk::SignalMatrix::getColumnsCount() const {
+    return Columns;
+}
+
+uint64_t indk::SignalMatrix::getStride() const {
+    return Stride;
+}
+
+bool indk::SignalMatrix::isEmpty() const {
+    return !Rows;
+}
@@ -8,55 +8,40 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <indk/system.h>
-#include <indk/backends/default.h>
-#include <indk/backends/multithread.h>
-#include <indk/backends/opencl.h>
+#include <indk/kernel.h>
+#include <atomic>
 
-int CurrentComputeBackend = -1, VerbosityLevel = 1;
-int ComputeBackendParameter = 0;
-bool SynchronizationNeeded;
-indk::Computer *ComputeBackend;
+int VerbosityLevel = 1;
+std::shared_ptr<indk::Runtime> GlobalRuntime;
+std::mutex GlobalRuntimeLock;
+std::shared_ptr<indk::Executor> AsyncExecutor;
+std::mutex AsyncExecutorLock;
+std::atomic<unsigned int> StructureThreads(0);
 
 void indk::System::setComputeBackend(int Backend, int Parameter) {
-    if (CurrentComputeBackend != -1) delete ComputeBackend;
-    CurrentComputeBackend = Backend;
-
-    switch (CurrentComputeBackend) {
-        case indk::System::ComputeBackends::Default:
-            SynchronizationNeeded = false;
-            ComputeBackend = new indk::ComputeBackendDefault();
-            Parameter = 1;
-            break;
-        case indk::System::ComputeBackends::Multithread:
-            SynchronizationNeeded = true;
-            ComputeBackend = new indk::ComputeBackendMultithread(Parameter>1?Parameter:indk_MULTITHREAD_DEFAULT_NUM);
-            break;
-        case indk::System::ComputeBackends::OpenCL:
-#ifdef INDK_OPENCL_SUPPORT
-            SynchronizationNeeded = true;
-            ComputeBackend = new indk::ComputeBackendOpenCL();
-            Parameter = 1;
-            break;
-#else
-            std::cerr << std::endl;
-            std::cerr << "The OpenCL compute backend is not supported by the current build. Rebuild interfernce library with the INDK_OPENCL_SUPPORT=ON flag." << std::endl;
-            CurrentComputeBackend = -1;
-            return;
-#endif
-    }
-    ComputeBackendParameter = Parameter;
+    auto runtime = std::make_shared<indk::Runtime>(Backend, Parameter);
+    if (runtime->getComputeBackendKind() != Backend) return;
+
+    std::lock_guard<std::mutex> lk(GlobalRuntimeLock);
+    GlobalRuntime.swap(runtime);
+}
+
+std::shared_ptr<indk::Runtime> indk::System::getRuntime() {
+    std::lock_guard<std::mutex> lk(GlobalRuntimeLock);
+    if (!GlobalRuntime) GlobalRuntime = std::make_shared<indk::Runtime>(indk::System::ComputeBackends::Default);
+    return GlobalRuntime;
 }
 
 indk::Computer* indk::System::getComputeBackend() {
-    return ComputeBackend;
+    return getRuntime()->getComputeBackend();
 }
 
 int indk::System::getComputeBackendKind() {
-    return CurrentComputeBackend;
+    return getRuntime()->getComputeBackendKind();
 }
 
 bool indk::System::isSynchronizationNeeded() {
-    return SynchronizationNeeded;
+    return getRuntime()->isSynchronizationNeeded();
 }
 
 void indk::System::setVerbosityLevel(int VL) {
@@ -68,7 +53,40 @@ int indk::System::getVerbosityLevel() {
 }
 
 int indk::System::getComputeBackendParameter() {
-    return ComputeBackendParameter;
+    return getRuntime()->getComputeBackendParameter();
+}
+
+void indk::System::setInstructionSet(int InstructionSet) {
+    indk::Kernel::setInstructionSet(InstructionSet);
+}
+
+int indk::System::getInstructionSet() {
+    return indk::Kernel::getInstructionSet();
+}
+
+void indk::System::setReceptorParallelism(unsigned int Threads, uint64_t Threshold) {
+    indk::Kernel::setReceptorParallelism(Threads, Threshold);
+}
+
+void indk::System::setStructureThreads(unsigned int Threads) {
+    StructureThreads = Threads;
+}
+
+unsigned int indk::System::getStructureThreads() {
+    return StructureThreads;
+}
+
+void indk::System::setAsyncExecutor(unsigned int Threads, unsigned int QueueDepth) {
+    std::shared_ptr<indk::Executor> previous;
+    std::lock_guard<std::mutex> lk(AsyncExecutorLock);
+    previous = AsyncExecutor;
+    AsyncExecutor = std::make_shared<indk::Executor>(Threads, QueueDepth);
+}
+
+std::shared_ptr<indk::Executor> indk::System::getAsyncExecutor() {
+    std::lock_guard<std::mutex> lk(AsyncExecutorLock);
+    if (!AsyncExecutor) AsyncExecutor = std::make_shared<indk::Executor>(0, indk_ASYNC_QUEUE_DEPTH);
+    return AsyncExecutor;
 }
 
 bool indk::Event::doWaitTimed(int T) {